@@ -46,6 +46,14 @@ set_property(
         user_data_device_C
 )
 
+# Set defaults for common variables
+set(KernelHaveFPU OFF)
+set(KernelSetTLSBaseSelf OFF)
+
+include(src/arch/${KernelArch}/config.cmake)
+include(include/${KernelWordSize}/mode/config.cmake)
+include(src/config.cmake)
+
 # These options are now set in seL4Config.cmake
 if(DEFINED CALLED_declare_default_headers)
     # calculate the irq cnode size based on MAX_NUM_IRQ
@@ -64,6 +72,10 @@ if(DEFINED CALLED_declare_default_headers)
         else()
             set(MAX_NUM_IRQ "${CONFIGURE_MAX_IRQ}")
         endif()
+        if(KernelArmGicV3ITS)
+            # LPIs are numbered after the platform's last SPI, see gic_common.h
+            math(EXPR MAX_NUM_IRQ "${MAX_NUM_IRQ} + ${KernelArmGicV3ITSNumLPIs}")
+        endif()
     endif()
     set(BITS "0")
     while(MAX_NUM_IRQ GREATER "0")
@@ -84,14 +96,6 @@ if(DEFINED CALLED_declare_default_headers)
     include_directories(include/plat/default)
 endif()
 
-# Set defaults for common variables
-set(KernelHaveFPU OFF)
-set(KernelSetTLSBaseSelf OFF)
-
-include(src/arch/${KernelArch}/config.cmake)
-include(include/${KernelWordSize}/mode/config.cmake)
-include(src/config.cmake)
-
 set(KernelCustomDTS "" CACHE FILEPATH "Provide a device tree file to use instead of the \
 KernelPlatform's defaults")
 
@@ -235,6 +239,17 @@ config_string(
     UNQUOTE
 )
 
+config_option(
+    KernelRootserverLargePages ROOTSERVER_LARGE_PAGES
+    "Map the parts of the initial thread's image that are aligned to a large page with \
+    large pages instead of 4K pages, and do not allocate page tables for them. This \
+    requires the image to be loaded at a physical address with the same large page \
+    alignment as its virtual address. The userImageFrames region of the boot info then \
+    contains caps of both sizes."
+    DEFAULT OFF
+    DEPENDS "KernelSel4ArchAarch64 OR KernelSel4ArchX86_64 OR KernelSel4ArchRiscV64"
+)
+
 config_string(
     KernelTimerTickMS TIMER_TICK_MS "Timer tick period in milliseconds"
     DEFAULT 2
@@ -300,6 +315,44 @@ config_option(
     DEFAULT_DISABLED OFF
 )
 
+config_option(
+    KernelCSpaceLookupCache CSPACE_LOOKUP_CACHE
+    "Cache the slots that recently resolved capability pointers refer to in a small \
+    per-thread table kept in the unused part of the TCB object. The cache is consulted \
+    by lookupSlot and the IPC fastpath before walking the CSpace, and all caches are \
+    invalidated whenever a CNode capability is created, moved or removed."
+    DEFAULT OFF
+    DEPENDS "NOT KernelVerificationBuild"
+)
+
+config_string(
+    KernelCSpaceLookupCacheBits CSPACE_LOOKUP_CACHE_BITS
+    "Log2 of the number of entries in each thread's CSpace lookup cache."
+    DEFAULT 2
+    DEPENDS "KernelCSpaceLookupCache" UNDEF_DISABLED
+    UNQUOTE
+)
+
+config_option(
+    KernelFastMRCopy FAST_MR_COPY
+    "Copy the out-of-line message registers of long IPC messages between IPC buffers \
+    with an architecture specific block copy (rep movs on x86, an unrolled word copy \
+    elsewhere) instead of one word at a time."
+    DEFAULT OFF
+    DEPENDS "NOT KernelVerificationBuild"
+)
+
+config_option(
+    KernelIPCFrameGrant IPC_FRAME_GRANT
+    "Allow a thread to register a grant window with seL4_TCB_SetGrantWindow. A frame cap \
+    sent to the thread over an endpoint is then mapped at the window instead of being \
+    placed in the thread's receive slot, and the mapping is removed when the thread \
+    replies, is sent another frame, or changes its window. This gives zero-copy request/response transfers without the receiver \
+    mapping and unmapping each frame itself."
+    DEFAULT OFF
+    DEPENDS "NOT KernelVerificationBuild; NOT KernelSel4ArchAarch32"
+)
+
 find_file(
     KernelDomainSchedule default_domain.c
     PATHS src/config
@@ -352,6 +405,57 @@ config_string(
     UNQUOTE
 )
 
+config_option(
+    KernelFPUSwitchPolicy FPU_SWITCH_POLICY
+    "Allow the FPU switching policy to be selected per thread with seL4_TCB_SetFPUPolicy.\
+    Threads default to the lazy policy, where the FPU state is only switched in after the\
+    thread faults on its first FPU access. The eager policy switches the state in whenever\
+    the thread is restored, avoiding the fault for threads that use the FPU on nearly every\
+    time slice. The adaptive policy switches to eager loading once a thread has faulted\
+    KernelFPUAdaptiveThreshold times, and periodically falls back to lazy switching to\
+    detect when the thread stops using the FPU."
+    DEFAULT OFF
+    DEPENDS "KernelHaveFPU; NOT KernelVerificationBuild"
+)
+
+config_string(
+    KernelFPUAdaptiveThreshold FPU_ADAPTIVE_THRESHOLD
+    "Number of FPU faults after which a thread with the adaptive FPU policy has its FPU\
+    state loaded eagerly. Must be between 1 and 255."
+    DEFAULT 5
+    DEPENDS "KernelFPUSwitchPolicy" UNDEF_DISABLED
+    UNQUOTE
+)
+
+config_option(
+    KernelIRQBatching IRQ_BATCHING
+    "After handling an interrupt, poll the interrupt controller for further pending\
+    interrupts and handle them in the same kernel entry, up to KernelIRQBatchBudget\
+    interrupts per entry. This saves a kernel exit and entry for every interrupt that\
+    arrives while another one is being handled. On SMP, only an entry that holds the\
+    kernel lock polls, and it stops at a pending remote call IPI."
+    DEFAULT OFF
+    DEPENDS "NOT KernelVerificationBuild"
+)
+
+config_option(
+    KernelIRQAckMany IRQ_ACK_MANY
+    "Add the seL4_IRQHandler_AckMany invocation, which acknowledges the IRQ of the invoked \
+    handler together with the IRQs of the handler caps in a window of CNode slots in one \
+    system call."
+    DEFAULT OFF
+    DEPENDS "NOT KernelVerificationBuild"
+)
+
+config_string(
+    KernelIRQBatchBudget IRQ_BATCH_BUDGET
+    "Maximum number of interrupts handled in one kernel entry when KernelIRQBatching is\
+    enabled. Bounds the time the kernel spends with interrupts disabled."
+    DEFAULT 8
+    DEPENDS "KernelIRQBatching" UNDEF_DISABLED
+    UNQUOTE
+)
+
 config_option(
     KernelVerificationBuild VERIFICATION_BUILD
     "When enabled this configuration option prevents the usage of any other options that\
@@ -442,6 +546,17 @@ config_string(
     UNQUOTE
 )
 
+config_option(
+    KernelVCPUExitStats VCPU_EXIT_STATS
+    "Count the VM exits of every VCPU by exit reason and keep a histogram of the \
+    time from each exit until the guest is resumed. The statistics are read with the \
+    GetExitStats VCPU invocation. With track_kernel_entries the exit reason is also \
+    recorded in the kernel entry log. This makes VCPU objects larger."
+    DEFAULT OFF
+    DEPENDS "KernelVTX OR KernelArmHypervisorSupport;NOT KernelVerificationBuild"
+    DEFAULT_DISABLED OFF
+)
+
 config_option(
     KernelIRQReporting IRQ_REPORTING
     "seL4 does not properly check for and handle spurious interrupts. This can result \
@@ -546,6 +661,44 @@ config_string(
     DEPENDS "KernelIsMCS" UNDEF_DISABLED
 )
 
+config_option(
+    KernelSchedContextGroups SCHED_CONTEXT_GROUPS
+    "Allow scheduling contexts to be placed in a group, whose scheduling context \
+    caps the total time consumed by its members. Members may only run while both \
+    their own and the group's budget is available, and the time they consume is \
+    charged to both. This increases the size of scheduling context objects."
+    DEFAULT OFF
+    DEPENDS "KernelIsMCS; NOT KernelVerificationBuild"
+)
+
+config_option(
+    KernelSchedEDF SCHED_EDF
+    "Schedule the threads at priority KernelEDFPriority by earliest deadline first \
+    instead of round robin. The deadline of a thread is fixed when a refill of its \
+    scheduling context is released, as the release time of the head refill plus the \
+    period, or the end of the remaining budget for round robin scheduling contexts. \
+    It is kept until the next release and moves with the scheduling context when it \
+    is donated. All other priorities are scheduled as before."
+    DEFAULT OFF
+    DEPENDS "KernelIsMCS; NOT KernelVerificationBuild"
+)
+config_string(
+    KernelEDFPriority EDF_PRIORITY
+    "Priority whose threads are scheduled by earliest deadline first. It must be \
+    greater than 0 and less than the highest priority."
+    DEFAULT 128
+    UNQUOTE
+    DEPENDS "KernelSchedEDF" UNDEF_DISABLED
+)
+config_string(
+    KernelEDFMaxThreads EDF_MAX_THREADS
+    "Maximum number of threads at the EDF priority. Every core keeps a deadline \
+    ordered heap of this many threads for each domain."
+    DEFAULT 64
+    UNQUOTE
+    DEPENDS "KernelSchedEDF" UNDEF_DISABLED
+)
+
 config_option(
     KernelClz32 CLZ_32 "Define a __clzsi2 function to count leading zeros for uint32_t arguments. \
                         Only needed on platforms which lack a builtin instruction."
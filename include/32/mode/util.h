@@ -39,3 +39,31 @@ static inline CONST uint64_t div64(uint64_t numerator, uint32_t denominator)
     return quotient;
 }
 
+static inline CONST uint64_t udiv64(uint64_t numerator, uint64_t denominator)
+{
+    uint64_t quotient = 0llu;
+
+    if (unlikely(denominator > numerator)) {
+        return 0;
+    }
+
+    assert(numerator > 0);
+    assert(denominator > 0);
+
+    /* align denominator to numerator */
+    uint64_t c = (uint64_t) clzll(denominator) - clzll(numerator);
+    denominator = denominator << c;
+
+    /* perform binary long division */
+    while (c < UINT64_MAX) {
+        if (numerator >= denominator) {
+            numerator -= denominator;
+            quotient |= (1llu << c);
+        }
+        c--;
+        denominator = denominator >> 1llu;
+    }
+
+    return quotient;
+}
+
@@ -15,3 +15,8 @@ static inline CONST uint64_t div64(uint64_t numerator, uint32_t denominator)
     return numerator / denominator;
 }
 
+static inline CONST uint64_t udiv64(uint64_t numerator, uint64_t denominator)
+{
+    return numerator / denominator;
+}
+
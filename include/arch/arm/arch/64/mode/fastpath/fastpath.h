@@ -35,6 +35,9 @@ switchToThread_fp(tcb_t *thread, vspace_root_t *vroot, pde_t stored_hw_asid)
     if (config_set(CONFIG_ARM_HYPERVISOR_SUPPORT)) {
         vcpu_switch(thread->tcbArch.tcbVCPU);
     }
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+    ARCH_NODE_STATE(armHSActiveASID) = cap_vtable_root_get_mappedASID(TCB_PTR_CTE_PTR(thread, tcbVTable)->cap);
+#endif
     asid = (asid_t)(stored_hw_asid.words[0] & 0xffff);
     armv_contextSwitch_HWASID(vroot, asid);
 
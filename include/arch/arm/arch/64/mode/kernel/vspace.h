@@ -10,6 +10,7 @@
 #include <types.h>
 #include <api/failures.h>
 #include <object/structures.h>
+#include <mode/model/statedata.h>
 
 #define MODE_RESERVED 0
 
@@ -31,9 +32,24 @@ void deleteASID(asid_t asid, vspace_root_t *vspace);
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
 hw_asid_t getHWASID(asid_t asid);
 #endif
+#ifdef CONFIG_ARM_DIRTY_LOG
+bool_t handleDirtyLogFault(tcb_t *thread, vptr_t ipa, word_t esr);
+#endif
+#if defined(CONFIG_ARM_CONTIGUOUS_HINT) && defined(ENABLE_SMP_SUPPORT)
+bool_t handleContiguousHintFault(tcb_t *thread, vptr_t addr, word_t fsr);
+#endif
 
 asid_map_t findMapForASID(asid_t asid);
 
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+/* Whether the VMID stored in an ASID map entry is from the current generation */
+static inline bool_t isStoredVMIDValid(asid_map_t asid_map)
+{
+    return asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map) &&
+           asid_map_asid_map_vspace_get_stored_vmid_generation(asid_map) == armKSHWASIDGeneration;
+}
+#endif
+
 #ifdef __clang__
 static const region_t BOOT_RODATA mode_reserved_region[] = {};
 #else
@@ -75,11 +91,15 @@ static inline exception_t performASIDPoolInvocation(asid_t asid, asid_pool_t *po
 #ifdef CONFIG_ARM_SMMU
                               /* bind_cb: Number of bound context banks */
                               0,
+#endif
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+                              /* stored_hw_vmid: Assigned hardware VMID for TLB. */
+                              0,
 #endif
                               /* vspace_root: reference to vspace root page table object */
                               cap_page_upper_directory_cap_get_capPUDBasePtr(cte->cap)
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
-                              /* stored_hw_vmid, stored_vmid_valid: Assigned hardware VMID for TLB. */
+                              /* stored_vmid_generation, stored_vmid_valid: VMID generation of stored_hw_vmid. */
                               , 0, false
 #endif
                           );
@@ -121,11 +141,15 @@ static inline exception_t performASIDPoolInvocation(asid_t asid, asid_pool_t *po
 #ifdef CONFIG_ARM_SMMU
                               /* bind_cb: Number of bound context banks */
                               0,
+#endif
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+                              /* stored_hw_vmid: Assigned hardware VMID for TLB. */
+                              0,
 #endif
                               /* vspace_root: reference to vspace root page table object */
                               cap_page_global_directory_cap_get_capPGDBasePtr(cte->cap)
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
-                              /* stored_hw_vmid, stored_vmid_valid: Assigned hardware VMID for TLB. */
+                              /* stored_vmid_generation, stored_vmid_valid: VMID generation of stored_hw_vmid. */
                               , 0, false
 #endif
                           );
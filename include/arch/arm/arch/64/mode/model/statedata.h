@@ -30,8 +30,16 @@ extern pte_t armKSGlobalKernelPT[BIT(PT_INDEX_BITS)] VISIBLE;
 
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
 
-extern asid_t armKSHWASIDTable[BIT(hwASIDBits)] VISIBLE;
-extern hw_asid_t armKSNextASID VISIBLE;
+extern word_t armKSNextASID VISIBLE;
+extern word_t armKSHWASIDBits VISIBLE;
+extern word_t armKSHWASIDGeneration VISIBLE;
+#ifdef CONFIG_ARM_DIRTY_LOG
+extern bool_t armKSSWDirtyLog VISIBLE;
+#endif
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+extern timestamp_t benchmark_hw_asid_rollovers;
+extern timestamp_t benchmark_hw_asid_evictions;
+#endif
 #endif
 
 #ifdef CONFIG_KERNEL_LOG_BUFFER
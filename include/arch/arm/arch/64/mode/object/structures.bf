@@ -244,18 +244,26 @@ block asid_map_none {
     field type                      1
 }
 
---- hw_vmids are required in hyp mode
+--- hw_vmids are required in hyp mode. A stored hw_vmid is only in use if it was
+--- allocated in the current VMID generation.
 block asid_map_vspace {
 #ifdef CONFIG_ARM_SMMU
     field bind_cb                   8
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+    field stored_hw_vmid            8
+#else
     padding                         8
+#endif
+#else
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+    field stored_hw_vmid            16
 #else
     padding                         16
+#endif
 #endif
     field_high vspace_root          36
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
-    padding                         2
-    field stored_hw_vmid            8
+    field stored_vmid_generation    10
     field stored_vmid_valid         1
 #else
     padding                         11
@@ -118,6 +118,16 @@ typedef struct asid_pool asid_pool_t;
 #define ASID_LOW(a) (a & MASK(asidLowBits))
 #define ASID_HIGH(a) ((a >> asidLowBits) & MASK(asidHighBits))
 
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+/* Widths of the stored VMID fields of asid_map_vspace */
+#ifdef CONFIG_ARM_SMMU
+#define HW_VMID_BITS_MAX 8
+#else
+#define HW_VMID_BITS_MAX 16
+#endif
+#define HW_VMID_GENERATION_BITS 10
+#endif
+
 static inline word_t CONST cap_get_archCapSizeBits(cap_t cap)
 {
     cap_tag_t ctag;
@@ -48,6 +48,11 @@ static inline void benchmark_arch_utilisation_reset(void)
 #ifdef CONFIG_ARM_ENABLE_PMU_OVERFLOW_INTERRUPT
     NODE_STATE(ccnt_num_overflows) = 0;
 #endif /* CONFIG_ARM_ENABLE_PMU_OVERFLOW_INTERRUPT */
+#if defined(CONFIG_BENCHMARK_TRACK_UTILISATION) && defined(CONFIG_ARCH_AARCH64) && \
+    defined(CONFIG_ARM_HYPERVISOR_SUPPORT)
+    benchmark_hw_asid_rollovers = 0;
+    benchmark_hw_asid_evictions = 0;
+#endif
 }
 #endif /* CONFIG_ENABLE_BENCHMARKS */
 
@@ -15,8 +15,15 @@ static inline void arch_c_entry_hook(void)
     arm_save_thread_id(NODE_STATE(ksCurThread));
 }
 
+#ifdef CONFIG_VCPU_EXIT_STATS
+void recordVCPUResume(void);
+#endif
+
 static inline void arch_c_exit_hook(void)
 {
+#ifdef CONFIG_VCPU_EXIT_STATS
+    recordVCPUResume();
+#endif
     arm_load_thread_id(NODE_STATE(ksCurThread));
 }
 
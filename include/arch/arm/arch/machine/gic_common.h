@@ -61,7 +61,18 @@ irq_t irqInvalid = (uint16_t) -1;
 /* Setters/getters helpers for hardware irqs */
 #define IRQ_REG(IRQ) ((IRQ) >> 5u)
 #define IRQ_BIT(IRQ) ((IRQ) & 0x1f)
+#ifdef CONFIG_ARM_GIC_V3_ITS
+/* Locality-specific Peripheral Interrupts. The hardware INTIDs start at
+ * LPI_START, the kernel numbers them from LPI_IRQ_BASE up so that they
+ * follow the SPIs in the IRQ state table. */
+#define LPI_START         8192u
+#define LPI_IRQ_BASE      (maxIRQ + 1)
+#define HW_IRQ_IS_LPI(irq) ((irq) >= LPI_IRQ_BASE)
+#define IS_IRQ_VALID(X) ((((X) & IRQ_MASK) < SPECIAL_IRQ_START) || (((X) & IRQ_MASK) >= LPI_START))
+#else
+#define HW_IRQ_IS_LPI(irq) false
 #define IS_IRQ_VALID(X) (((X) & IRQ_MASK) < SPECIAL_IRQ_START)
+#endif
 
 /*
  * The only sane way to get an GIC IRQ number that can be properly
@@ -182,6 +182,13 @@ static inline bool_t isIRQPending(void)
     return IS_IRQ_VALID(gic_cpuiface->hi_pend);
 }
 
+#ifdef ENABLE_SMP_SUPPORT
+static inline bool_t isIPIPending(word_t ipi)
+{
+    return (gic_cpuiface->hi_pend & IRQ_MASK) == ipi;
+}
+#endif
+
 static inline void maskInterrupt(bool_t disable, irq_t irq)
 {
 #if defined ENABLE_SMP_SUPPORT && defined CONFIG_ARCH_ARM
@@ -281,6 +288,16 @@ static inline uint32_t get_gic_vcpu_ctrl_eisr1(void)
     return gic_vcpu_ctrl->eisr1;
 }
 
+static inline uint32_t get_gic_vcpu_ctrl_elrsr0(void)
+{
+    return gic_vcpu_ctrl->elsr0;
+}
+
+static inline uint32_t get_gic_vcpu_ctrl_elrsr1(void)
+{
+    return gic_vcpu_ctrl->elsr1;
+}
+
 static inline uint32_t get_gic_vcpu_ctrl_misr(void)
 {
     return gic_vcpu_ctrl->misr;
@@ -39,12 +39,19 @@
 #define GICD_IROUTER_SPI_MODE_ANY    BIT(31)
 
 #define GICD_TYPE_LINESNR 0x01f
+#define GICD_TYPE_LPIS               BIT(17)
+#define GICD_TYPE_IDBITS(t)          ((((t) >> 19) & 0x1f) + 1)
 
 #define GICC_SRE_EL1_SRE             BIT(0)
 
 #define GICR_WAKER_ProcessorSleep    BIT(1)
 #define GICR_WAKER_ChildrenAsleep    BIT(2)
 
+#define GICR_CTLR_ENABLE_LPIS        BIT(0)
+#define GICR_TYPER_PLPIS             BIT(0)
+#define GICR_TYPER_VLPIS             BIT(1)
+#define GICR_TYPER_PROC_NUM(t)       (((t) >> 8) & 0xffff)
+
 #define GICC_CTLR_EL1_EOImode_drop   BIT(1)
 
 #define DEFAULT_PMR_VALUE            0xff
@@ -229,10 +236,69 @@ struct gic_rdist_sgi_ppi_map {  /* Starting */
     uint32_t    nsacr;          /* 0x0E00 */
 };
 
+#ifdef CONFIG_ARM_GIC_V3_ITS
+/* Memory map for the control frame of the Interrupt Translation Service */
+struct gic_its_map {
+    uint32_t    ctlr;           /* 0x0000 */
+    uint32_t    iidr;           /* 0x0004 */
+    uint64_t    typer;          /* 0x0008 */
+    uint32_t    res0[28];       /* 0x0010 */
+    uint64_t    cbaser;         /* 0x0080 */
+    uint64_t    cwriter;        /* 0x0088 */
+    uint64_t    creadr;         /* 0x0090 */
+    uint64_t    res1[13];       /* 0x0098 */
+    uint64_t    baser[8];       /* 0x0100 */
+};
+
+unverified_compile_assert(error_in_gic_its_map,
+                          0x100 == __builtin_offsetof(struct gic_its_map, baser));
+
+extern bool_t gic_its_enabled;
+
+bool_t gic_its_device_available(word_t device_id);
+word_t gic_its_find_lpi(word_t device_id, word_t event_id);
+bool_t gic_its_ready(void);
+void gic_its_map_lpi(word_t lpi, word_t device_id, word_t event_id);
+void gic_its_unmap_lpi(word_t lpi);
+#endif /* CONFIG_ARM_GIC_V3_ITS */
+
+#ifdef CONFIG_ARM_GIC_V4
+/* Memory map for the VLPI frame of a GICv4 redistributor */
+struct gic_rdist_vlpi_map {     /* Starting */
+    uint32_t    res0[28];       /* 0x0000 */
+    uint64_t    vpropbaser;     /* 0x0070 */
+    uint64_t    vpendbaser;     /* 0x0078 */
+};
+
+/* Virtual LPIs use the INTIDs from LPI_START to BIT(GIC_VLPI_ID_BITS) - 1 */
+#define GIC_VLPI_ID_BITS             14
+#define GIC_VPE_NONE                 CONFIG_ARM_GIC_V4_NUM_VPES
+
+extern bool_t gic_vlpi_enabled;
+
+bool_t gic_vpe_available(void);
+word_t gic_vpe_alloc(word_t core);
+void gic_vpe_free(word_t vpe);
+void gic_vpe_load(word_t vpe);
+void gic_vpe_unload(word_t vpe);
+void gic_its_map_vlpi(word_t lpi, word_t vpe, word_t vintid);
+#endif /* CONFIG_ARM_GIC_V4 */
+
 extern volatile struct gic_dist_map *const gic_dist;
 extern volatile struct gic_rdist_map *gic_rdist_map[CONFIG_MAX_NUM_NODES];
 extern volatile struct gic_rdist_sgi_ppi_map *gic_rdist_sgi_ppi_map[CONFIG_MAX_NUM_NODES];
 
+/* Convert an INTID read from ICC_IAR1_EL1 to the kernel's IRQ number */
+static inline word_t gic_intid_to_irq(word_t intid)
+{
+#ifdef CONFIG_ARM_GIC_V3_ITS
+    if (intid >= LPI_START) {
+        return intid - LPI_START + LPI_IRQ_BASE;
+    }
+#endif
+    return intid;
+}
+
 /* Helpers */
 static inline int is_irq_edge_triggered(word_t irq)
 {
@@ -302,7 +368,8 @@ static inline irq_t getActiveIRQ(void)
     }
 
     if (IS_IRQ_VALID(active_irq[CURRENT_CPU_INDEX()])) {
-        irq = CORE_IRQ_TO_IRQT(CURRENT_CPU_INDEX(), active_irq[CURRENT_CPU_INDEX()] & IRQ_MASK);
+        irq = CORE_IRQ_TO_IRQT(CURRENT_CPU_INDEX(),
+                               gic_intid_to_irq(active_irq[CURRENT_CPU_INDEX()] & IRQ_MASK));
     } else {
         irq = irqInvalid;
     }
@@ -325,12 +392,30 @@ static inline bool_t isIRQPending(void)
     return IS_IRQ_VALID(val);
 }
 
+#ifdef ENABLE_SMP_SUPPORT
+/** MODIFIES: phantom_machine_state */
+/** DONT_TRANSLATE */
+static inline bool_t isIPIPending(word_t ipi)
+{
+    uint32_t val = 0;
+    SYSTEM_READ_WORD(ICC_HPPIR1_EL1, val);
+    return (val & IRQ_MASK) == ipi;
+}
+#endif
+
 static inline void maskInterrupt(bool_t disable, irq_t irq)
 {
 #if defined ENABLE_SMP_SUPPORT
     assert(!(IRQ_IS_PPI(irq)) || (IRQT_TO_CORE(irq) == getCurrentCPUIndex()));
 #endif
 
+    /* LPIs are edge-triggered messages. As with MSIs on x86 they are left
+     * enabled while the user handles them, which avoids an ITS command on
+     * every interrupt. */
+    if (HW_IRQ_IS_LPI(IRQT_TO_IRQ(irq))) {
+        return;
+    }
+
     if (disable) {
         gic_enable_clr(IRQT_TO_IRQ(irq));
     } else {
@@ -341,9 +426,10 @@ static inline void maskInterrupt(bool_t disable, irq_t irq)
 static inline void ackInterrupt(irq_t irq)
 {
     word_t hw_irq = IRQT_TO_IRQ(irq);
-    assert(IS_IRQ_VALID(active_irq[CURRENT_CPU_INDEX()]) && (active_irq[CURRENT_CPU_INDEX()] & IRQ_MASK) == hw_irq);
+    assert(IS_IRQ_VALID(active_irq[CURRENT_CPU_INDEX()]) &&
+           gic_intid_to_irq(active_irq[CURRENT_CPU_INDEX()] & IRQ_MASK) == hw_irq);
 
-    if (is_irq_edge_triggered(hw_irq)) {
+    if (!HW_IRQ_IS_LPI(hw_irq) && is_irq_edge_triggered(hw_irq)) {
         gic_pending_clr(hw_irq);
     }
 
@@ -420,6 +506,19 @@ static inline uint32_t get_gic_vcpu_ctrl_eisr1(void)
     return 0;
 }
 
+static inline uint32_t get_gic_vcpu_ctrl_elrsr0(void)
+{
+    uint32_t reg;
+    MRS(ICH_ELRSR_EL2, reg);
+    return reg;
+}
+
+/* As for EISR, a second ELRSR word is never needed on GICv3 */
+static inline uint32_t get_gic_vcpu_ctrl_elrsr1(void)
+{
+    return 0;
+}
+
 static inline uint32_t get_gic_vcpu_ctrl_misr(void)
 {
     uint32_t reg;
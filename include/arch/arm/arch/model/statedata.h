@@ -19,9 +19,16 @@ NODE_STATE_DECLARE(word_t, ipiReschedulePending);
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
 NODE_STATE_DECLARE(vcpu_t, *armHSCurVCPU);
 NODE_STATE_DECLARE(bool_t, armHSVCPUActive);
+NODE_STATE_DECLARE(uint64_t, armHSVGICLRsInUse);
 #if defined(CONFIG_ARCH_AARCH32) && defined(CONFIG_HAVE_FPU)
 NODE_STATE_DECLARE(bool_t, armHSFPUEnabled);
 #endif
+#ifdef CONFIG_ARCH_AARCH64
+/* The ASID whose VMID was last loaded on this core */
+NODE_STATE_DECLARE(asid_t, armHSActiveASID);
+/* The ASID that kept its VMID at the last VMID rollover */
+NODE_STATE_DECLARE(asid_t, armHSReservedASID);
+#endif
 #endif
 #if defined(CONFIG_BENCHMARK_TRACK_UTILISATION) && defined(KERNEL_PMU_IRQ)
 NODE_STATE_DECLARE(uint64_t, ccnt_num_overflows);
@@ -63,3 +63,11 @@ static inline exception_t Arch_checkIRQ(word_t irq_w)
     return EXCEPTION_NONE;
 }
 
+#ifdef CONFIG_ARM_GIC_V3_ITS
+void Arch_deletedIRQHandler(irq_t irq);
+#else
+static inline void Arch_deletedIRQHandler(irq_t irq)
+{
+}
+#endif
+
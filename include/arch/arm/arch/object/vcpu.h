@@ -12,6 +12,7 @@
 
 #include <api/failures.h>
 #include <linker.h>
+#include <object/vcpuexitstats.h>
 
 #define HCR_RW       BIT(31)     /* Execution state control        */
 #define HCR_TRVM     BIT(30)     /* trap reads of VM controls      */
@@ -47,12 +48,21 @@
 #define HCR_SWIO     BIT( 1)     /* set/way invalidate override    */
 #define HCR_VM       BIT( 0)     /* Virtualization MMU enable      */
 
+#ifdef CONFIG_VCPU_EXIT_STATS
+/* Exception classes in HSR/ESR_EL2 that the VM exit statistics use */
+#define HSR_EC_SHIFT    26
+#define HSR_EC_IABT_LOW 0x20        /* Instruction abort from the guest */
+#define HSR_EC_DABT_LOW 0x24        /* Data abort from the guest        */
+#endif
+
 
 struct gicVCpuIface {
     uint32_t hcr;
     uint32_t vmcr;
     uint32_t apr;
     virq_t lr[GIC_VCPU_MAX_NUM_LR];
+    /* List registers that are not empty. The others are not saved or restored. */
+    uint64_t lr_used;
 };
 
 #ifdef CONFIG_VTIMER_UPDATE_VOFFSET
@@ -82,6 +92,13 @@ struct vcpu {
     word_t vcpu_padding;
     struct vTimer virtTimer;
 #endif
+#ifdef CONFIG_ARM_GIC_V4
+    /* vPE that vLPIs are delivered to, or GIC_VPE_NONE */
+    word_t vpe;
+#endif
+#ifdef CONFIG_VCPU_EXIT_STATS
+    vcpu_exit_stats_t exit_stats;
+#endif
 };
 typedef struct vcpu vcpu_t;
 compile_assert(vcpu_size_correct, sizeof(struct vcpu) <= BIT(VCPU_SIZE_BITS))
@@ -89,6 +106,9 @@ compile_assert(vcpu_size_correct, sizeof(struct vcpu) <= BIT(VCPU_SIZE_BITS))
 void VGICMaintenance(void);
 void handleVCPUFault(word_t hsr);
 void VPPIEvent(irq_t irq);
+#ifdef CONFIG_VCPU_EXIT_STATS
+void recordVCPUExit(word_t reason);
+#endif
 
 void vcpu_init(vcpu_t *vcpu);
 
@@ -120,15 +140,31 @@ void handleVCPUInjectInterruptIPI(vcpu_t *vcpu, unsigned long index, virq_t virq
 
 exception_t decodeVCPUWriteReg(cap_t cap, unsigned int length, word_t *buffer);
 exception_t decodeVCPUReadReg(cap_t cap, unsigned int length, bool_t call, word_t *buffer);
+exception_t decodeVCPUWriteRegsBatch(cap_t cap, unsigned int length, word_t *buffer);
+exception_t decodeVCPUReadRegsBatch(cap_t cap, unsigned int length, bool_t call, word_t *buffer);
 exception_t decodeVCPUInjectIRQ(cap_t cap, unsigned int length, word_t *buffer);
 exception_t decodeVCPUSetTCB(cap_t cap);
 exception_t decodeVCPUAckVPPI(cap_t cap, unsigned int length, word_t *buffer);
+#ifdef CONFIG_ARM_GIC_V4
+exception_t decodeVCPUBindVLPI(cap_t cap, unsigned int length, word_t *buffer);
+#endif
+#ifdef CONFIG_VCPU_EXIT_STATS
+exception_t decodeVCPUGetExitStats(cap_t cap, unsigned int length, bool_t call, word_t *buffer);
+#endif
 
 exception_t invokeVCPUWriteReg(vcpu_t *vcpu, word_t field, word_t value);
 exception_t invokeVCPUReadReg(vcpu_t *vcpu, word_t field, bool_t call);
+exception_t invokeVCPUWriteRegsBatch(vcpu_t *vcpu, word_t count, word_t *fields, word_t *buffer);
+exception_t invokeVCPUReadRegsBatch(vcpu_t *vcpu, word_t count, word_t *fields, bool_t call);
 exception_t invokeVCPUInjectIRQ(vcpu_t *vcpu, unsigned long index, virq_t virq);
 exception_t invokeVCPUSetTCB(vcpu_t *vcpu, tcb_t *tcb);
 exception_t invokeVCPUAckVPPI(vcpu_t *vcpu, VPPIEventIRQ_t vppi);
+#ifdef CONFIG_ARM_GIC_V4
+exception_t invokeVCPUBindVLPI(vcpu_t *vcpu, word_t lpi, word_t vintid);
+#endif
+#ifdef CONFIG_VCPU_EXIT_STATS
+exception_t invokeVCPUGetExitStats(vcpu_t *vcpu, word_t reason, bool_t call);
+#endif
 static word_t vcpu_hw_read_reg(word_t reg_index);
 static void vcpu_hw_write_reg(word_t reg_index, word_t reg);
 
@@ -23,12 +23,17 @@ typedef word_t node_id_t;
 typedef word_t cpu_id_t;
 typedef word_t dom_t;
 
+#ifdef CONFIG_ARCH_AARCH64
+/* AArch64 ASIDs and VMIDs may be 16 bits wide */
+typedef uint16_t hw_asid_t;
+#else
 typedef uint8_t  hw_asid_t;
 
 enum hwASIDConstants {
     hwASIDMax = 255,
     hwASIDBits = 8
 };
+#endif
 
 typedef struct kernel_frame {
     paddr_t paddr;
@@ -63,6 +63,9 @@
 #define VTCR_EL2_SH0(x)     (((x) & 0x3) << 12)
 #define VTCR_EL2_TG0(x)     (((x) & 0x3) << 14)
 #define VTCR_EL2_PS(x)      (((x) & 0x7) << 16)
+#define VTCR_EL2_VS         BIT(19)
+#define VTCR_EL2_HA         BIT(21)
+#define VTCR_EL2_HD         BIT(22)
 
 /* Physical address size */
 #define PS_4G               0
@@ -79,6 +82,10 @@
 
 #define ID_AA64MMFR0_EL1_PARANGE(x) ((x) & 0xf)
 #define ID_AA64MMFR0_TGRAN4(x)      (((x) >> 28u) & 0xf)
+#define ID_AA64MMFR1_VMIDBITS(x)    (((x) >> 4u) & 0xf)
+#define VMIDBITS_16                 2
+#define ID_AA64MMFR1_HAFDBS(x)      ((x) & 0xf)
+#define HAFDBS_DIRTY                2
 
 /* Shareability attributes */
 #define SH0_NONE            0
@@ -124,6 +131,7 @@
 #define REG_VTCR_EL2        "vtcr_el2"
 #define REG_VMPIDR_EL2      "vmpidr_el2"
 #define REG_ID_AA64MMFR0_EL1 "id_aa64mmfr0_el1"
+#define REG_ID_AA64MMFR1_EL1 "id_aa64mmfr1_el1"
 
 /* for EL1 SCTLR */
 static inline word_t getSCTLR(void)
@@ -553,6 +561,19 @@ static inline void vcpu_init_vtcr(void)
         fail("Processor does not support 4KB");
     }
 
+    /* Use 16-bit VMIDs where supported. All cores have to agree with the
+     * width picked by the boot core. */
+    word_t vmid_bits = 8;
+    MRS(REG_ID_AA64MMFR1_EL1, val);
+    if (HW_VMID_BITS_MAX == 16 && ID_AA64MMFR1_VMIDBITS(val) == VMIDBITS_16) {
+        vmid_bits = 16;
+    }
+    if (armKSHWASIDBits == 0) {
+        armKSHWASIDBits = vmid_bits;
+    } else if (armKSHWASIDBits > vmid_bits) {
+        fail("Processor does not support 16-bit VMIDs");
+    }
+
     /* Set up the stage-2 translation control register for cores supporting 44-bit PA */
     uint32_t vtcr_el2;
 #ifdef CONFIG_ARM_PA_SIZE_BITS_40
@@ -569,6 +590,16 @@ static inline void vcpu_init_vtcr(void)
     vtcr_el2 |= VTCR_EL2_SH0(SH0_INNER);                     // inner shareable
     vtcr_el2 |= VTCR_EL2_TG0(TG0_4K);                        // 4KiB page size
     vtcr_el2 |= BIT(31);                                     // reserved as 1
+    if (armKSHWASIDBits == 16) {
+        vtcr_el2 |= VTCR_EL2_VS;                             // 16-bit VMID
+    }
+#ifdef CONFIG_ARM_DIRTY_LOG
+    if (ID_AA64MMFR1_HAFDBS(val) >= HAFDBS_DIRTY) {
+        vtcr_el2 |= VTCR_EL2_HA | VTCR_EL2_HD;               // hardware access flag and dirty state
+    } else {
+        armKSSWDirtyLog = true;
+    }
+#endif
 
     MSR(REG_VTCR_EL2, vtcr_el2);
     isb();
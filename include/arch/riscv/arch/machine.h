@@ -91,6 +91,11 @@ static inline void sfence_local(void)
     asm volatile("sfence.vma" ::: "memory");
 }
 
+static inline void sfence_local_vaddr(vptr_t vaddr, asid_t asid)
+{
+    asm volatile("sfence.vma %0, %1" :: "r"(vaddr), "r"(asid) : "memory");
+}
+
 static inline word_t get_sbi_mask_for_all_remote_harts(void)
 {
     word_t mask = 0;
@@ -102,6 +107,19 @@ static inline word_t get_sbi_mask_for_all_remote_harts(void)
     return mask;
 }
 
+/* setVSpaceRoot() flushes the local TLB, so a hart only holds translations
+ * of the ASID it is currently running. */
+static inline word_t get_sbi_mask_for_remote_harts_running_asid(asid_t asid)
+{
+    word_t mask = 0;
+    for (int i = 0; i < CONFIG_MAX_NUM_NODES; i++) {
+        if (i != getCurrentCPUIndex() && ARCH_NODE_STATE_ON_CORE(riscvKSCurrentASID, i) == asid) {
+            mask |= BIT(cpuIndexToID(i));
+        }
+    }
+    return mask;
+}
+
 static inline void ifence(void)
 {
     ifence_local();
@@ -124,9 +142,23 @@ static inline void hwASIDFlushLocal(asid_t asid)
 
 static inline void hwASIDFlush(asid_t asid)
 {
+    fence_w_rw();
     hwASIDFlushLocal(asid);
-    word_t mask = get_sbi_mask_for_all_remote_harts();
-    sbi_remote_sfence_vma_asid(mask, 0, 0, asid);
+    word_t mask = get_sbi_mask_for_remote_harts_running_asid(asid);
+    if (mask) {
+        sbi_remote_sfence_vma_asid(mask, 0, 0, asid);
+    }
+}
+
+/* Flush the leaf translation of a single page or superpage */
+static inline void hwASIDFlushVAddr(asid_t asid, vptr_t vaddr)
+{
+    fence_w_rw();
+    sfence_local_vaddr(vaddr, asid);
+    word_t mask = get_sbi_mask_for_remote_harts_running_asid(asid);
+    if (mask) {
+        sbi_remote_sfence_vma_asid(mask, vaddr, BIT(seL4_PageBits), asid);
+    }
 }
 
 #else
@@ -141,6 +173,11 @@ static inline void hwASIDFlush(asid_t asid)
     asm volatile("sfence.vma x0, %0" :: "r"(asid): "memory");
 }
 
+static inline void hwASIDFlushVAddr(asid_t asid, vptr_t vaddr)
+{
+    asm volatile("sfence.vma %0, %1" :: "r"(vaddr), "r"(asid) : "memory");
+}
+
 #endif /* end of !ENABLE_SMP_SUPPORT */
 
 word_t PURE getRestartPC(tcb_t *thread);
@@ -255,6 +292,7 @@ static inline void setVSpaceRoot(paddr_t addr, asid_t asid)
     /* Order read/write operations */
 #ifdef ENABLE_SMP_SUPPORT
     sfence_local();
+    ARCH_NODE_STATE(riscvKSCurrentASID) = asid;
 #else
     sfence();
 #endif
@@ -20,6 +20,10 @@ NODE_STATE_BEGIN(archNodeState)
 /* TODO: add RISCV-dependent fields here */
 /* Bitmask of all cores should receive the reschedule IPI */
 NODE_STATE_DECLARE(word_t, ipiReschedulePending);
+#ifdef ENABLE_SMP_SUPPORT
+/* ASID loaded into satp, used to limit remote TLB shootdowns */
+NODE_STATE_DECLARE(asid_t, riscvKSCurrentASID);
+#endif
 NODE_STATE_END(archNodeState);
 
 extern asid_pool_t *riscvKSASIDTable[BIT(asidHighBits)];
@@ -21,3 +21,7 @@ exception_t Arch_decodeIRQControlInvocation(word_t invLabel, word_t length,
                                             cte_t *srcSlot, word_t *buffer);
 exception_t Arch_checkIRQ(word_t irq_w);
 
+static inline void Arch_deletedIRQHandler(irq_t irq)
+{
+}
+
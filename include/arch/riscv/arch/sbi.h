@@ -53,24 +53,28 @@
 static inline word_t sbi_call(word_t cmd,
                               word_t arg_0,
                               word_t arg_1,
-                              word_t arg_2)
+                              word_t arg_2,
+                              word_t arg_3)
 {
     register word_t a0 asm("a0") = arg_0;
     register word_t a1 asm("a1") = arg_1;
     register word_t a2 asm("a2") = arg_2;
+    register word_t a3 asm("a3") = arg_3;
     register word_t a7 asm("a7") = cmd;
     register word_t result asm("a0");
     asm volatile("ecall"
                  : "=r"(result)
-                 : "r"(a0), "r"(a1), "r"(a2), "r"(a7)
+                 : "r"(a0), "r"(a1), "r"(a2), "r"(a3), "r"(a7)
                  : "memory");
     return result;
 }
 
 /* Lazy implementations until SBI is finalized */
-#define SBI_CALL_0(which) sbi_call(which, 0, 0, 0)
-#define SBI_CALL_1(which, arg0) sbi_call(which, arg0, 0, 0)
-#define SBI_CALL_2(which, arg0, arg1) sbi_call(which, arg0, arg1, 0)
+#define SBI_CALL_0(which) sbi_call(which, 0, 0, 0, 0)
+#define SBI_CALL_1(which, arg0) sbi_call(which, arg0, 0, 0, 0)
+#define SBI_CALL_2(which, arg0, arg1) sbi_call(which, arg0, arg1, 0, 0)
+#define SBI_CALL_3(which, arg0, arg1, arg2) sbi_call(which, arg0, arg1, arg2, 0)
+#define SBI_CALL_4(which, arg0, arg1, arg2, arg3) sbi_call(which, arg0, arg1, arg2, arg3)
 
 static inline void sbi_console_putchar(int ch)
 {
@@ -135,13 +139,14 @@ static inline void sbi_remote_fence_i(word_t hart_mask)
     SBI_CALL_1(SBI_REMOTE_FENCE_I, virt_addr_hart_mask);
 }
 
+/* A start and size of 0 flush the whole address space */
 static inline void sbi_remote_sfence_vma(word_t hart_mask,
                                          unsigned long start,
                                          unsigned long size)
 {
     /* See comment at sbi_send_ipi() about the pointer parameter. */
     word_t virt_addr_hart_mask = (word_t)&hart_mask;
-    SBI_CALL_1(SBI_REMOTE_SFENCE_VMA, virt_addr_hart_mask);
+    SBI_CALL_3(SBI_REMOTE_SFENCE_VMA, virt_addr_hart_mask, start, size);
 }
 
 static inline void sbi_remote_sfence_vma_asid(word_t hart_mask,
@@ -151,7 +156,7 @@ static inline void sbi_remote_sfence_vma_asid(word_t hart_mask,
 {
     /* See comment at sbi_send_ipi() about the pointer parameter. */
     word_t virt_addr_hart_mask = (word_t)&hart_mask;
-    SBI_CALL_1(SBI_REMOTE_SFENCE_VMA_ASID, virt_addr_hart_mask);
+    SBI_CALL_4(SBI_REMOTE_SFENCE_VMA_ASID, virt_addr_hart_mask, start, size, asid);
 }
 
 #endif /* ENABLE_SMP_SUPPORT */
@@ -472,22 +472,45 @@ block ept_pml4e {
     field        read               1
 }
 
-block ept_pdpte {
+block ept_pdpte_1g {
+    padding                         32
+    field_high   page_base_address  2
+    padding                         18
+    padding                         2
+    field        dirty              1
+    field        accessed           1
+    field        page_size          1
+    field        ignore_pat         1
+    field        type               3
+    field        execute            1
+    field        write              1
+    field        read               1
+}
+
+block ept_pdpte_pd {
     padding                         32
     field_high   pd_base_address    20
     field        avl_cte_depth      3
-    padding                         6
+    padding                         1
+    field        page_size          1
+    padding                         4
     field        execute            1
     field        write              1
     field        read               1
 }
 
+tagged_union ept_pdpte page_size {
+    tag ept_pdpte_pd 0
+    tag ept_pdpte_1g 1
+}
+
 block ept_pde_2m {
     padding                         32
     field_high   page_base_address  12
     padding                         8
     field        avl_cte_depth      2
-    padding                         2
+    field        dirty              1
+    field        accessed           1
     field        page_size          1
     field        ignore_pat         1
     field        type               3
@@ -517,7 +540,9 @@ block ept_pte {
     padding                         32
     field_high   page_base_address  20
     field        avl_cte_depth      2
-    padding                         3
+    field        dirty              1
+    field        accessed           1
+    padding                         1
     field        ignore_pat         1
     field        type               3
     field        execute            1
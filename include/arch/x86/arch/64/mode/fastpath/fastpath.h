@@ -42,6 +42,9 @@ static inline void FORCE_INLINE switchToThread_fp(tcb_t *thread, vspace_root_t *
     cr3_t next_cr3 = makeCR3(new_vroot, asid);
     if (likely(getCurrentUserCR3().words[0] != next_cr3.words[0])) {
         SMP_COND_STATEMENT(tlb_bitmap_set(vroot, getCurrentCPUIndex());)
+#if defined(ENABLE_SMP_SUPPORT) && defined(CONFIG_SUPPORT_PCID)
+        flushStalePCID(asid);
+#endif
         setCurrentUserCR3(next_cr3);
     }
 
@@ -185,6 +185,28 @@ static inline void invalidateLocalPCID(word_t type, void *vaddr, asid_t asid)
     }
 }
 
+#if defined(ENABLE_SMP_SUPPORT) && defined(CONFIG_SUPPORT_PCID)
+static inline asid_t getUserPCIDOnCore(word_t core)
+{
+#ifdef CONFIG_KERNEL_SKIM_WINDOW
+    return MODE_NODE_STATE_ON_CORE(x64KSCurrentUserCR3, core) & MASK(12);
+#else
+    return cr3_get_pcid(MODE_NODE_STATE_ON_CORE(x64KSCurrentCR3, core));
+#endif
+}
+
+/* Flush the translations of a PCID that another core invalidated while this
+ * core was not using it. Must be called before switching to the PCID. */
+static inline void flushStalePCID(asid_t pcid)
+{
+    word_t *stale = &MODE_NODE_STATE(x64KSStalePCIDs)[pcid / wordBits];
+    if (unlikely(*stale & BIT(pcid % wordBits))) {
+        *stale &= ~BIT(pcid % wordBits);
+        invalidateLocalPCID(INVPCID_TYPE_SINGLE, (void *)0, pcid);
+    }
+}
+#endif /* ENABLE_SMP_SUPPORT && CONFIG_SUPPORT_PCID */
+
 static inline void invalidateLocalTranslationSingle(vptr_t vptr)
 {
     /* As this may be used to invalidate global mappings by the kernel,
@@ -37,6 +37,11 @@ NODE_STATE_DECLARE(word_t, x64KSCurrentUserCR3);
 #else
 NODE_STATE_DECLARE(cr3_t, x64KSCurrentCR3);
 #endif
+#if defined(ENABLE_SMP_SUPPORT) && defined(CONFIG_SUPPORT_PCID)
+/* PCIDs that were invalidated by another core while this core was not using
+ * them. Their translations are flushed before this core switches to them. */
+NODE_STATE_DECLARE(word_t, x64KSStalePCIDs[BIT(ASID_BITS) / wordBits]);
+#endif
 NODE_STATE_END(modeNodeState);
 
 /* hardware interrupt handlers push up to 6 words onto the stack. The order of the
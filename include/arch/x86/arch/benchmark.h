@@ -9,6 +9,8 @@
 #include <config.h>
 #ifdef CONFIG_ENABLE_BENCHMARKS
 
+#include <model/statedata.h>
+
 static inline uint64_t timestamp(void)
 {
     uint32_t low, high;
@@ -33,6 +35,10 @@ static inline uint64_t timestamp(void)
 
 static inline void benchmark_arch_utilisation_reset(void)
 {
+#if defined(CONFIG_BENCHMARK_TRACK_UTILISATION) && defined(CONFIG_VTX)
+    ARCH_NODE_STATE(benchmark_vpid_rollovers) = 0;
+    ARCH_NODE_STATE(benchmark_vpid_evictions) = 0;
+#endif
 }
 
 #endif /* CONFIG_ENABLE_BENCHMARKS */
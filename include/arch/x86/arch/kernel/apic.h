@@ -26,6 +26,7 @@ logical_id_t apic_get_logical_id(void);
 word_t apic_get_cluster(logical_id_t logical_id);
 void apic_ack_active_interrupt(void);
 bool_t apic_is_interrupt_pending(void);
+bool_t apic_is_vector_pending(interrupt_t vector);
 
 void apic_send_ipi_core(irq_t vector, cpu_id_t cpu_id);
 void apic_send_ipi_cluster(irq_t vector, word_t mda);
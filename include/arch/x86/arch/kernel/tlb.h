@@ -8,10 +8,28 @@
 
 #include <arch/smp/ipi_inline.h>
 
+#ifdef ENABLE_SMP_SUPPORT
+/* Returns the cores of mask that have to be sent an IPI to invalidate a PCID.
+ * Cores that are not using the PCID are instead marked to flush it before
+ * they switch to it again. */
+static inline word_t remotePCIDMask(asid_t asid, word_t mask)
+{
+#ifdef CONFIG_SUPPORT_PCID
+    for (word_t core = 0; core < CONFIG_MAX_NUM_NODES; core++) {
+        if ((mask & BIT(core)) && core != getCurrentCPUIndex() && getUserPCIDOnCore(core) != asid) {
+            MODE_NODE_STATE_ON_CORE(x64KSStalePCIDs, core)[asid / wordBits] |= BIT(asid % wordBits);
+            mask &= ~BIT(core);
+        }
+    }
+#endif
+    return mask;
+}
+#endif /* ENABLE_SMP_SUPPORT */
+
 static inline void invalidatePageStructureCacheASID(paddr_t root, asid_t asid, word_t mask)
 {
     invalidateLocalPageStructureCacheASID(root, asid);
-    SMP_COND_STATEMENT(doRemoteInvalidatePageStructureCacheASID(root, asid, mask));
+    SMP_COND_STATEMENT(doRemoteInvalidatePageStructureCacheASID(root, asid, remotePCIDMask(asid, mask)));
 }
 
 static inline void invalidateTranslationSingle(vptr_t vptr, word_t mask)
@@ -23,7 +41,7 @@ static inline void invalidateTranslationSingle(vptr_t vptr, word_t mask)
 static inline void invalidateTranslationSingleASID(vptr_t vptr, asid_t asid, word_t mask)
 {
     invalidateLocalTranslationSingleASID(vptr, asid);
-    SMP_COND_STATEMENT(doRemoteInvalidateTranslationSingleASID(vptr, asid, mask));
+    SMP_COND_STATEMENT(doRemoteInvalidateTranslationSingleASID(vptr, asid, remotePCIDMask(asid, mask)));
 }
 
 static inline void invalidateTranslationAll(word_t mask)
@@ -202,6 +202,21 @@ static inline void arch_pause(void)
 }
 #endif /* ENABLE_SMP_SUPPORT */
 
+#ifdef CONFIG_FAST_MR_COPY
+#define HAVE_ARCH_COPY_WORDS 1
+
+/* Copy n words between non-overlapping buffers. The direction flag is not
+ * cleared on kernel entry, so clear it before using the string instruction. */
+static inline void arch_copy_words(word_t *dst, const word_t *src, word_t n)
+{
+#ifdef CONFIG_ARCH_X86_64
+    asm volatile("cld; rep movsq" : "+D"(dst), "+S"(src), "+c"(n) :: "memory", "cc");
+#else
+    asm volatile("cld; rep movsl" : "+D"(dst), "+S"(src), "+c"(n) :: "memory", "cc");
+#endif
+}
+#endif /* CONFIG_FAST_MR_COPY */
+
 enum x86_vendor {
     X86_VENDOR_INTEL = 0,
     X86_VENDOR_AMD,
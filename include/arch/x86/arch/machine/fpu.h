@@ -16,6 +16,19 @@
 #define MXCSR_INIT_VALUE               0x1f80
 #define XCOMP_BV_COMPACTED_FORMAT      (1ull << 63)
 
+/* XSAVE state components, see Chapter 13 of Volume 1 of the Intel Architectures
+ * Software Developers Manual */
+#define XSAVE_FEATURE_FPU              (1ull << 0)
+#define XSAVE_FEATURE_SSE              (1ull << 1)
+#define XSAVE_FEATURE_AVX              (1ull << 2)
+#define XSAVE_FEATURE_MPX              ((1ull << 3) | (1ull << 4))
+#define XSAVE_FEATURE_AVX512           ((1ull << 5) | (1ull << 6) | (1ull << 7))
+#define XSAVE_FEATURE_AMX              ((1ull << 17) | (1ull << 18))
+/* Components that are enabled through IA32_XSS rather than XCR0, and that can
+ * only be saved and restored with XSAVES and XRSTORS: PT, PASID, CET, HDC,
+ * UINTR, LBR and HWP. */
+#define XSAVE_SUPERVISOR_FEATURES      0x1fd00ull
+
 /* The state format, as saved by FXSAVE and restored by FXRSTOR instructions. */
 typedef struct i387_state {
     uint16_t cwd;               /* control word */
@@ -27,8 +40,13 @@ typedef struct i387_state {
     uint32_t mxcsr_mask;        /* MXCSR mask */
     uint32_t st_space[32];      /* FPU registers */
     uint32_t xmm_space[64];     /* XMM registers */
-    uint32_t padding[13];
+    uint32_t padding[12];
+    /* Bytes 464:511 are not written by the FXSAVE or XSAVE family of
+     * instructions and are available for software use. */
+    uint64_t sw_xfeatures;      /* per-thread XSAVE features, 0 for the configured set */
+    uint32_t sw_reserved[10];
 } PACKED i387_state_t;
+compile_assert(i387_state_size_valid, sizeof(i387_state_t) == 512)
 
 /* The state format, as saved by XSAVE and restored by XRSTOR instructions. */
 typedef struct xsave_state {
@@ -46,44 +64,98 @@ bool_t Arch_initFpu(void);
 /* Initialise the FPU state of the given user context. */
 void Arch_initFpuContext(user_context_t *context);
 
-static inline uint32_t xsave_features_high(void)
+#ifdef CONFIG_XSAVE_THREAD_FEATURES
+/* Returns whether the given feature mask can be selected for a thread: it must
+ * be a subset of the configured user state components that XCR0 accepts. */
+static inline bool_t xsave_features_valid(uint64_t features)
 {
-    uint64_t features = config_ternary(CONFIG_XSAVE, CONFIG_XSAVE_FEATURE_SET, 1);
-    return (uint32_t)(features >> 32);
+    uint64_t user_features = CONFIG_XSAVE_FEATURE_SET & ~XSAVE_SUPERVISOR_FEATURES;
+    uint64_t required = XSAVE_FEATURE_FPU | XSAVE_FEATURE_SSE;
+
+    if ((features & user_features) != features || (features & required) != required) {
+        return false;
+    }
+    if ((features & XSAVE_FEATURE_MPX) && (features & XSAVE_FEATURE_MPX) != XSAVE_FEATURE_MPX) {
+        return false;
+    }
+    if ((features & XSAVE_FEATURE_AVX512) &&
+        ((features & XSAVE_FEATURE_AVX512) != XSAVE_FEATURE_AVX512 || !(features & XSAVE_FEATURE_AVX))) {
+        return false;
+    }
+    if ((features & XSAVE_FEATURE_AMX) && (features & XSAVE_FEATURE_AMX) != XSAVE_FEATURE_AMX) {
+        return false;
+    }
+    return true;
 }
 
-static inline uint32_t xsave_features_low(void)
+/* The requested-feature bitmap for saving and restoring the given FPU state.
+ * Supervisor components are always included, as they are not under the
+ * control of the thread. */
+static inline uint64_t xsave_state_features(user_fpu_state_t *state)
 {
-    uint64_t features = config_ternary(CONFIG_XSAVE, CONFIG_XSAVE_FEATURE_SET, 1);
-    return (uint32_t)(features & 0xffffffff);
+    uint64_t features = ((xsave_state_t *)state)->i387.sw_xfeatures;
+
+    if (features == 0) {
+        return CONFIG_XSAVE_FEATURE_SET;
+    }
+    return features | (CONFIG_XSAVE_FEATURE_SET & XSAVE_SUPERVISOR_FEATURES);
 }
 
+/* Restrict XCR0 to the user components of the given FPU state, so that a
+ * thread cannot access register state that is not saved on its behalf. */
+static inline void xsave_set_xcr0(user_fpu_state_t *state)
+{
+    uint64_t xcr0 = xsave_state_features(state) & ~XSAVE_SUPERVISOR_FEATURES;
+
+    if (xcr0 != ARCH_NODE_STATE(x86KSCurrentXCR0)) {
+        write_xcr0(xcr0);
+        ARCH_NODE_STATE(x86KSCurrentXCR0) = xcr0;
+    }
+}
+#else
+static inline uint64_t xsave_state_features(user_fpu_state_t *state)
+{
+    return config_ternary(CONFIG_XSAVE, CONFIG_XSAVE_FEATURE_SET, 1);
+}
+#endif /* CONFIG_XSAVE_THREAD_FEATURES */
+
 /* Store state in the FPU registers into memory. */
 static inline void saveFpuState(user_fpu_state_t *dest)
 {
+    uint64_t features = xsave_state_features(dest);
+    uint32_t high = (uint32_t)(features >> 32);
+    uint32_t low = (uint32_t)(features & 0xffffffff);
+
     if (config_set(CONFIG_FXSAVE)) {
         asm volatile("fxsave %[dest]" : [dest] "=m"(*dest));
     } else if (config_set(CONFIG_XSAVE_XSAVEOPT)) {
-        asm volatile("xsaveopt %[dest]" : [dest] "=m"(*dest) : "d"(xsave_features_high()), "a"(xsave_features_low()));
+        asm volatile("xsaveopt %[dest]" : [dest] "+m"(*dest) : "d"(high), "a"(low));
     } else if (config_set(CONFIG_XSAVE_XSAVE)) {
-        asm volatile("xsave %[dest]" : [dest] "=m"(*dest) : "d"(xsave_features_high()), "a"(xsave_features_low()));
+        asm volatile("xsave %[dest]" : [dest] "+m"(*dest) : "d"(high), "a"(low));
     } else if (config_set(CONFIG_XSAVE_XSAVEC)) {
-        asm volatile("xsavec %[dest]" : [dest] "=m"(*dest) : "d"(xsave_features_high()), "a"(xsave_features_low()));
+        asm volatile("xsavec %[dest]" : [dest] "+m"(*dest) : "d"(high), "a"(low));
     } else if (config_set(CONFIG_XSAVE_XSAVES)) {
-        asm volatile("xsaves %[dest]" : [dest] "=m"(*dest) : "d"(xsave_features_high()), "a"(xsave_features_low()));
+        asm volatile("xsaves %[dest]" : [dest] "+m"(*dest) : "d"(high), "a"(low));
     }
 }
 
 /* Load FPU state from memory into the FPU registers. */
 static inline void loadFpuState(user_fpu_state_t *src)
 {
+    uint64_t features = xsave_state_features(src);
+    uint32_t high = (uint32_t)(features >> 32);
+    uint32_t low = (uint32_t)(features & 0xffffffff);
+
     if (config_set(CONFIG_FXSAVE)) {
         asm volatile("fxrstor %[src]" :: [src] "m"(*src));
     } else if (config_set(CONFIG_XSAVE)) {
+#ifdef CONFIG_XSAVE_THREAD_FEATURES
+        xsave_set_xcr0(src);
+#endif
         if (config_set(CONFIG_XSAVE_XSAVES)) {
-            asm volatile("xrstors %[src]" :: [src] "m"(*src), "d"(xsave_features_high()), "a"(xsave_features_low()));
+            asm volatile("xrstors %[src]" :: [src] "m"(*src), "d"(high), "a"(low));
         } else {
-            asm volatile("xrstor %[src]" :: [src] "m"(*src), "d"(xsave_features_high()), "a"(xsave_features_low()));
+            asm volatile("xrstor %[src]" :: [src] "m"(*src), "d"(high), "a"(low));
         }
     }
 }
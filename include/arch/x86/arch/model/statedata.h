@@ -38,11 +38,27 @@ NODE_STATE_DECLARE(word_t, ipiReschedulePending);
 
 #ifdef CONFIG_VTX
 NODE_STATE_DECLARE(vcpu_t *, x86KSCurrentVCPU);
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+/* VCPUs whose posted-interrupt notifications are sent to this core */
+NODE_STATE_DECLARE(vcpu_t *, x86KSPostedVCPUs);
+#endif
+/* Next hardware VPID to hand out on this core and the current VPID generation */
+NODE_STATE_DECLARE(word_t, x86KSNextVPID);
+NODE_STATE_DECLARE(uint64_t, x86KSVPIDGeneration);
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+NODE_STATE_DECLARE(timestamp_t, benchmark_vpid_rollovers);
+NODE_STATE_DECLARE(timestamp_t, benchmark_vpid_evictions);
+#endif
 #endif
 
 NODE_STATE_DECLARE(word_t, x86KSCurrentFSBase);
 NODE_STATE_DECLARE(word_t, x86KSCurrentGSBase);
 
+#ifdef CONFIG_XSAVE_THREAD_FEATURES
+/* User state components currently enabled in XCR0 */
+NODE_STATE_DECLARE(uint64_t, x86KSCurrentXCR0);
+#endif
+
 /* If a GP exception occurs and this is non NULL then the exception should return to
  * this location instead of faulting. In addition the GP exception will clear this
  * back to NULL */
@@ -76,6 +92,11 @@ extern vtd_rte_t *x86KSvtdRootTable;
 extern uint32_t x86KSnumIOPTLevels;
 extern uint32_t x86KSnumIODomainIDBits;
 extern uint32_t x86KSFirstValidIODomain;
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+extern vtd_irte_t *x86KSvtdIRT;
+extern uint64_t *x86KSvtdInvQueue[];
+extern uint32_t x86KSvtdInvQueueTail[];
+#endif
 #endif
 
 #ifdef CONFIG_PRINTING
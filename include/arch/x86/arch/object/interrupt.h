@@ -15,4 +15,5 @@ exception_t Arch_decodeIRQControlInvocation(word_t invLabel, word_t length,
                                             cte_t *srcSlot, word_t *buffer);
 void Arch_irqStateInit(void);
 exception_t Arch_checkIRQ(word_t irq_w);
+void Arch_deletedIRQHandler(irq_t irq);
 
@@ -60,6 +60,13 @@ typedef struct arch_tcb {
 
 compile_assert(vtd_pt_size_sane, VTD_PT_INDEX_BITS + VTD_PTE_SIZE_BITS == seL4_IOPageTableBits)
 
+/* A single page of interrupt remapping entries, shared by all IOMMUs. Likewise
+ * each IOMMU gets a page of 16 byte invalidation descriptors */
+#define VTD_IRTE_SIZE_BITS 4
+#define VTD_IRT_BITS       8
+#define VTD_IRT_SIZE_BITS  (VTD_IRT_BITS + VTD_IRTE_SIZE_BITS)
+#define VTD_IQ_SIZE_BITS   12
+
 #ifdef CONFIG_VTX
 
 #define EPT_PML4E_SIZE_BITS seL4_X86_EPTPML4EntryBits
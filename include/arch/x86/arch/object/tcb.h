@@ -14,3 +14,7 @@
 exception_t decodeSetEPTRoot(cap_t cap);
 void Arch_leaveVMAsyncTransfer(tcb_t *tcb);
 #endif
+
+#ifdef CONFIG_XSAVE_THREAD_FEATURES
+exception_t decodeSetXSaveFeatures(cap_t cap, word_t length, word_t *buffer);
+#endif
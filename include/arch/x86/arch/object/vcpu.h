@@ -8,11 +8,15 @@
 
 #include <config.h>
 #include <api/failures.h>
+#include <object/vcpuexitstats.h>
 
 #define VCPU_VMCS_SIZE 4096
 #define VCPU_IOBITMAP_SIZE 8192
 
 #define VMX_CONTROL_VPID 0x00000000
+#define VMX_CONTROL_POSTED_INTERRUPT_VECTOR 0x00000002
+
+#define VMX_GUEST_INTERRUPT_STATUS 0x00000810
 
 #define VMX_GUEST_ES_SELECTOR 0x00000800
 #define VMX_GUEST_CS_SELECTOR 0x00000802
@@ -41,7 +45,12 @@
 #define VMX_CONTROL_TSC_OFFSET 0x00002010
 #define VMX_CONTROL_VIRTUAL_APIC_ADDRESS 0x00002012
 #define VMX_CONTROL_APIC_ACCESS_ADDRESS 0x00002014
+#define VMX_CONTROL_POSTED_INTERRUPT_DESC_ADDRESS 0x00002016
 #define VMX_CONTROL_EPT_POINTER 0x0000201A
+#define VMX_CONTROL_EOI_EXIT_BITMAP0 0x0000201C
+#define VMX_CONTROL_EOI_EXIT_BITMAP1 0x0000201E
+#define VMX_CONTROL_EOI_EXIT_BITMAP2 0x00002020
+#define VMX_CONTROL_EOI_EXIT_BITMAP3 0x00002022
 
 #define VMX_DATA_GUEST_PHYSICAL 0x00002400
 
@@ -226,6 +235,8 @@ enum exit_reasons {
 #define VPID_INVALID 0
 #define VPID_FIRST 1
 #define VPID_LAST (CONFIG_MAX_VPIDS - 1)
+/* Hardware VPIDs are handed out per core from the whole 16-bit space */
+#define HW_VPID_LAST 0xffff
 
 typedef uint16_t vpid_t;
 
@@ -276,6 +287,42 @@ enum vcpu_msr_register {
 
 typedef enum vcpu_gp_register vcpu_gp_register_t;;
 
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+#define VCPU_VAPIC_SIZE 4096
+
+/* Posted-interrupt descriptor, see section 29.6 of Volume 3 of the Intel manual */
+#define PI_DESC_ON BIT(0)  /* Outstanding notification */
+#define PI_DESC_NV 16      /* Notification vector */
+
+typedef struct vcpu_pi_desc {
+    /* Posted-interrupt requests, one bit for each guest vector */
+    uint32_t pir[8];
+    uint32_t control;
+    /* Notification destination, the physical APIC ID of the core running the VCPU */
+    uint32_t ndst;
+    uint32_t reserved[6];
+} vcpu_pi_desc_t;
+
+compile_assert(vcpu_pi_desc_size_sane, sizeof(vcpu_pi_desc_t) == 64)
+#endif
+
+#ifdef CONFIG_VTX_FAST_EXITS
+/* Result of a guest CPUID for a given leaf and subleaf */
+typedef struct vcpu_cpuid_entry {
+    uint32_t leaf;
+    uint32_t subleaf;
+    uint32_t flags;
+    uint32_t eax, ebx, ecx, edx;
+} vcpu_cpuid_entry_t;
+
+/* Guest value of an MSR that the guest may read or write without an exit to user level */
+typedef struct vcpu_msr_entry {
+    uint32_t msr;
+    uint32_t flags;
+    uint64_t value;
+} vcpu_msr_entry_t;
+#endif
+
 const vcpu_gp_register_t crExitRegs[];
 
 struct vcpu {
@@ -283,6 +330,11 @@ struct vcpu {
      * Will use at most 4KiB of memory. Statically reserve 4KiB for convenience. */
     char vmcs[VCPU_VMCS_SIZE];
     word_t io[VCPU_IOBITMAP_SIZE / sizeof(word_t)];
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    /* Virtual-APIC page of the guest. Page aligned as it follows the VMCS and
+     * IO bitmaps, and owned by the kernel as the processor writes to it */
+    uint32_t vapic[VCPU_VAPIC_SIZE / sizeof(uint32_t)];
+#endif
 
     /* Place the fpu state here so that it is aligned */
     user_fpu_state_t fpuState;
@@ -304,8 +356,16 @@ struct vcpu {
     struct tcb *vcpuTCB;
     bool_t launched;
 
-    /* Currently assigned VPID */
+    /* Hardware VPID, only valid while vpid_generation matches the VPID
+     * generation of the core it was allocated on */
     vpid_t vpid;
+    uint64_t vpid_generation;
+#ifdef ENABLE_SMP_SUPPORT
+    word_t vpid_core;
+#endif
+    /* Index in the IO port table that IO port capabilities use to refer to
+     * this VCPU, or VPID_INVALID */
+    vpid_t ioport_id;
 
     /* This is the cr0 value has requested by the VCPU owner. The actual cr0 value set at
      * any particular time may be different to this for lazy fpu management, but we will
@@ -344,12 +404,37 @@ struct vcpu {
     /* Core this VCPU was last loaded on, or is currently loaded on */
     word_t last_cpu;
 #endif /* ENABLE_SMP_SUPPORT */
+
+#ifdef CONFIG_VTX_FAST_EXITS
+    /* Mask of the exits the kernel handles itself, indexed by seL4_X86_FastExit */
+    word_t fast_exits;
+    vcpu_cpuid_entry_t cpuid_entries[CONFIG_VTX_FAST_EXIT_CPUID_ENTRIES];
+    vcpu_msr_entry_t msr_entries[CONFIG_VTX_FAST_EXIT_MSR_ENTRIES];
+    /* Number of exits handled by the kernel, for each seL4_X86_FastExit */
+    word_t fast_exit_count[seL4_X86_FastExit_Num];
+#endif
+
+#ifdef CONFIG_VCPU_EXIT_STATS
+    vcpu_exit_stats_t exit_stats;
+#endif
+
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    bool_t posted_interrupts;
+    /* List of the VCPUs whose notifications are sent to the same core */
+    struct vcpu *pi_next;
+    struct vcpu *pi_prev;
+    vcpu_pi_desc_t pi_desc ALIGN(64);
+#endif
 };
 typedef struct vcpu vcpu_t;
 
 compile_assert(vcpu_size_sane, sizeof(vcpu_t) <= BIT(seL4_X86_VCPUBits))
 unverified_compile_assert(vcpu_fpu_state_alignment_valid,
                           OFFSETOF(vcpu_t, fpuState) % MIN_FPU_ALIGNMENT == 0)
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+unverified_compile_assert(vcpu_vapic_alignment_valid,
+                          OFFSETOF(vcpu_t, vapic) % VCPU_VAPIC_SIZE == 0)
+#endif
 
 /* Initializes a VCPU object with default values. A VCPU object that is not inititlized
  * must not be run/loaded with vmptrld */
@@ -380,13 +465,20 @@ exception_t handleVmEntryFail(void);
 void restoreVMCS(void);
 void clearCurrentVCPU(void);
 
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+void handlePostedInterruptNotification(void);
+#endif
+
 #ifdef ENABLE_SMP_SUPPORT
 void VMCheckBoundNotification(tcb_t *tcb);
 #endif /* ENABLE_SMP_SUPPORT */
 
 void invept(ept_pml4e_t *ept_pml4);
 
-/* Removes any IO port mappings that have been cached for the given VPID */
+extern bool_t vmx_feature_ept_1g;
+extern bool_t vmx_feature_ept_ad;
+
+/* Removes any IO port mappings that have been cached for the given IO port table index */
 void clearVPIDIOPortMappings(vpid_t vpid, uint16_t first, uint16_t last);
 
 #ifdef CONFIG_X86_64_VTX_64BIT_GUESTS
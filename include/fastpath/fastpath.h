@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <kernel/cspace.h>
+
 #ifdef CONFIG_KERNEL_MCS
 #include <object/reply.h>
 #include <object/notification.h>
@@ -83,8 +85,8 @@ static inline void fastpath_vm_fault_set_mrs(tcb_t *dest)
 }
 #endif
 
-/* Fastpath cap lookup.  Returns a null_cap on failure. */
-static inline cap_t FORCE_INLINE lookup_fp(cap_t cap, cptr_t cptr)
+/* Fastpath slot lookup.  Returns NULL on failure. */
+static inline FORCE_INLINE cte_t *lookupSlot_fp(cap_t cap, cptr_t cptr)
 {
     word_t cptr2;
     cte_t *slot;
@@ -94,7 +96,7 @@ static inline cap_t FORCE_INLINE lookup_fp(cap_t cap, cptr_t cptr)
     bits = 0;
 
     if (unlikely(! cap_capType_equals(cap, cap_cnode_cap))) {
-        return cap_null_cap_new();
+        return NULL;
     }
 
     do {
@@ -109,7 +111,7 @@ static inline cap_t FORCE_INLINE lookup_fp(cap_t cap, cptr_t cptr)
            when the guard is 0, when 32MinusGuardSize will be
            reported as 0 also. In this case we skip the check */
         if (likely(guardBits) && unlikely(cptr2 >> (wordBits - guardBits) != capGuard)) {
-            return cap_null_cap_new();
+            return NULL;
         }
 
         radix = cptr2 << guardBits >> (wordBits - radixBits);
@@ -123,11 +125,55 @@ static inline cap_t FORCE_INLINE lookup_fp(cap_t cap, cptr_t cptr)
     if (unlikely(bits > wordBits)) {
         /* Depth mismatch. We've overshot wordBits bits. The lookup we've done is
            safe, but wouldn't be allowed by the slowpath. */
+        return NULL;
+    }
+
+    return slot;
+}
+
+/* Fastpath cap lookup.  Returns a null_cap on failure. */
+static inline cap_t FORCE_INLINE lookup_fp(cap_t cap, cptr_t cptr)
+{
+    cte_t *slot = lookupSlot_fp(cap, cptr);
+
+    if (unlikely(slot == NULL)) {
         return cap_null_cap_new();
     }
+    return slot->cap;
+}
+
+/* Look up cptr in the CSpace of thread, consulting the thread's lookup cache
+ * before walking the CSpace when it is enabled. A successful walk fills the
+ * cache as lookupSlot does. */
+static inline cap_t FORCE_INLINE lookup_fp_cached(tcb_t *thread, cptr_t cptr)
+{
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+    lookup_cache_entry_t *entry = lookupCacheEntry(thread, cptr);
+    cte_t *slot;
+
+    if (likely(lookupCacheEntryValid(entry, cptr))) {
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+        NODE_STATE(benchmark_lookup_cache_hits)++;
+#endif
+        return entry->lcSlot->cap;
+    }
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+    NODE_STATE(benchmark_lookup_cache_misses)++;
+#endif
 
-    return cap;
+    slot = lookupSlot_fp(TCB_PTR_CTE_PTR(thread, tcbCTable)->cap, cptr);
+    if (unlikely(slot == NULL)) {
+        return cap_null_cap_new();
+    }
+    entry->lcGeneration = ksCSpaceGeneration;
+    entry->lcCPtr = cptr;
+    entry->lcSlot = slot;
+    return slot->cap;
+#else
+    return lookup_fp(TCB_PTR_CTE_PTR(thread, tcbCTable)->cap, cptr);
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
 }
+
 /* make sure the fastpath functions conform with structure_*.bf */
 static inline void thread_state_ptr_set_tsType_np(thread_state_t *ts_ptr, word_t tsType)
 {
@@ -28,6 +28,10 @@ typedef struct ndks_boot {
     region_t   freemem[MAX_NUM_FREEMEM_REG];
     seL4_BootInfo      *bi_frame;
     seL4_SlotPos slot_pos_cur;
+#ifdef CONFIG_ROOTSERVER_LARGE_PAGES
+    /* part of the user image that is mapped with large pages */
+    v_region_t it_large_v_reg;
+#endif
 } ndks_boot_t;
 
 extern ndks_boot_t ndks_boot;
@@ -124,6 +128,32 @@ static inline BOOT_CODE word_t get_n_paging(v_region_t v_reg, word_t bits)
     return (end - start) / BIT(bits);
 }
 
+#ifdef CONFIG_ROOTSERVER_LARGE_PAGES
+void init_it_large_v_reg(v_region_t ui_v_reg, sword_t pv_offset);
+
+/* whether vptr of the initial thread is mapped with a large page, in which case
+ * no page table is needed for it */
+static inline BOOT_CODE bool_t it_is_large_vptr(vptr_t vptr)
+{
+    return vptr >= ndks_boot.it_large_v_reg.start && vptr < ndks_boot.it_large_v_reg.end;
+}
+
+static inline BOOT_CODE word_t get_n_it_large_pages(void)
+{
+    return (ndks_boot.it_large_v_reg.end - ndks_boot.it_large_v_reg.start) >> seL4_LargePageBits;
+}
+#else
+static inline BOOT_CODE bool_t it_is_large_vptr(vptr_t vptr UNUSED)
+{
+    return false;
+}
+
+static inline BOOT_CODE word_t get_n_it_large_pages(void)
+{
+    return 0;
+}
+#endif
+
 /* allocate a page table sized structure from rootserver.paging */
 static inline BOOT_CODE pptr_t it_alloc_paging(void)
 {
@@ -10,6 +10,7 @@
 #include <api/failures.h>
 #include <api/types.h>
 #include <object/structures.h>
+#include <model/statedata.h>
 
 struct lookupCap_ret {
     exception_t status;
@@ -59,3 +60,34 @@ resolveAddressBits_ret_t resolveAddressBits(cap_t nodeCap,
                                             cptr_t capptr,
                                             word_t n_bits);
 
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+/* Incremented whenever a CNode cap is written to or removed from any slot,
+ * which invalidates every entry of every thread's lookup cache. */
+extern uint64_t ksCSpaceGeneration;
+
+static inline lookup_cache_entry_t *lookupCacheEntry(tcb_t *thread, cptr_t cptr)
+{
+    word_t index = (cptr ^ (cptr >> (wordBits / 2))) & MASK(CONFIG_CSPACE_LOOKUP_CACHE_BITS);
+    return TCB_PTR_LOOKUP_CACHE_PTR(thread) + index;
+}
+
+static inline bool_t lookupCacheEntryValid(lookup_cache_entry_t *entry, cptr_t cptr)
+{
+    return entry->lcGeneration == ksCSpaceGeneration && entry->lcCPtr == cptr;
+}
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+
+/* Called whenever the cap stored in a slot changes from oldCap to newCap. The
+ * slot a cptr resolves to only depends on the CNode caps along its path, so
+ * changes that do not involve a CNode cap leave cached lookups intact. */
+static inline void lookupCacheCapChanged(cap_t oldCap, cap_t newCap)
+{
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+    if (cap_get_capType(oldCap) == cap_cnode_cap || cap_get_capType(newCap) == cap_cnode_cap) {
+        ksCSpaceGeneration++;
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+        NODE_STATE(benchmark_lookup_cache_invalidations)++;
+#endif
+    }
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+}
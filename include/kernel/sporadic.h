@@ -172,6 +172,44 @@ static inline bool_t sc_constant_bandwidth(sched_context_t *sc)
     return !sc->scSporadic;
 }
 
+/*
+ * Return true if the group of a SC, if it is in one, has budget that
+ * can be used now. Threads only run while both their own SC and its
+ * group are ready.
+ */
+static inline bool_t sc_group_ready(sched_context_t *sc)
+{
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+    if (sc->scGroup != NULL) {
+        return refill_ready(sc->scGroup) && refill_sufficient(sc->scGroup, 0);
+    }
+#endif
+    return true;
+}
+
+/* Return true if the group of a SC, if it is in one, can pay for usage. */
+static inline bool_t sc_group_sufficient(sched_context_t *sc, ticks_t usage)
+{
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+    if (sc->scGroup != NULL) {
+        return refill_sufficient(sc->scGroup, usage);
+    }
+#endif
+    return true;
+}
+
+/* Return how long the thread of a SC can run before it or its group runs out of budget. */
+static inline ticks_t sc_head_budget(sched_context_t *sc)
+{
+    ticks_t budget = refill_head(sc)->rAmount;
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+    if (sc->scGroup != NULL) {
+        budget = MIN(budget, refill_head(sc->scGroup)->rAmount);
+    }
+#endif
+    return budget;
+}
+
 /* Create a new refill in a non-active sc */
 void refill_new(sched_context_t *sc, word_t max_refills, ticks_t budget, ticks_t period);
 
@@ -187,6 +225,18 @@ void refill_update(sched_context_t *sc, ticks_t new_period, ticks_t new_budget,
  */
 void refill_budget_check(ticks_t used);
 
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+/* Charge `usage` of a scheduling context to its group, if it is in one. */
+void refill_group_charge(sched_context_t *sc, ticks_t usage);
+
+/*
+ * Hold back the head refill of a member until the head refill of its group
+ * is released. The release queue is ordered by the head refills of the
+ * members alone, which do not change while they are queued.
+ */
+void refill_group_delay(sched_context_t *sc);
+#endif
+
 /*
  * This is called when a thread is eligible to start running: it
  * iterates through the refills queue and merges any
@@ -76,10 +76,28 @@ static inline prio_t getHighestPrio(word_t dom)
 
 static inline bool_t isHighestPrio(word_t dom, prio_t prio)
 {
+#ifdef CONFIG_SCHED_EDF
+    /* a thread at the EDF priority may not run before queued threads at the
+     * same priority with an earlier deadline */
+    if (prio == CONFIG_EDF_PRIORITY && NODE_STATE(ksEDFQueues)[dom].size != 0) {
+        return false;
+    }
+#endif
     return NODE_STATE(ksReadyQueuesL1Bitmap)[dom] == 0 ||
            prio >= getHighestPrio(dom);
 }
 
+/* Return the thread that runs next out of the threads queued at prio */
+static inline tcb_t *readyQueueHead(word_t dom, prio_t prio)
+{
+#ifdef CONFIG_SCHED_EDF
+    if (prio == CONFIG_EDF_PRIORITY) {
+        return NODE_STATE(ksEDFQueues)[dom].heap[0];
+    }
+#endif
+    return NODE_STATE(ksReadyQueues)[ready_queues_index(dom, prio)].head;
+}
+
 static inline bool_t PURE isBlocked(const tcb_t *thread)
 {
     switch (thread_state_get_tsType(thread->tcbState)) {
@@ -115,6 +133,41 @@ static inline bool_t PURE isRoundRobin(sched_context_t *sc)
     return sc->scPeriod == 0;
 }
 
+#ifdef CONFIG_SCHED_EDF
+/* The deadline of the job a thread starts when the head refill of its
+ * scheduling context is released is the end of the period the refill was
+ * released in. Round robin scheduling contexts have no period, so their
+ * deadline is the end of the budget they have left. */
+static inline ticks_t edfDeadline(sched_context_t *sc)
+{
+    if (isRoundRobin(sc)) {
+        return NODE_STATE(ksCurTime) + refill_head(sc)->rAmount;
+    }
+    return refill_head(sc)->rTime + sc->scPeriod;
+}
+#endif
+
+/* Fix the deadline of a thread when a refill of its scheduling context is
+ * released, either because it was awakened or unblocked or because it starts
+ * a new refill. The deadline is kept until the next release, so a thread that
+ * is already queued keeps the deadline it was queued with. */
+static inline void edfRelease(tcb_t *tcb)
+{
+#ifdef CONFIG_SCHED_EDF
+    if (!thread_state_get_tcbQueued(tcb->tcbState)) {
+        tcb->tcbDeadline = edfDeadline(tcb->tcbSchedContext);
+    }
+#endif
+}
+
+/* A donated scheduling context continues the job of the thread it came from. */
+static inline void edfDonate(tcb_t *from, tcb_t *to)
+{
+#ifdef CONFIG_SCHED_EDF
+    to->tcbDeadline = from->tcbDeadline;
+#endif
+}
+
 static inline bool_t isCurDomainExpired(void)
 {
     return numDomains > 1 &&
@@ -140,6 +193,9 @@ static inline void commitTime(void)
             } else {
                 refill_budget_check(NODE_STATE(ksConsumed));
             }
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+            refill_group_charge(NODE_STATE(ksCurSC), NODE_STATE(ksConsumed));
+#endif
             assert(refill_sufficient(NODE_STATE(ksCurSC), 0));
             assert(refill_ready(NODE_STATE(ksCurSC)));
         }
@@ -185,6 +241,9 @@ void doNormalTransfer(tcb_t *sender, word_t *sendBuffer, endpoint_t *endpoint,
 void doFaultTransfer(word_t badge, tcb_t *sender, tcb_t *receiver,
                      word_t *receiverIPCBuffer);
 void doNBRecvFailedTransfer(tcb_t *thread);
+#ifdef CONFIG_IPC_FRAME_GRANT
+void releaseGrantFrame(tcb_t *thread);
+#endif
 void schedule(void);
 void chooseThread(void);
 void switchToThread(tcb_t *thread);
@@ -270,6 +329,14 @@ static inline bool_t checkBudget(void)
 
     /* if the budget isn't enough, the timeslice for this SC is over. */
     if (likely(refill_sufficient(NODE_STATE(ksCurSC), NODE_STATE(ksConsumed)))) {
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+        /* the group running out of budget does not cause a timeout fault, as
+         * the budget of the SC itself has not expired */
+        if (unlikely(!sc_group_sufficient(NODE_STATE(ksCurSC), NODE_STATE(ksConsumed)))) {
+            chargeBudget(NODE_STATE(ksConsumed), false);
+            return false;
+        }
+#endif
         if (unlikely(isCurDomainExpired())) {
             return false;
         }
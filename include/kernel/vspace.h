@@ -12,3 +12,17 @@
 exception_t benchmark_arch_map_logBuffer(word_t frame_cptr);
 #endif /* CONFIG_KERNEL_LOG_BUFFER */
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+/* Return true if the derived frame cap 'cap' can be mapped at 'vaddr' in the
+ * address space of 'receiver'. If 'replacing' is set, the previous grant of the
+ * receiver has the same size and is mapped at 'vaddr', and is released before
+ * the new frame is mapped. It only frees the window if it was mapped in the
+ * current address space of the receiver, which the check must confirm. May
+ * leave a syscall error behind. */
+bool_t Arch_checkGrantFrame(cap_t cap, tcb_t *receiver, vptr_t vaddr, bool_t replacing);
+/* Map the derived frame cap 'cap' of 'srcSlot' at 'vaddr' in the address space
+ * of 'receiver' and record the mapping in its tcbGrantFrame slot, which must be
+ * empty. Arch_checkGrantFrame must have accepted the mapping. */
+void Arch_mapGrantFrame(cap_t cap, cte_t *srcSlot, tcb_t *receiver, vptr_t vaddr);
+#endif /* CONFIG_IPC_FRAME_GRANT */
+
@@ -57,3 +57,21 @@ static inline p_region_t CONST pptr_to_paddr_reg(const region_t reg)
 
 
 #include <mode/machine.h>
+
+#if defined(CONFIG_FAST_MR_COPY) && !defined(HAVE_ARCH_COPY_WORDS)
+/* Copy n words between non-overlapping buffers, four words per iteration so
+ * that the compiler can pair the loads and stores. Architectures with a
+ * faster block copy define HAVE_ARCH_COPY_WORDS and provide their own. */
+static inline void arch_copy_words(word_t *dst, const word_t *src, word_t n)
+{
+    for (; n >= 4; n -= 4, dst += 4, src += 4) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = src[3];
+    }
+    for (; n > 0; n--) {
+        *dst++ = *src++;
+    }
+}
+#endif
@@ -31,8 +31,35 @@ static inline bool_t nativeThreadUsingFPU(tcb_t *thread)
            NODE_STATE_ON_CORE(ksActiveFPUState, thread->tcbAffinity);
 }
 
+#ifdef CONFIG_FPU_SWITCH_POLICY
+/* Switch in the FPU state of a thread whose policy asks for eager loading. */
+void eagerFPURestore(tcb_t *thread);
+
+/* Returns whether the FPU state of the passed thread should be loaded when
+ * it is restored, rather than after it faults on its first FPU access. */
+static inline bool_t fpuPolicyWantsEager(tcb_t *thread)
+{
+#if defined(CONFIG_ARM_HYPERVISOR_SUPPORT) && defined(CONFIG_ARCH_AARCH32)
+    /* VCPU threads rely on handleFPUFault to switch FPEXC */
+    if (thread->tcbArch.tcbVCPU) {
+        return false;
+    }
+#endif
+    return thread->tcbFPUPolicy == seL4_FPUPolicy_Eager ||
+           (thread->tcbFPUPolicy == seL4_FPUPolicy_Adaptive &&
+            thread->tcbFPUUseCount >= CONFIG_FPU_ADAPTIVE_THRESHOLD);
+}
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+
 static inline void FORCE_INLINE lazyFPURestore(tcb_t *thread)
 {
+#ifdef CONFIG_FPU_SWITCH_POLICY
+    if (unlikely(fpuPolicyWantsEager(thread))) {
+        eagerFPURestore(thread);
+        return;
+    }
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+
     if (unlikely(NODE_STATE(ksActiveFPUState))) {
         /* If we have enabled/disabled the FPU too many times without
          * someone else trying to use it, we assume it is no longer
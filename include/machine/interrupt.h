@@ -74,6 +74,20 @@ static inline irq_t getActiveIRQ(void);
  */
 static inline bool_t isIRQPending(void);
 
+#ifdef ENABLE_SMP_SUPPORT
+/**
+ * Checks if an IPI is pending without acknowledging it.
+ *
+ * A core handling several interrupts in one kernel entry uses this to stop
+ * before the remote call IPI, which is handled without the kernel lock.
+ *
+ * @param[in]  ipi   The hardware irq number of the IPI
+ *
+ * @return     True if the IPI is pending, False otherwise.
+ */
+static inline bool_t isIPIPending(word_t ipi);
+#endif
+
 /**
  * maskInterrupt disables and enables IRQs.
  *
@@ -65,6 +65,9 @@ NODE_STATE_DECLARE(tcb_t, *ksSchedulerAction);
 
 #ifdef CONFIG_KERNEL_MCS
 NODE_STATE_DECLARE(tcb_t, *ksReleaseHead);
+#ifdef CONFIG_SCHED_EDF
+NODE_STATE_DECLARE(edf_queue_t, ksEDFQueues[CONFIG_NUM_DOMAINS]);
+#endif
 NODE_STATE_DECLARE(time_t, ksConsumed);
 NODE_STATE_DECLARE(time_t, ksCurTime);
 NODE_STATE_DECLARE(bool_t, ksReprogram);
@@ -88,16 +91,42 @@ NODE_STATE_DECLARE(timestamp_t, benchmark_end_time);
 NODE_STATE_DECLARE(timestamp_t, benchmark_kernel_time);
 NODE_STATE_DECLARE(timestamp_t, benchmark_kernel_number_entries);
 NODE_STATE_DECLARE(timestamp_t, benchmark_kernel_number_schedules);
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+NODE_STATE_DECLARE(timestamp_t, benchmark_lookup_cache_hits);
+NODE_STATE_DECLARE(timestamp_t, benchmark_lookup_cache_misses);
+NODE_STATE_DECLARE(timestamp_t, benchmark_lookup_cache_invalidations);
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+#ifdef CONFIG_FPU_SWITCH_POLICY
+NODE_STATE_DECLARE(timestamp_t, benchmark_fpu_faults);
+NODE_STATE_DECLARE(timestamp_t, benchmark_fpu_eager_restores);
+NODE_STATE_DECLARE(timestamp_t, benchmark_fpu_switches);
+NODE_STATE_DECLARE(timestamp_t, benchmark_fpu_switch_cycles);
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+#ifdef CONFIG_IRQ_BATCHING
+NODE_STATE_DECLARE(timestamp_t, benchmark_irq_entries);
+NODE_STATE_DECLARE(timestamp_t, benchmark_irqs_handled);
+#endif /* CONFIG_IRQ_BATCHING */
+#ifdef CONFIG_SCHED_EDF
+NODE_STATE_DECLARE(timestamp_t, benchmark_schedule_cycles);
+NODE_STATE_DECLARE(timestamp_t, benchmark_edf_dispatches);
+NODE_STATE_DECLARE(timestamp_t, benchmark_edf_deadline_misses);
+#endif /* CONFIG_SCHED_EDF */
 #endif /* CONFIG_BENCHMARK_TRACK_UTILISATION */
 
 NODE_STATE_END(nodeState);
 
 extern word_t ksNumCPUs;
 
+#ifdef CONFIG_ARM_GIC_V3_ITS
+/* LPIs are numbered after maxIRQ */
+#define INT_STATE_MAX_IRQ (maxIRQ + CONFIG_ARM_GIC_V3_ITS_NUM_LPIS)
+#else
+#define INT_STATE_MAX_IRQ maxIRQ
+#endif
 #if defined ENABLE_SMP_SUPPORT && defined CONFIG_ARCH_ARM
-#define INT_STATE_ARRAY_SIZE ((CONFIG_MAX_NUM_NODES - 1) * NUM_PPI + maxIRQ + 1)
+#define INT_STATE_ARRAY_SIZE ((CONFIG_MAX_NUM_NODES - 1) * NUM_PPI + INT_STATE_MAX_IRQ + 1)
 #else
-#define INT_STATE_ARRAY_SIZE (maxIRQ + 1)
+#define INT_STATE_ARRAY_SIZE (INT_STATE_MAX_IRQ + 1)
 #endif
 extern word_t ksWorkUnitsCompleted;
 extern irq_state_t intStateIRQTable[];
@@ -112,6 +141,9 @@ extern ticks_t ksDomainTime;
 #else
 extern word_t ksDomainTime;
 #endif
+#ifdef CONFIG_SCHED_EDF
+extern word_t ksEDFNumThreads;
+#endif
 extern word_t tlbLockCount VISIBLE;
 
 extern char ksIdleThreadTCB[CONFIG_MAX_NUM_NODES][BIT(seL4_TCBBits)];
@@ -15,8 +15,11 @@
 exception_t decodeIRQControlInvocation(word_t invLabel, word_t length,
                                        cte_t *srcSlot, word_t *buffer);
 exception_t invokeIRQControl(irq_t irq, cte_t *handlerSlot, cte_t *controlSlot);
-exception_t decodeIRQHandlerInvocation(word_t invLabel, irq_t irq);
+exception_t decodeIRQHandlerInvocation(word_t invLabel, word_t length, irq_t irq, word_t *buffer);
 void invokeIRQHandler_AckIRQ(irq_t irq);
+#ifdef CONFIG_IRQ_ACK_MANY
+void invokeIRQHandler_AckMany(irq_t irq, cte_t *handlers, word_t count);
+#endif
 void invokeIRQHandler_SetIRQHandler(irq_t irq, cap_t cap, cte_t *slot);
 void invokeIRQHandler_ClearIRQHandler(irq_t irq);
 void deletingIRQHandler(irq_t irq);
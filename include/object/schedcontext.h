@@ -66,6 +66,20 @@ void schedContext_bindNtfn(sched_context_t *sc, notification_t *ntfn);
 /* unbind scheduling context from a notification */
 void schedContext_unbindNtfn(sched_context_t *sc);
 
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+/* Make sc a member of group, so that the time consumed by sc is also charged
+ * to group and sc can only run while group has budget available.
+ *
+ * @pre sc is not in a group and is not a group, group is not in a group and
+ *      is not bound to a tcb or notification
+ */
+void schedContext_joinGroup(sched_context_t *sc, sched_context_t *group);
+/* Remove sc from its group, if it is in one */
+void schedContext_leaveGroup(sched_context_t *sc);
+/* Remove all members from a group */
+void schedContext_removeGroupMembers(sched_context_t *group);
+#endif
+
 time_t schedContext_updateConsumed(sched_context_t *sc);
 void schedContext_completeYieldTo(tcb_t *yielder);
 void schedContext_cancelYieldTo(tcb_t *yielder);
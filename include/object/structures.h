@@ -202,6 +202,10 @@ enum tcb_cnode_index {
 
     /* IPC buffer cap slot */
     tcbBuffer = 4,
+#endif
+#ifdef CONFIG_IPC_FRAME_GRANT
+    /* Frame currently mapped at the grant window */
+    tcbGrantFrame,
 #endif
     tcbCNodeEntries
 };
@@ -293,6 +297,19 @@ struct tcb {
     word_t tcbAffinity;
 #endif /* ENABLE_SMP_SUPPORT */
 
+#ifdef CONFIG_FPU_SWITCH_POLICY
+    /* FPU switching policy and adaptive FPU use count, 2 bytes (padded to 1 word) */
+    uint8_t tcbFPUPolicy;
+    uint8_t tcbFPUUseCount;
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+
+#ifdef CONFIG_SCHED_EDF
+    /* Deadline and index in the EDF heap while queued at the EDF priority,
+     * 2 words (3 words on 32-bit) */
+    ticks_t tcbDeadline;
+    word_t tcbEDFIndex;
+#endif /* CONFIG_SCHED_EDF */
+
     /* Previous and next pointers for scheduler queues , 2 words */
     struct tcb *tcbSchedNext;
     struct tcb *tcbSchedPrev;
@@ -307,6 +324,34 @@ struct tcb {
 };
 typedef struct tcb tcb_t;
 
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+/* The CSpace lookup cache is inserted into the 'unused' region of a TCB object,
+   directly after the TCB CNode entries and ahead of the debug_tcb object. An
+   entry is only valid while its generation matches ksCSpaceGeneration. */
+struct lookup_cache_entry {
+    uint64_t lcGeneration;
+    cptr_t lcCPtr;
+    cte_t *lcSlot;
+};
+typedef struct lookup_cache_entry lookup_cache_entry_t;
+
+#define TCB_LOOKUP_CACHE_ENTRIES BIT(CONFIG_CSPACE_LOOKUP_CACHE_BITS)
+#define TCB_LOOKUP_CACHE_SIZE (TCB_LOOKUP_CACHE_ENTRIES * sizeof(lookup_cache_entry_t))
+#define TCB_PTR_LOOKUP_CACHE_PTR(p) ((lookup_cache_entry_t *)TCB_PTR_CTE_PTR(p,tcbArchCNodeEntries))
+#else
+#define TCB_LOOKUP_CACHE_SIZE 0
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+
+#ifdef CONFIG_IPC_FRAME_GRANT
+/* The address of a thread's grant window is kept in the 'unused' region of a
+   TCB object, after the CSpace lookup cache. 0 if no window is registered. */
+#define TCB_GRANT_WINDOW_SIZE sizeof(word_t)
+#define TCB_PTR_GRANT_WINDOW_PTR(p) \
+    ((word_t *)((word_t)TCB_PTR_CTE_PTR(p,tcbArchCNodeEntries) + TCB_LOOKUP_CACHE_SIZE))
+#else
+#define TCB_GRANT_WINDOW_SIZE 0
+#endif /* CONFIG_IPC_FRAME_GRANT */
+
 #ifdef CONFIG_DEBUG_BUILD
 /* This debug_tcb object is inserted into the 'unused' region of a TCB object
    for debug build configurations. */
@@ -322,7 +367,9 @@ struct debug_tcb {
 };
 typedef struct debug_tcb debug_tcb_t;
 
-#define TCB_PTR_DEBUG_PTR(p) ((debug_tcb_t *)TCB_PTR_CTE_PTR(p,tcbArchCNodeEntries))
+#define TCB_PTR_DEBUG_PTR(p) \
+    ((debug_tcb_t *)((word_t)TCB_PTR_CTE_PTR(p,tcbArchCNodeEntries) + TCB_LOOKUP_CACHE_SIZE + \
+                     TCB_GRANT_WINDOW_SIZE))
 #endif /* CONFIG_DEBUG_BUILD */
 
 #ifdef CONFIG_KERNEL_MCS
@@ -339,6 +386,9 @@ struct sched_context {
     /* period for this sc -- controls rate at which budget is replenished */
     ticks_t scPeriod;
 
+    /* budget this sc was configured with -- the sum of its refills */
+    ticks_t scBudget;
+
     /* amount of ticks this sc has been scheduled for since seL4_SchedContext_Consumed
      * was last called or a timeout exception fired */
     ticks_t scConsumed;
@@ -372,6 +422,17 @@ struct sched_context {
     /* Whether to apply constant-bandwidth/sliding-window constraint
      * rather than only sporadic server constraints */
     bool_t scSporadic;
+
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+    /* group scheduling context that also pays for the time consumed by this
+     * one, or NULL */
+    sched_context_t *scGroup;
+    /* doubly linked list of the members of scGroup */
+    sched_context_t *scGroupNext;
+    sched_context_t *scGroupPrev;
+    /* head of the list of members, if this scheduling context is a group */
+    sched_context_t *scGroupMembers;
+#endif
 };
 
 struct reply {
@@ -405,6 +466,9 @@ compile_assert(tcb_size_sane,
                BIT(TCB_SIZE_BITS) >= sizeof(tcb_t))
 compile_assert(tcb_size_not_excessive,
                BIT(TCB_SIZE_BITS - 1) < sizeof(tcb_t))
+compile_assert(tcb_unused_region_fits,
+               tcbArchCNodeEntries * sizeof(cte_t) + TCB_LOOKUP_CACHE_SIZE + TCB_GRANT_WINDOW_SIZE <=
+               BIT(TCB_SIZE_BITS))
 compile_assert(ep_size_sane, sizeof(endpoint_t) == BIT(seL4_EndpointBits))
 compile_assert(notification_size_sane, sizeof(notification_t) == BIT(seL4_NotificationBits))
 
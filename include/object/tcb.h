@@ -15,7 +15,8 @@
 
 #ifdef CONFIG_DEBUG_BUILD
 /* Maximum length of the tcb name, including null terminator */
-#define TCB_NAME_LENGTH (BIT(seL4_TCBBits-1) - (tcbCNodeEntries * sizeof(cte_t)) - sizeof(debug_tcb_t))
+#define TCB_NAME_LENGTH (BIT(seL4_TCBBits-1) - (tcbArchCNodeEntries * sizeof(cte_t)) - \
+                         TCB_LOOKUP_CACHE_SIZE - TCB_GRANT_WINDOW_SIZE - sizeof(debug_tcb_t))
 compile_assert(tcb_name_fits, TCB_NAME_LENGTH > 0)
 #endif
 
@@ -25,6 +26,16 @@ struct tcb_queue {
 };
 typedef struct tcb_queue tcb_queue_t;
 
+#ifdef CONFIG_SCHED_EDF
+/* Binary min-heap of the threads queued at the EDF priority, ordered by
+ * tcbDeadline. Each thread records its index in tcbEDFIndex. */
+struct edf_queue {
+    word_t size;
+    tcb_t *heap[CONFIG_EDF_MAX_THREADS];
+};
+typedef struct edf_queue edf_queue_t;
+#endif
+
 static inline unsigned int setMR(tcb_t *receiver, word_t *receiveIPCBuffer,
                                  unsigned int offset, word_t reg)
 {
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#pragma once
+
+#include <config.h>
+
+#ifdef CONFIG_VCPU_EXIT_STATS
+
+#include <types.h>
+#include <util.h>
+#include <sel4/constants.h>
+
+/* VM exit statistics kept in each VCPU object. The architecture code counts an
+ * exit when it enters the kernel from the guest and adds the time until the
+ * guest is next resumed, which includes any time spent in the VCPU owner. */
+typedef struct vcpu_exit_stats {
+    uint64_t count[seL4_VCPUExitReasons];
+    uint64_t ticks[seL4_VCPUExitReasons];
+    uint32_t histogram[seL4_VCPUExitReasons][seL4_VCPUExitHistogramBuckets];
+    /* Reason and time of the last exit while the guest has not been resumed */
+    bool_t pending;
+    word_t pending_reason;
+    uint64_t pending_start;
+} vcpu_exit_stats_t;
+
+/* Message layout of the GetExitStats reply: the count and the total ticks are
+ * 64 bit values, followed by one word for each histogram bucket */
+#define VCPU_EXIT_STATS_TICKS       (sizeof(uint64_t) / sizeof(word_t))
+#define VCPU_EXIT_STATS_HISTOGRAM   (2 * VCPU_EXIT_STATS_TICKS)
+
+static inline word_t vcpuExitStatsBucket(uint64_t ticks)
+{
+    word_t bucket;
+
+    if (ticks < BIT(seL4_VCPUExitHistogramShift + 1)) {
+        return 0;
+    }
+    bucket = 63 - clzll(ticks) - seL4_VCPUExitHistogramShift;
+    return MIN(bucket, seL4_VCPUExitHistogramBuckets - 1);
+}
+
+static inline void vcpuExitStatsExit(vcpu_exit_stats_t *stats, word_t reason, uint64_t now)
+{
+    if (reason >= seL4_VCPUExitReasons) {
+        reason = seL4_VCPUExitReasons - 1;
+    }
+    stats->count[reason]++;
+    stats->pending = true;
+    stats->pending_reason = reason;
+    stats->pending_start = now;
+}
+
+static inline void vcpuExitStatsResume(vcpu_exit_stats_t *stats, uint64_t now)
+{
+    uint64_t ticks;
+
+    if (!stats->pending) {
+        return;
+    }
+    ticks = now - stats->pending_start;
+    stats->ticks[stats->pending_reason] += ticks;
+    stats->histogram[stats->pending_reason][vcpuExitStatsBucket(ticks)]++;
+    stats->pending = false;
+}
+
+#endif /* CONFIG_VCPU_EXIT_STATS */
@@ -45,4 +45,29 @@ block vtd_pte {
     field       read                1
 }
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+-- Intel VT-d Interrupt Remapping Table Entry (remapped format)
+block vtd_irte {
+    padding                         32
+
+    padding                         12
+    field       svt                 2
+    field       sq                  2
+    field       sid                 16
+
+    field       dst                 32
+
+    padding                         8
+    field       vector              8
+    field       im                  1
+    padding                         7
+    field       dlm                 3
+    field       tm                  1
+    field       rh                  1
+    field       dm                  1
+    field       fpd                 1
+    field       present             1
+}
+#endif
+
 #endif
@@ -42,4 +42,46 @@ block vtd_pte {
     field       read                1
 }
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+-- Intel VT-d Interrupt Remapping Table Entry (remapped format)
+block vtd_irte {
+    padding                         44
+    field       svt                 2
+    field       sq                  2
+    field       sid                 16
+
+    field       dst                 32
+    padding                         8
+    field       vector              8
+    field       im                  1
+    padding                         7
+    field       dlm                 3
+    field       tm                  1
+    field       rh                  1
+    field       dm                  1
+    field       fpd                 1
+    field       present             1
+}
+#endif
+
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+-- Intel VT-d Interrupt Remapping Table Entry (posted format)
+block vtd_posted_irte {
+    field       pda_high            32
+    padding                         12
+    field       svt                 2
+    field       sq                  2
+    field       sid                 16
+
+    field       pda_low             26
+    padding                         14
+    field       vector              8
+    field       im                  1
+    field       urgent              1
+    padding                         12
+    field       fpd                 1
+    field       present             1
+}
+#endif
+
 #endif
@@ -19,4 +19,20 @@ word_t vtd_get_n_paging(acpi_rmrr_list_t *rmrr_list);
 bool_t vtd_init_num_iopts(uint32_t num_drhu);
 bool_t vtd_init(cpu_id_t  cpu_id, acpi_rmrr_list_t *rmrr_list);
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+/* number of entries in the interrupt remapping table, and hence valid MSI handles */
+#define N_VTD_IRTES BIT(VTD_IRT_BITS)
+
+/* remap MSIs from the given requester id and handle to a host vector */
+void vtd_map_msi(word_t index, uint32_t source_id, word_t vector);
+/* remove the entry of the given handle, whether it remaps or posts */
+void vtd_unmap_msi(word_t index);
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+/* post MSIs from the given requester id and handle to a guest vector */
+void vtd_map_posted_msi(word_t index, uint32_t source_id, word_t vector, paddr_t pi_desc);
+/* remove every entry that posts to the given descriptor */
+void vtd_unmap_posted_msis(paddr_t pi_desc);
+#endif
+#endif /* CONFIG_IOMMU_INTERRUPT_REMAPPING */
+
 #endif /* CONFIG_IOMMU */
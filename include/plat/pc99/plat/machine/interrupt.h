@@ -28,6 +28,14 @@ static inline void handleReservedIRQ(irq_t irq)
     }
 #endif
 
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    if (irq == irq_posted_interrupt) {
+        /* The target VCPU was not running when the notification arrived */
+        handlePostedInterruptNotification();
+        return;
+    }
+#endif
+
 #ifdef CONFIG_IRQ_REPORTING
     printf("Received unhandled reserved IRQ: %d\n", (int)irq);
 #endif
@@ -89,6 +97,13 @@ static inline bool_t isIRQPending(void)
     return false;
 }
 
+#ifdef ENABLE_SMP_SUPPORT
+static inline bool_t isIPIPending(word_t ipi)
+{
+    return apic_is_vector_pending(ipi + IRQ_INT_OFFSET);
+}
+#endif
+
 static inline void ackInterrupt(irq_t irq)
 {
     if (config_set(CONFIG_IRQ_PIC) && irq <= irq_isa_max) {
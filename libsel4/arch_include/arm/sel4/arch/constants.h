@@ -6,3 +6,9 @@
 
 #pragma once
 
+#ifdef CONFIG_VCPU_EXIT_STATS
+/* Exit reason under which seL4_ARM_VCPU_GetExitStats reports interrupts taken
+ * while the guest was running. Exception class 0x3f is not used by the
+ * architecture. */
+#define seL4_ARM_VCPUExit_Interrupt 0x3f
+#endif
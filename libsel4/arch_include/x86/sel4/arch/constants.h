@@ -6,26 +6,61 @@
 
 #pragma once
 
+#include <sel4/config.h>
+
 /* Currently MSIs do not go through a vt-d translation by
  * the kernel, therefore when the user programs an MSI they
  * need to know how the 'vector' they allocated relates to
  * the actual vector table. In this case if they allocate
  * vector X they need to program their MSI to interrupt
- * vector X + IRQ_OFFSET */
+ * vector X + IRQ_OFFSET. With CONFIG_IOMMU_INTERRUPT_REMAPPING
+ * the MSI may instead be programmed in the remappable format,
+ * using the handle given to the kernel as the interrupt index */
 #define IRQ_OFFSET (0x20 + 16)
 
 /* When allocating vectors for IOAPIC or MSI interrupts,
  * this represent the valid range */
 #define VECTOR_MIN (0)
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+/* The kernel takes the top user vector for posted-interrupt notifications,
+ * which leaves vectors up to 154 - IRQ_OFFSET */
+#define VECTOR_MAX (106)
+#else
 #define VECTOR_MAX (109)
+#endif
 
 /* Legacy definitions */
 #define MSI_MIN VECTOR_MIN
 #define MSI_MAX VECTOR_MAX
 
+#if defined(CONFIG_VTX_POSTED_INTERRUPTS) || defined(CONFIG_VCPU_EXIT_STATS)
+/* The VCPU additionally holds the virtual-APIC page of the guest or the VM
+ * exit statistics */
+#define seL4_VCPUBits 15
+#else
 #define seL4_VCPUBits 14
+#endif
 #define seL4_X86_VCPUBits    seL4_VCPUBits
 
+#ifdef CONFIG_VTX_FAST_EXITS
+/* VM exits that the kernel can handle itself, enabled on a VCPU by passing a
+ * mask of BIT(seL4_X86_FastExit_*) to seL4_X86_VCPU_SetFastExits */
+#define seL4_X86_FastExit_CPUID 0
+#define seL4_X86_FastExit_RDTSC 1
+#define seL4_X86_FastExit_RDMSR 2
+#define seL4_X86_FastExit_WRMSR 3
+#define seL4_X86_FastExit_HLT   4
+#define seL4_X86_FastExit_Num   5
+
+/* Flags of a CPUID leaf set with seL4_X86_VCPU_SetCPUIDEntry */
+#define seL4_X86_CPUIDEntry_Valid       0x1
+#define seL4_X86_CPUIDEntry_AnySubleaf  0x2
+
+/* Flags of an MSR set with seL4_X86_VCPU_SetMSREntry */
+#define seL4_X86_MSREntry_Read  0x1
+#define seL4_X86_MSREntry_Write 0x2
+#endif
+
 #define seL4_X86_EPTPML4EntryBits 3
 #define seL4_X86_EPTPML4IndexBits 9
 #define seL4_X86_EPTPML4Bits (seL4_X86_EPTPML4EntryBits + seL4_X86_EPTPML4IndexBits)
@@ -40,4 +75,8 @@
 
 #define seL4_X86_EPTPTEntryBits   3
 #define seL4_X86_EPTPTIndexBits   9
-#define seL4_X86_EPTPTBits   (seL4_X86_EPTPTEntryBits + seL4_X86_EPTPTIndexBits)
\ No newline at end of file
+#define seL4_X86_EPTPTBits   (seL4_X86_EPTPTEntryBits + seL4_X86_EPTPTIndexBits)
+
+/* Most guest physical pages covered by one seL4_X86_EPTPML4_HarvestDirty
+ * call, which is one bit for every page in a 4K bitmap frame */
+#define seL4_X86_EPTHarvestMaxPages 32768
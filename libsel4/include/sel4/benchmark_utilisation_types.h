@@ -40,6 +40,62 @@ enum benchmark_track_util_ipc_index {
     BENCHMARK_TOTAL_KERNEL_UTILISATION,
     /* Total number of times the kernel is entered on the current core */
     BENCHMARK_TOTAL_NUMBER_KERNEL_ENTRIES,
+
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+    /* CSpace lookup cache, for the current core */
+    /* Number of capability lookups satisfied from a thread's lookup cache */
+    BENCHMARK_LOOKUP_CACHE_HITS,
+    /* Number of capability lookups that had to walk the CSpace */
+    BENCHMARK_LOOKUP_CACHE_MISSES,
+    /* Number of times all lookup caches were invalidated by a CNode cap change */
+    BENCHMARK_LOOKUP_CACHE_INVALIDATIONS,
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+
+#ifdef CONFIG_FPU_SWITCH_POLICY
+    /* FPU switching, for the current core */
+    /* Number of FPU faults taken by lazily switched threads */
+    BENCHMARK_FPU_FAULTS,
+    /* Number of times FPU state was loaded eagerly on thread restore */
+    BENCHMARK_FPU_EAGER_RESTORES,
+    /* Number of times the FPU owner was switched */
+    BENCHMARK_FPU_SWITCHES,
+    /* Total cycles spent saving and loading FPU state */
+    BENCHMARK_FPU_SWITCH_CYCLES,
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+
+#ifdef CONFIG_IRQ_BATCHING
+    /* Interrupt batching, for the current core */
+    /* Number of kernel entries caused by an interrupt */
+    BENCHMARK_IRQ_ENTRIES,
+    /* Number of interrupts handled in those entries */
+    BENCHMARK_IRQS_HANDLED,
+#endif /* CONFIG_IRQ_BATCHING */
+
+#ifdef CONFIG_SCHED_EDF
+    /* Scheduler, for the current core */
+    /* Total cycles spent in the scheduler, for fixed priority and EDF threads alike */
+    BENCHMARK_SCHEDULE_CYCLES,
+    /* Number of times a thread at the EDF priority was switched to */
+    BENCHMARK_EDF_DISPATCHES,
+    /* Number of those switches that happened after the deadline of the thread */
+    BENCHMARK_EDF_DEADLINE_MISSES,
+#endif /* CONFIG_SCHED_EDF */
+
+#if defined(CONFIG_ARCH_AARCH64) && defined(CONFIG_ARM_HYPERVISOR_SUPPORT)
+    /* Hardware VMID allocation, for the whole system */
+    /* Number of times every VMID was handed out and the VMID generation rolled over */
+    BENCHMARK_HW_ASID_ROLLOVERS,
+    /* Number of address spaces that lost their VMID to a rollover and needed a new one */
+    BENCHMARK_HW_ASID_EVICTIONS,
+#endif
+
+#ifdef CONFIG_VTX
+    /* Hardware VPID allocation, for the current core */
+    /* Number of times every VPID was handed out and the VPID generation rolled over */
+    BENCHMARK_VPID_ROLLOVERS,
+    /* Number of VCPUs that lost their VPID to a rollover and needed a new one */
+    BENCHMARK_VPID_EVICTIONS,
+#endif
 };
 
 #endif /* CONFIG_BENCHMARK_TRACK_UTILISATION */
@@ -41,6 +41,16 @@ typedef enum {
 } seL4_DebugException_Msg;
 #endif
 
+#ifdef CONFIG_FPU_SWITCH_POLICY
+/* API arg values for seL4_TCB_SetFPUPolicy. */
+typedef enum {
+    seL4_FPUPolicy_Lazy = 0,
+    seL4_FPUPolicy_Eager,
+    seL4_FPUPolicy_Adaptive,
+    SEL4_FORCE_LONG_ENUM(seL4_FPUPolicy)
+} seL4_FPUPolicy;
+#endif
+
 enum priorityConstants {
     seL4_InvalidPrio = -1,
     seL4_MinPrio = 0,
@@ -57,6 +67,22 @@ enum seL4_MsgLimits {
 enum {
     seL4_MsgMaxLength = 120,
 };
+
+/* Maximum number of VCPU registers or VMCS fields that a single batched VCPU
+ * invocation transfers. A batched write needs a count, the register IDs and
+ * the values in the message registers. */
+#define seL4_VCPUBatchMax 32
+SEL4_COMPILE_ASSERT(VCPUBatchMax_fits_message, 1 + 2 * seL4_VCPUBatchMax <= seL4_MsgMaxLength)
+
+/* VM exit statistics of a VCPU. Exits are counted by exit reason, which is the
+ * basic exit reason on x86 and the exception class on Arm. Reasons beyond the
+ * last slot are counted in the last slot. Histogram bucket i counts the exits
+ * that took [2^(i + shift), 2^(i + shift + 1)) timer ticks from the exit until
+ * the guest was resumed, the first and last buckets also count anything below
+ * and above. */
+#define seL4_VCPUExitReasons            64
+#define seL4_VCPUExitHistogramBuckets   16
+#define seL4_VCPUExitHistogramShift     4
 #define seL4_MsgMaxExtraCaps (LIBSEL4_BIT(seL4_MsgExtraCapBits)-1)
 
 /* seL4_CapRights_t defined in shared_types_*.bf */
@@ -74,11 +100,20 @@ typedef enum {
 
 #ifdef CONFIG_KERNEL_MCS
 /* Minimum size of a scheduling context (2^{n} bytes) */
+#if CONFIG_WORD_SIZE == 64
+#define seL4_MinSchedContextBits 8
+#else
 #define seL4_MinSchedContextBits 7
+#endif
 #ifndef __ASSEMBLER__
 /* The size of a scheduling context, including the minimum 2 refills, excluding
-   any extra refills (= 10 words, 2 tick_t, 2 refills (= 2 tick_t each)) */
-#define seL4_CoreSchedContextBytes (10 * sizeof(seL4_Word) + (6 * 8))
+   any extra refills (= 10 words, 3 tick_t, 2 refills (= 2 tick_t each)).
+   Scheduling context groups add another 4 words. */
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+#define seL4_CoreSchedContextBytes (14 * sizeof(seL4_Word) + (7 * 8))
+#else
+#define seL4_CoreSchedContextBytes (10 * sizeof(seL4_Word) + (7 * 8))
+#endif
 /* the size of a single extra refill */
 #define seL4_RefillSizeBytes (2 * 8)
 SEL4_COMPILE_ASSERT(MinSchedContextBits_min_1, seL4_MinSchedContextBits > 1)
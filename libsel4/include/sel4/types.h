@@ -43,6 +43,17 @@ typedef seL4_CPtr seL4_SchedControl;
 
 typedef seL4_Uint64 seL4_Time;
 
+/* Register IDs or values for the batched VCPU invocations. Only the first
+ * count entries are transferred. */
+typedef struct seL4_VCPUBatch_ {
+    seL4_Word words[seL4_VCPUBatchMax];
+} seL4_VCPUBatch;
+
+/* Exit latency histogram of one VM exit reason */
+typedef struct seL4_VCPUExitHistogram_ {
+    seL4_Word buckets[seL4_VCPUExitHistogramBuckets];
+} seL4_VCPUExitHistogram;
+
 #define seL4_NilData 0
 
 #include <sel4/arch/constants.h>
@@ -195,7 +195,12 @@ typedef enum {
 #define seL4_SuperSectionBits 25
 #define seL4_PageDirEntryBits 3
 #define seL4_PageDirIndexBits 11
+#ifdef CONFIG_VCPU_EXIT_STATS
+/* The VCPU additionally holds the VM exit statistics */
+#define seL4_VCPUBits 13
+#else
 #define seL4_VCPUBits 12
+#endif
 #else
 #define seL4_PageTableBits 10
 #define seL4_PageTableEntryBits 2
@@ -216,7 +221,11 @@ typedef enum {
 #endif
 #define seL4_ASIDPoolBits 12
 #define seL4_ASIDPoolIndexBits 10
+#ifdef CONFIG_VCPU_EXIT_STATS
+#define seL4_ARM_VCPUBits       13
+#else
 #define seL4_ARM_VCPUBits       12
+#endif
 #define seL4_IOPageTableBits    12
 
 /* bits in a word */
@@ -224,8 +224,21 @@ typedef enum {
 #define seL4_ARM_VSpaceObject seL4_ARM_PageGlobalDirectoryObject
 #endif
 
+#ifdef CONFIG_VCPU_EXIT_STATS
+/* The VCPU additionally holds the VM exit statistics */
+#define seL4_ARM_VCPUBits   13
+#define seL4_VCPUBits       13
+#else
 #define seL4_ARM_VCPUBits   12
 #define seL4_VCPUBits       12
+#endif
+
+#ifdef CONFIG_ARM_DIRTY_LOG
+/* Most pages covered by one seL4_ARM_VSpace_SetDirtyLog or
+ * seL4_ARM_VSpace_HarvestDirty call, which is one bit for every page in a 4K
+ * bitmap frame */
+#define seL4_ARM_DirtyLogMaxPages 32768
+#endif
 
 /* word size */
 #define seL4_WordBits (sizeof(seL4_Word) * 8)
@@ -73,8 +73,8 @@ WORD_CONST_SUFFIX_BITS = {
     64: "ull",
 }
 
-# Maximum number of words that will be in a message.
-MAX_MESSAGE_LENGTH = 64
+# Maximum number of words that will be in a message (seL4_MsgMaxLength).
+MAX_MESSAGE_LENGTH = 120
 
 # Headers to include
 INCLUDES = [
@@ -278,6 +278,8 @@ def init_arch_types(wordsize, args):
             CapType("seL4_ARM_VCPU", wordsize),
             CapType("seL4_ARM_IOSpace", wordsize),
             CapType("seL4_ARM_IOPageTable", wordsize),
+            StructType("seL4_VCPUBatch", wordsize * 32, wordsize),
+            StructType("seL4_VCPUExitHistogram", wordsize * 16, wordsize),
             StructType("seL4_UserContext", wordsize * 19, wordsize),
         ] + arm_smmu,
 
@@ -294,6 +296,8 @@ def init_arch_types(wordsize, args):
             CapType("seL4_ARM_VCPU", wordsize),
             CapType("seL4_ARM_IOSpace", wordsize),
             CapType("seL4_ARM_IOPageTable", wordsize),
+            StructType("seL4_VCPUBatch", wordsize * 32, wordsize),
+            StructType("seL4_VCPUExitHistogram", wordsize * 16, wordsize),
             StructType("seL4_UserContext", wordsize * 36, wordsize),
         ] + arm_smmu,
 
@@ -307,6 +311,8 @@ def init_arch_types(wordsize, args):
             CapType("seL4_ARM_VCPU", wordsize),
             CapType("seL4_ARM_IOSpace", wordsize),
             CapType("seL4_ARM_IOPageTable", wordsize),
+            StructType("seL4_VCPUBatch", wordsize * 32, wordsize),
+            StructType("seL4_VCPUExitHistogram", wordsize * 16, wordsize),
             StructType("seL4_UserContext", wordsize * 19, wordsize),
         ] + arm_smmu,
 
@@ -327,6 +333,8 @@ def init_arch_types(wordsize, args):
             CapType("seL4_X86_EPTPD", wordsize),
             CapType("seL4_X86_EPTPT", wordsize),
             StructType("seL4_VCPUContext", wordsize * 7, wordsize),
+            StructType("seL4_VCPUBatch", wordsize * 32, wordsize),
+            StructType("seL4_VCPUExitHistogram", wordsize * 16, wordsize),
             StructType("seL4_UserContext", wordsize * 12, wordsize),
         ],
 
@@ -350,6 +358,8 @@ def init_arch_types(wordsize, args):
             CapType("seL4_X86_EPTPT", wordsize),
             # VCPU size needs to be configuration dependent.
             StructType("seL4_VCPUContext", wordsize * (15 if args.x86_vtx_64bit else 7), wordsize),
+            StructType("seL4_VCPUBatch", wordsize * 32, wordsize),
+            StructType("seL4_VCPUExitHistogram", wordsize * 16, wordsize),
             StructType("seL4_UserContext", wordsize * 20, wordsize),
         ],
         "riscv32": [
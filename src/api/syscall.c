@@ -45,9 +45,47 @@ exception_t handleInterruptEntry(void)
     }
 #endif
 
+#if defined(CONFIG_IRQ_BATCHING) && defined(CONFIG_BENCHMARK_TRACK_UTILISATION)
+    NODE_STATE(benchmark_irq_entries)++;
+#endif
+
     irq = getActiveIRQ();
     if (IRQT_TO_IRQ(irq) != IRQT_TO_IRQ(irqInvalid)) {
         handleInterrupt(irq);
+#ifdef CONFIG_IRQ_BATCHING
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+        NODE_STATE(benchmark_irqs_handled)++;
+#endif
+        /* Handle interrupts that became pending in the meantime before
+         * returning to user level. Only a core holding the kernel lock may
+         * do so, and it leaves a remote call IPI pending for the next entry,
+         * which handles it without taking the lock. */
+        if (SMP_TERNARY(clh_is_self_in_queue(), 1)) {
+            for (word_t i = 1; i < CONFIG_IRQ_BATCH_BUDGET && isIRQPending(); i++) {
+#ifdef ENABLE_SMP_SUPPORT
+                if (isIPIPending(irq_remote_call_ipi)) {
+                    break;
+                }
+#endif
+                irq = getActiveIRQ();
+                if (IRQT_TO_IRQ(irq) == IRQT_TO_IRQ(irqInvalid)) {
+                    break;
+                }
+                handleInterrupt(irq);
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+                NODE_STATE(benchmark_irqs_handled)++;
+#endif
+#ifdef ENABLE_SMP_SUPPORT
+                /* A remote call IPI that arrived after the check above has
+                 * been acknowledged and handled already. Only the lock holder
+                 * sends remote calls, so it was a stale one. */
+                if (IRQT_TO_IRQ(irq) == irq_remote_call_ipi) {
+                    break;
+                }
+#endif
+            }
+        }
+#endif /* CONFIG_IRQ_BATCHING */
     } else {
 #ifdef CONFIG_IRQ_REPORTING
         userError("Spurious interrupt!");
@@ -45,6 +45,8 @@ pde_t armUSGlobalPD[BIT(PD_INDEX_BITS)] ALIGN_BSS(BIT(seL4_PageDirBits));;
 UP_STATE_DEFINE(vcpu_t, *armHSCurVCPU);
 /* Whether the current loaded VCPU is enabled in the hardware or not */
 UP_STATE_DEFINE(bool_t, armHSVCPUActive);
+/* List registers that may hold state in the hardware */
+UP_STATE_DEFINE(uint64_t, armHSVGICLRsInUse);
 
 #ifdef CONFIG_HAVE_FPU
 /* Whether the hyper-mode kernel is allowed to execute FPU instructions */
@@ -317,6 +317,26 @@ static BOOT_CODE void map_it_frame_cap(cap_t vspace_cap, cap_t frame_cap, bool_t
     assert(pude_pude_pd_ptr_get_present(pud));
     pd = paddr_to_pptr(pude_pude_pd_ptr_get_pd_base_address(pud));
     pd += GET_PD_INDEX(vptr);
+    if (cap_frame_cap_get_capFSize(frame_cap) == ARMLargePage) {
+        *pd = pde_pde_large_new(
+                  !executable,                    /* unprivileged execute never */
+                  pptr_to_paddr(pptr),            /* page_base_address    */
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+                  0,
+#else
+                  1,                              /* not global */
+#endif
+                  1,                              /* access flag */
+                  SMP_TERNARY(SMP_SHARE, 0),              /* Inner-shareable if SMP enabled, otherwise unshared */
+                  APFromVMRights(VMReadWrite),
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+                  S2_NORMAL
+#else
+                  NORMAL
+#endif
+              );
+        return;
+    }
     assert(pde_pde_small_ptr_get_present(pd));
     pt = paddr_to_pptr(pde_pde_small_ptr_get_pt_base_address(pd));
     *(pt + GET_PT_INDEX(vptr)) = pte_new(
@@ -463,7 +483,7 @@ BOOT_CODE word_t arch_get_n_paging(v_region_t it_v_reg)
         get_n_paging(it_v_reg, PGD_INDEX_OFFSET) +
 #endif
         get_n_paging(it_v_reg, PUD_INDEX_OFFSET) +
-        get_n_paging(it_v_reg, PD_INDEX_OFFSET);
+        get_n_paging(it_v_reg, PD_INDEX_OFFSET) - get_n_it_large_pages();
 }
 
 BOOT_CODE cap_t create_it_address_space(cap_t root_cnode_cap, v_region_t it_v_reg)
@@ -505,6 +525,9 @@ BOOT_CODE cap_t create_it_address_space(cap_t root_cnode_cap, v_region_t it_v_re
     for (vptr = ROUND_DOWN(it_v_reg.start, PD_INDEX_OFFSET);
          vptr < it_v_reg.end;
          vptr += BIT(PD_INDEX_OFFSET)) {
+        if (it_is_large_vptr(vptr)) {
+            continue;
+        }
         if (!provide_cap(root_cnode_cap, create_it_pt_cap(vspace_cap, it_alloc_paging(), vptr, IT_ASID))) {
             return cap_null_cap_new();
         }
@@ -549,11 +572,15 @@ BOOT_CODE void write_it_asid_pool(cap_t it_ap_cap, cap_t it_vspace_cap)
 #ifdef CONFIG_ARM_SMMU
                               /* bind_cb: Number of bound context banks */
                               0,
+#endif
+#ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
+                              /* stored_hw_vmid: Assigned hardware VMID for TLB. */
+                              0,
 #endif
                               /* vspace_root: reference to vspace root page table object */
                               (word_t)cap_vtable_root_get_basePtr(it_vspace_cap)
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
-                              /* stored_hw_vmid, stored_vmid_valid: Assigned hardware VMID for TLB. */
+                              /* stored_vmid_generation, stored_vmid_valid: VMID generation of stored_hw_vmid. */
                               , 0, false
 #endif
                           );
@@ -947,6 +974,16 @@ exception_t handleVMFault(tcb_t *thread, vm_fault_type_t vm_faultType)
         if (ARCH_NODE_STATE(armHSVCPUActive)) {
             addr = GET_PAR_ADDR(addressTranslateS1(addr)) | (addr & MASK(PAGE_BITS));
         }
+#endif
+#ifdef CONFIG_ARM_DIRTY_LOG
+        if (handleDirtyLogFault(thread, addr, fault)) {
+            return EXCEPTION_NONE;
+        }
+#endif
+#if defined(CONFIG_ARM_CONTIGUOUS_HINT) && defined(ENABLE_SMP_SUPPORT)
+        if (handleContiguousHintFault(thread, addr, fault)) {
+            return EXCEPTION_NONE;
+        }
 #endif
         current_fault = seL4_Fault_VMFault_new(addr, fault, false);
         return EXCEPTION_FAULT;
@@ -962,6 +999,11 @@ exception_t handleVMFault(tcb_t *thread, vm_fault_type_t vm_faultType)
         if (ARCH_NODE_STATE(armHSVCPUActive)) {
             pc = GET_PAR_ADDR(addressTranslateS1(pc)) | (pc & MASK(PAGE_BITS));
         }
+#endif
+#if defined(CONFIG_ARM_CONTIGUOUS_HINT) && defined(ENABLE_SMP_SUPPORT)
+        if (handleContiguousHintFault(thread, pc, fault)) {
+            return EXCEPTION_NONE;
+        }
 #endif
         current_fault = seL4_Fault_VMFault_new(pc, fault, true);
         return EXCEPTION_FAULT;
@@ -1102,37 +1144,108 @@ static void storeHWASID(asid_t asid, hw_asid_t hw_asid)
     assert(asid_map_get_type(*asid_map) == asid_map_asid_map_vspace);
 
     asid_map_asid_map_vspace_ptr_set_stored_hw_vmid(asid_map, hw_asid);
+    asid_map_asid_map_vspace_ptr_set_stored_vmid_generation(asid_map, armKSHWASIDGeneration);
     asid_map_asid_map_vspace_ptr_set_stored_vmid_valid(asid_map, true);
+}
 
-    armKSHWASIDTable[hw_asid] = asid;
+/* The ASID map entry of an ASID that holds a VMID of the current generation,
+ * or NULL. The ASID may have been deleted since a core recorded it. */
+static asid_map_t *findCurrentVMIDMapRef(asid_t asid)
+{
+    asid_pool_t *poolPtr;
+    asid_map_t *asid_map;
+
+    if (asid == asidInvalid) {
+        return NULL;
+    }
+    poolPtr = armKSASIDTable[asid >> asidLowBits];
+    if (poolPtr == NULL) {
+        return NULL;
+    }
+    asid_map = &poolPtr->array[asid & MASK(asidLowBits)];
+    if (asid_map_ptr_get_type(asid_map) != asid_map_asid_map_vspace || !isStoredVMIDValid(*asid_map)) {
+        return NULL;
+    }
+    return asid_map;
 }
 
-static hw_asid_t findFreeHWASID(void)
+static bool_t isHWASIDReserved(hw_asid_t hw_asid)
 {
-    word_t hw_asid_offset;
-    hw_asid_t hw_asid;
+    for (word_t core = 0; core < CONFIG_MAX_NUM_NODES; core++) {
+        asid_map_t *asid_map = findCurrentVMIDMapRef(ARCH_NODE_STATE_ON_CORE(armHSReservedASID, core));
+        if (asid_map != NULL && asid_map_asid_map_vspace_ptr_get_stored_hw_vmid(asid_map) == hw_asid) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    /* Find a free hardware ASID */
-    for (hw_asid_offset = 0;
-         hw_asid_offset <= (word_t)((hw_asid_t) - 1);
-         hw_asid_offset++) {
-        hw_asid = armKSNextASID + ((hw_asid_t)hw_asid_offset);
-        if (armKSHWASIDTable[hw_asid] == asidInvalid) {
-            return hw_asid;
+/* Start a new VMID generation once every VMID of the current one has been
+ * handed out. Address spaces keep the VMID of the old generation in their
+ * ASID map entry, and are given a new one when they are next switched to.
+ * The address spaces loaded on a core keep their VMID instead, which is
+ * reserved for them until the next rollover, so that they always hold a VMID
+ * of the current generation.
+ */
+static void rolloverHWASIDGeneration(void)
+{
+    hw_asid_t kept[CONFIG_MAX_NUM_NODES];
+
+    for (word_t core = 0; core < CONFIG_MAX_NUM_NODES; core++) {
+        asid_t asid = ARCH_NODE_STATE_ON_CORE(armHSActiveASID, core);
+        asid_map_t *asid_map = findCurrentVMIDMapRef(asid);
+        if (asid_map != NULL) {
+            kept[core] = asid_map_asid_map_vspace_ptr_get_stored_hw_vmid(asid_map);
+            ARCH_NODE_STATE_ON_CORE(armHSReservedASID, core) = asid;
+        } else {
+            ARCH_NODE_STATE_ON_CORE(armHSReservedASID, core) = asidInvalid;
         }
     }
 
-    hw_asid = armKSNextASID;
+    armKSHWASIDGeneration = (armKSHWASIDGeneration + 1) & MASK(HW_VMID_GENERATION_BITS);
 
-    /* If we've scanned the table without finding a free ASID */
-    invalidateASID(armKSHWASIDTable[hw_asid]);
+    if (unlikely(armKSHWASIDGeneration == 0)) {
+        /* The generation wrapped, so an old stored generation could match
+         * again. Invalidate every stored VMID instead. */
+        for (word_t i = 0; i < nASIDPools; i++) {
+            asid_pool_t *poolPtr = armKSASIDTable[i];
+            if (poolPtr == NULL) {
+                continue;
+            }
+            for (word_t j = 0; j < BIT(asidLowBits); j++) {
+                if (asid_map_get_type(poolPtr->array[j]) == asid_map_asid_map_vspace) {
+                    asid_map_asid_map_vspace_ptr_set_stored_vmid_valid(&poolPtr->array[j], false);
+                }
+            }
+        }
+    }
 
-    /* Flush TLB */
-    invalidateTranslationASID(hw_asid);
-    armKSHWASIDTable[hw_asid] = asidInvalid;
+    for (word_t core = 0; core < CONFIG_MAX_NUM_NODES; core++) {
+        asid_t asid = ARCH_NODE_STATE_ON_CORE(armHSReservedASID, core);
+        if (asid != asidInvalid) {
+            storeHWASID(asid, kept[core]);
+        }
+    }
 
-    /* Increment the NextASID index */
-    armKSNextASID++;
+    /* Flush the TLB entries of every VMID of the old generation */
+    invalidateTranslationAll();
+    armKSNextASID = 0;
+
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+    benchmark_hw_asid_rollovers++;
+#endif
+}
+
+static hw_asid_t findFreeHWASID(void)
+{
+    hw_asid_t hw_asid;
+
+    do {
+        if (unlikely(armKSNextASID == BIT(armKSHWASIDBits))) {
+            rolloverHWASIDGeneration();
+        }
+        hw_asid = armKSNextASID++;
+    } while (unlikely(isHWASIDReserved(hw_asid)));
 
     return hw_asid;
 }
@@ -1142,11 +1255,18 @@ hw_asid_t getHWASID(asid_t asid)
     asid_map_t asid_map;
 
     asid_map = findMapForASID(asid);
-    if (asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map)) {
+    if (isStoredVMIDValid(asid_map)) {
         return asid_map_asid_map_vspace_get_stored_hw_vmid(asid_map);
     } else {
         hw_asid_t new_hw_asid;
 
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+        if (asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map)) {
+            /* The VMID was retired by a rollover while still in use */
+            benchmark_hw_asid_evictions++;
+        }
+#endif
+
         new_hw_asid = findFreeHWASID();
         storeHWASID(asid, new_hw_asid);
         return new_hw_asid;
@@ -1155,13 +1275,7 @@ hw_asid_t getHWASID(asid_t asid)
 
 static void invalidateASIDEntry(asid_t asid)
 {
-    asid_map_t asid_map;
-
-    asid_map = findMapForASID(asid);
-    if (asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map)) {
-        armKSHWASIDTable[asid_map_asid_map_vspace_get_stored_hw_vmid(asid_map)] =
-            asidInvalid;
-    }
+    /* The VMID is not handed out again before the next rollover */
     invalidateASID(asid);
 }
 
@@ -1220,7 +1334,9 @@ static inline void invalidateTLBByASID(asid_t asid)
     asid_map_t asid_map;
 
     asid_map = findMapForASID(asid);
-    if (!asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map)) {
+    if (!isStoredVMIDValid(asid_map)) {
+        /* The rollover flushed the VMIDs of older generations, and an address
+         * space loaded on any core holds a VMID of the current one. */
         return;
     }
     invalidateTranslationASID(asid_map_asid_map_vspace_get_stored_hw_vmid(asid_map));
@@ -1241,7 +1357,8 @@ static inline void invalidateTLBByASIDVA(asid_t asid, vptr_t vaddr)
     asid_map_t asid_map;
 
     asid_map = findMapForASID(asid);
-    if (!asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map)) {
+    if (!isStoredVMIDValid(asid_map)) {
+        /* See invalidateTLBByASID */
         return;
     }
     uint64_t hw_asid = asid_map_asid_map_vspace_get_stored_hw_vmid(asid_map);
@@ -1251,6 +1368,345 @@ static inline void invalidateTLBByASIDVA(asid_t asid, vptr_t vaddr)
 #endif
 }
 
+#ifdef CONFIG_ARM_DIRTY_LOG
+/* Stage-2 page and block descriptor bits used for dirty logging. A logged
+ * descriptor has the software bit set and the write permission cleared until
+ * the page is written. With hardware dirty state management the DBM bit lets
+ * the hardware set the write permission itself. */
+#define S2AP_WRITE      BIT(7)
+#define DIRTY_LOG_DBM   BIT(51)
+#define DIRTY_LOG_SW    BIT(55)
+
+/* Data abort syndrome of a write that hit a permission fault at any level */
+#define ESR_WNR                 BIT(6)
+#define ESR_PERMISSION_FAULT(x) (((x) & 0x3c) == 0xc)
+#endif
+
+#ifdef CONFIG_ARM_CONTIGUOUS_HINT
+/* The contiguous hint of page and block descriptors. With a 4K granule it
+ * marks a naturally aligned run of 16 entries that map one physically
+ * contiguous region with the same attributes. */
+#define CONTIGUOUS_HINT BIT(52)
+#define CONTIGUOUS_RUN_BITS 4
+
+/* Changing the contiguous bit of valid descriptors requires break-before-make:
+ * the run is written invalid and cleaned to the point of unification, and the
+ * TLB entries for the ASID are invalidated before any new descriptor of the run
+ * is written. Other cores that touch the run in the meantime take translation
+ * faults, which handleContiguousHintFault retries. */
+static inline void clearContiguousRun(word_t *run)
+{
+    for (word_t i = 0; i < BIT(CONTIGUOUS_RUN_BITS); i++) {
+        run[i] = 0;
+    }
+    cleanCacheRange_PoU((word_t)run, (word_t)(run + BIT(CONTIGUOUS_RUN_BITS)) - 1, pptr_to_paddr(run));
+}
+
+/* Write the descriptors of a run that was made invalid by clearContiguousRun.
+ * The first descriptor is given, the others map the following pages. */
+static inline void writeContiguousRun(word_t *run, word_t first, word_t pageBits)
+{
+    for (word_t i = 0; i < BIT(CONTIGUOUS_RUN_BITS); i++) {
+        run[i] = first + (i << pageBits);
+    }
+    cleanCacheRange_PoU((word_t)run, (word_t)(run + BIT(CONTIGUOUS_RUN_BITS)) - 1, pptr_to_paddr(run));
+}
+
+/* Clear the hint from the run containing entry. This must be done before any
+ * entry of a run is changed, as the run would otherwise be inconsistent. */
+static void breakContiguousRun(word_t *entry, asid_t asid)
+{
+    word_t saved[BIT(CONTIGUOUS_RUN_BITS)];
+    word_t *run;
+
+    if (likely(!(*entry & CONTIGUOUS_HINT))) {
+        return;
+    }
+
+    run = (word_t *)ROUND_DOWN((word_t)entry, CONTIGUOUS_RUN_BITS + seL4_WordSizeBits);
+    for (word_t i = 0; i < BIT(CONTIGUOUS_RUN_BITS); i++) {
+        saved[i] = run[i] & ~CONTIGUOUS_HINT;
+    }
+    clearContiguousRun(run);
+    /* the run covers 16 pages, invalidate the whole ASID */
+    invalidateTLBByASID(asid);
+    for (word_t i = 0; i < BIT(CONTIGUOUS_RUN_BITS); i++) {
+        run[i] = saved[i];
+    }
+    cleanCacheRange_PoU((word_t)run, (word_t)(run + BIT(CONTIGUOUS_RUN_BITS)) - 1, pptr_to_paddr(run));
+}
+
+/* A run can be hinted if its entries are all valid descriptors of the given
+ * type that map consecutive pages of a naturally aligned region and only
+ * differ in their address. */
+static bool_t isContiguousRun(word_t *run, word_t pageBits, word_t type)
+{
+    word_t first = run[0] & ~CONTIGUOUS_HINT;
+
+    if ((first & MASK(2)) != type ||
+        !IS_ALIGNED((first & MASK(48)) >> pageBits, CONTIGUOUS_RUN_BITS)) {
+        return false;
+    }
+#ifdef CONFIG_ARM_DIRTY_LOG
+    /* The hardware may update the dirty state of logged pages at any time */
+    if (first & DIRTY_LOG_SW) {
+        return false;
+    }
+#endif
+    for (word_t i = 1; i < BIT(CONTIGUOUS_RUN_BITS); i++) {
+        if ((run[i] & ~CONTIGUOUS_HINT) != first + (i << pageBits)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static exception_t performContiguousHint(word_t *table, asid_t asid, word_t pageBits, word_t type)
+{
+    word_t first[BIT(PT_INDEX_BITS - CONTIGUOUS_RUN_BITS)];
+    word_t runs = 0;
+
+    /* break every run that gets the hint, then invalidate the TLB once */
+    for (word_t r = 0; r < BIT(PT_INDEX_BITS - CONTIGUOUS_RUN_BITS); r++) {
+        word_t *run = table + (r << CONTIGUOUS_RUN_BITS);
+        if ((run[0] & CONTIGUOUS_HINT) || !isContiguousRun(run, pageBits, type)) {
+            continue;
+        }
+        first[r] = run[0];
+        runs |= BIT(r);
+        clearContiguousRun(run);
+    }
+
+    if (runs == 0) {
+        return EXCEPTION_NONE;
+    }
+    invalidateTLBByASID(asid);
+
+    for (word_t r = 0; r < BIT(PT_INDEX_BITS - CONTIGUOUS_RUN_BITS); r++) {
+        if (runs & BIT(r)) {
+            writeContiguousRun(table + (r << CONTIGUOUS_RUN_BITS), first[r] | CONTIGUOUS_HINT, pageBits);
+        }
+    }
+
+    return EXCEPTION_NONE;
+}
+#endif /* CONFIG_ARM_CONTIGUOUS_HINT */
+
+#if defined(CONFIG_ARM_DIRTY_LOG) || (defined(CONFIG_ARM_CONTIGUOUS_HINT) && defined(ENABLE_SMP_SUPPORT))
+/* Find the page or block descriptor that maps vptr. If there is none, bits is
+ * set to the size of the unmapped region around vptr. */
+static word_t *lookupLeafEntry(vspace_root_t *vspace, vptr_t vptr, word_t *bits)
+{
+    lookupPUDSlot_ret_t pudSlot;
+    pde_t *pdSlot;
+    pte_t *ptSlot;
+
+    pudSlot = lookupPUDSlot(vspace, vptr);
+    if (pudSlot.status != EXCEPTION_NONE) {
+        *bits = PGD_INDEX_OFFSET;
+        return NULL;
+    }
+
+    *bits = PUD_INDEX_OFFSET;
+    if (pude_ptr_get_pude_type(pudSlot.pudSlot) == pude_pude_1g) {
+        return (word_t *)pudSlot.pudSlot;
+    }
+    if (pude_ptr_get_pude_type(pudSlot.pudSlot) != pude_pude_pd) {
+        return NULL;
+    }
+
+    pdSlot = (pde_t *)paddr_to_pptr(pude_pude_pd_ptr_get_pd_base_address(pudSlot.pudSlot)) + GET_PD_INDEX(vptr);
+    *bits = PD_INDEX_OFFSET;
+    if (pde_ptr_get_pde_type(pdSlot) == pde_pde_large) {
+        return (word_t *)pdSlot;
+    }
+    if (pde_ptr_get_pde_type(pdSlot) != pde_pde_small) {
+        return NULL;
+    }
+
+    ptSlot = (pte_t *)paddr_to_pptr(pde_pde_small_ptr_get_pt_base_address(pdSlot)) + GET_PT_INDEX(vptr);
+    *bits = PT_INDEX_OFFSET;
+    if (!pte_ptr_get_present(ptSlot)) {
+        return NULL;
+    }
+    return (word_t *)ptSlot;
+}
+#endif
+
+#if defined(CONFIG_ARM_CONTIGUOUS_HINT) && defined(ENABLE_SMP_SUPPORT)
+/* Fault status of a translation fault, the low two bits are the level */
+#define FSC_TRANSLATION_FAULT(x) (((x) & 0x3c) == 0x4)
+
+/* Another core may have made a contiguous run invalid while it changed the
+ * hint. It holds the kernel lock until the run is valid again, so a translation
+ * fault at the level of the page or block that now maps addr is retried
+ * instead of delivered. Runs only exist at the page directory and page table
+ * levels, so faults on addresses outside the VSpace are never retried. */
+bool_t handleContiguousHintFault(tcb_t *thread, vptr_t addr, word_t fsr)
+{
+    cap_t threadRoot;
+    word_t *entry;
+    word_t bits;
+
+    if (!FSC_TRANSLATION_FAULT(fsr) || (fsr & MASK(2)) < 2) {
+        return false;
+    }
+
+    threadRoot = TCB_PTR_CTE_PTR(thread, tcbVTable)->cap;
+    if (!isValidNativeRoot(threadRoot)) {
+        return false;
+    }
+
+    entry = lookupLeafEntry(VSPACE_PTR(cap_vtable_root_get_basePtr(threadRoot)), addr, &bits);
+    return entry != NULL && bits == ((fsr & MASK(2)) == 2 ? PD_INDEX_OFFSET : PT_INDEX_OFFSET);
+}
+#endif
+
+#ifdef CONFIG_ARM_DIRTY_LOG
+/* Whether the 1G region that contains vptr is mapped by a single 1G block */
+static bool_t hasHugeBlock(vspace_root_t *vspace, vptr_t vptr)
+{
+    word_t bits;
+
+    return lookupLeafEntry(vspace, vptr, &bits) != NULL && bits == PUD_INDEX_OFFSET;
+}
+
+static void storeDirtyLogEntry(word_t *entry, word_t value)
+{
+    *entry = value;
+    cleanByVA_PoU((vptr_t)entry, pptr_to_paddr(entry));
+}
+
+/* A write to a logged page that is still clean faults if the hardware does
+ * not manage the dirty state. Make the page writable and let the thread retry
+ * instead of delivering the fault. */
+bool_t handleDirtyLogFault(tcb_t *thread, vptr_t ipa, word_t esr)
+{
+    cap_t threadRoot;
+    vspace_root_t *vspaceRoot;
+    word_t *entry;
+    word_t bits;
+
+    if (!ESR_PERMISSION_FAULT(esr) || !(esr & ESR_WNR)) {
+        return false;
+    }
+
+    threadRoot = TCB_PTR_CTE_PTR(thread, tcbVTable)->cap;
+    if (!isValidNativeRoot(threadRoot)) {
+        return false;
+    }
+    vspaceRoot = VSPACE_PTR(cap_vtable_root_get_basePtr(threadRoot));
+
+    entry = lookupLeafEntry(vspaceRoot, ipa, &bits);
+    if (entry == NULL || (*entry & (DIRTY_LOG_SW | S2AP_WRITE)) != DIRTY_LOG_SW) {
+        return false;
+    }
+
+    storeDirtyLogEntry(entry, *entry | S2AP_WRITE);
+    invalidateTLBByASIDVA(cap_vtable_root_get_mappedASID(threadRoot), ipa);
+    return true;
+}
+
+/* Set the bits for the pages [first, first + count) in the dirty bitmap */
+static void setDirtyBits(word_t *bitmap, word_t first, word_t count)
+{
+    for (word_t i = first; i < first + count; i++) {
+        bitmap[i / wordBits] |= BIT(i % wordBits);
+    }
+}
+
+/* Apply one dirty log invocation to the pages [start, start + pages) of the
+ * VSpace. Returns the number of pages that were dirty for HarvestDirty. */
+static word_t performDirtyLogWalk(word_t invLabel, vspace_root_t *vspaceRoot, asid_t asid, vptr_t start,
+                                  word_t pages, bool_t enable, word_t *bitmap)
+{
+    bool_t tlbflush_required = false;
+    word_t dirty = 0;
+    word_t span;
+
+    for (word_t page = 0; page < pages; page += span) {
+        vptr_t vptr = start + (page << seL4_PageBits);
+        word_t *entry;
+        word_t bits;
+        word_t e;
+
+        entry = lookupLeafEntry(vspaceRoot, vptr, &bits);
+        span = MIN((BIT(bits) - (vptr & MASK(bits))) >> seL4_PageBits, pages - page);
+        if (entry == NULL) {
+            continue;
+        }
+
+        e = *entry;
+        if (invLabel == ARMVSpaceHarvestDirty) {
+            if ((e & (DIRTY_LOG_SW | S2AP_WRITE)) != (DIRTY_LOG_SW | S2AP_WRITE)) {
+                continue;
+            }
+            setDirtyBits(bitmap, page, span);
+            dirty += span;
+            /* A block that extends beyond the range stays dirty, as cleaning
+             * it would lose the writes to the pages outside the range */
+            if ((vptr & MASK(bits)) != 0 || span != BIT(bits - seL4_PageBits)) {
+                continue;
+            }
+            /* The hardware only ever sets the write permission, so nothing
+             * is lost by writing back the whole descriptor */
+            e &= ~S2AP_WRITE;
+        } else if (enable) {
+            if ((e & (DIRTY_LOG_SW | S2AP_WRITE)) != S2AP_WRITE) {
+                continue;
+            }
+#ifdef CONFIG_ARM_CONTIGUOUS_HINT
+            breakContiguousRun(entry, asid);
+            e = *entry;
+#endif
+            e = (e & ~S2AP_WRITE) | DIRTY_LOG_SW;
+            if (!armKSSWDirtyLog) {
+                e |= DIRTY_LOG_DBM;
+            }
+        } else {
+            if (!(e & DIRTY_LOG_SW)) {
+                continue;
+            }
+            e = (e | S2AP_WRITE) & ~(DIRTY_LOG_SW | DIRTY_LOG_DBM);
+        }
+        storeDirtyLogEntry(entry, e);
+        tlbflush_required = true;
+    }
+
+    if (tlbflush_required) {
+        invalidateTLBByASID(asid);
+    }
+
+    return dirty;
+}
+
+static exception_t performVSpaceSetDirtyLog(vspace_root_t *vspaceRoot, asid_t asid, vptr_t start, word_t pages,
+                                            bool_t enable)
+{
+    performDirtyLogWalk(ARMVSpaceSetDirtyLog, vspaceRoot, asid, start, pages, enable, NULL);
+    return EXCEPTION_NONE;
+}
+
+static exception_t performVSpaceHarvestDirty(vspace_root_t *vspaceRoot, asid_t asid, vptr_t start, word_t pages,
+                                             word_t *bitmap)
+{
+    word_t dirty;
+    tcb_t *thread;
+
+    memzero(bitmap, ROUND_UP(pages, wordRadix) / 8);
+    dirty = performDirtyLogWalk(ARMVSpaceHarvestDirty, vspaceRoot, asid, start, pages, false, bitmap);
+
+    thread = NODE_STATE(ksCurThread);
+    word_t *ipcBuffer = lookupIPCBuffer(true, thread);
+    setRegister(thread, badgeRegister, 0);
+    unsigned int length = setMR(thread, ipcBuffer, 0, dirty);
+    setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                    seL4_MessageInfo_new(0, 0, 0, length)));
+    setThreadState(thread, ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+#endif /* CONFIG_ARM_DIRTY_LOG */
+
 pde_t *pageTableMapped(asid_t asid, vptr_t vaddr, pte_t *pt)
 {
     findVSpaceForASID_ret_t find_ret;
@@ -1334,6 +1790,9 @@ void unmapPage(vm_page_size_t page_size, asid_t asid, vptr_t vptr, pptr_t pptr)
 
         if (pte_ptr_get_present(lu_ret.ptSlot) &&
             pte_ptr_get_page_base_address(lu_ret.ptSlot) == addr) {
+#ifdef CONFIG_ARM_CONTIGUOUS_HINT
+            breakContiguousRun((word_t *)lu_ret.ptSlot, asid);
+#endif
             *(lu_ret.ptSlot) = pte_invalid_new();
 
             cleanByVA_PoU((vptr_t)lu_ret.ptSlot, pptr_to_paddr(lu_ret.ptSlot));
@@ -1351,6 +1810,9 @@ void unmapPage(vm_page_size_t page_size, asid_t asid, vptr_t vptr, pptr_t pptr)
 
         if (pde_pde_large_ptr_get_present(lu_ret.pdSlot) &&
             pde_pde_large_ptr_get_page_base_address(lu_ret.pdSlot) == addr) {
+#ifdef CONFIG_ARM_CONTIGUOUS_HINT
+            breakContiguousRun((word_t *)lu_ret.pdSlot, asid);
+#endif
             *(lu_ret.pdSlot) = pde_invalid_new();
 
             cleanByVA_PoU((vptr_t)lu_ret.pdSlot, pptr_to_paddr(lu_ret.pdSlot));
@@ -1577,6 +2039,11 @@ static exception_t performLargePageInvocationMap(asid_t asid, cap_t cap, cte_t *
 {
     bool_t tlbflush_required = pde_pde_large_ptr_get_present(pdSlot);
 
+#ifdef CONFIG_ARM_CONTIGUOUS_HINT
+    if (tlbflush_required) {
+        breakContiguousRun((word_t *)pdSlot, asid);
+    }
+#endif
     ctSlot->cap = cap;
     *pdSlot = pde;
 
@@ -1594,6 +2061,11 @@ static exception_t performSmallPageInvocationMap(asid_t asid, cap_t cap, cte_t *
 {
     bool_t tlbflush_required = pte_ptr_get_present(ptSlot);
 
+#ifdef CONFIG_ARM_CONTIGUOUS_HINT
+    if (tlbflush_required) {
+        breakContiguousRun((word_t *)ptSlot, asid);
+    }
+#endif
     ctSlot->cap = cap;
     *ptSlot = pte;
 
@@ -1778,6 +2250,97 @@ static exception_t decodeARMVSpaceRootInvocation(word_t invLabel, unsigned int l
         setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
         return performVSpaceFlush(invLabel, vspaceRoot, asid, start, end - 1, pstart);
 
+#ifdef CONFIG_ARM_DIRTY_LOG
+    case ARMVSpaceSetDirtyLog:
+    case ARMVSpaceHarvestDirty: {
+        word_t pages;
+        cap_t bitmapCap = cap_null_cap_new();
+
+        if (length < 2 || (invLabel == ARMVSpaceSetDirtyLog && length < 3) ||
+            (invLabel == ARMVSpaceHarvestDirty && current_extra_caps.excaprefs[0] == NULL)) {
+            userError("VSpaceRoot DirtyLog: Truncated message.");
+            current_syscall_error.type = seL4_TruncatedMessage;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        start = getSyscallArg(0, buffer);
+        pages = getSyscallArg(1, buffer);
+
+        if (unlikely(!isValidNativeRoot(cap))) {
+            current_syscall_error.type = seL4_InvalidCapability;
+            current_syscall_error.invalidCapNumber = 0;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        vspaceRoot = cap_vtable_root_get_basePtr(cap);
+        asid = cap_vtable_root_get_mappedASID(cap);
+
+        find_ret = findVSpaceForASID(asid);
+        if (unlikely(find_ret.status != EXCEPTION_NONE)) {
+            userError("VSpaceRoot DirtyLog: No VSpace for ASID");
+            current_syscall_error.type = seL4_FailedLookup;
+            current_syscall_error.failedLookupWasSource = false;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        if (unlikely(find_ret.vspace_root != vspaceRoot)) {
+            userError("VSpaceRoot DirtyLog: Invalid VSpace Cap");
+            current_syscall_error.type = seL4_InvalidCapability;
+            current_syscall_error.invalidCapNumber = 0;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        if (invLabel == ARMVSpaceHarvestDirty) {
+            bitmapCap = current_extra_caps.excaprefs[0]->cap;
+            if (cap_get_capType(bitmapCap) != cap_frame_cap ||
+                cap_frame_cap_get_capFIsDevice(bitmapCap) ||
+                cap_frame_cap_get_capFVMRights(bitmapCap) != VMReadWrite) {
+                userError("VSpaceRoot HarvestDirty: Bitmap must be a writable frame of memory.");
+                current_syscall_error.type = seL4_InvalidCapability;
+                current_syscall_error.invalidCapNumber = 1;
+                return EXCEPTION_SYSCALL_ERROR;
+            }
+        }
+
+        if (!IS_ALIGNED(start, seL4_PageBits)) {
+            userError("VSpaceRoot DirtyLog: Start address must be page aligned.");
+            current_syscall_error.type = seL4_AlignmentError;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        /* The smallest frame holds a bit for each of the most pages we allow */
+        compile_assert(dirty_log_bitmap_fits, seL4_ARM_DirtyLogMaxPages <= BIT(seL4_PageBits + 3))
+        if (pages == 0 || pages > seL4_ARM_DirtyLogMaxPages ||
+            start > USER_TOP || start + (pages << seL4_PageBits) - 1 > USER_TOP) {
+            userError("VSpaceRoot DirtyLog: Invalid range.");
+            current_syscall_error.type = seL4_RangeError;
+            current_syscall_error.rangeErrorMin = 1;
+            current_syscall_error.rangeErrorMax = seL4_ARM_DirtyLogMaxPages;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        /* A call can never cover all of a 1G block, so it could never be
+         * marked clean again. The range spans at most two 1G regions. */
+        if (invLabel == ARMVSpaceHarvestDirty || getSyscallArg(2, buffer) != 0) {
+            for (vptr_t vptr = start; vptr - start < (pages << seL4_PageBits);
+                 vptr = (vptr | MASK(PUD_INDEX_OFFSET)) + 1) {
+                if (hasHugeBlock(vspaceRoot, vptr)) {
+                    userError("VSpaceRoot DirtyLog: Range contains a 1G block.");
+                    current_syscall_error.type = seL4_IllegalOperation;
+                    return EXCEPTION_SYSCALL_ERROR;
+                }
+            }
+        }
+
+        if (invLabel == ARMVSpaceSetDirtyLog) {
+            setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+            return performVSpaceSetDirtyLog(vspaceRoot, asid, start, pages, getSyscallArg(2, buffer) != 0);
+        }
+        return performVSpaceHarvestDirty(vspaceRoot, asid, start, pages,
+                                         (word_t *)cap_frame_cap_get_capFBasePtr(bitmapCap));
+    }
+#endif
+
     default:
         current_syscall_error.type = seL4_IllegalOperation;
         return EXCEPTION_SYSCALL_ERROR;
@@ -1893,6 +2456,23 @@ static exception_t decodeARMPageDirectoryInvocation(word_t invLabel, unsigned in
         return performPageDirectoryInvocationUnmap(cap, cte);
     }
 
+#ifdef CONFIG_ARM_CONTIGUOUS_HINT
+    if (invLabel == ARMPageDirectoryContiguousHint) {
+        pde_t *pd = PDE_PTR(cap_page_directory_cap_get_capPDBasePtr(cap));
+        asid = cap_page_directory_cap_get_capPDMappedASID(cap);
+        vaddr = cap_page_directory_cap_get_capPDMappedAddress(cap);
+
+        if (unlikely(!cap_page_directory_cap_get_capPDIsMapped(cap) || !pageDirectoryMapped(asid, vaddr, pd))) {
+            userError("PageDirectory ContiguousHint: Page directory is not mapped.");
+            current_syscall_error.type = seL4_IllegalOperation;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+        return performContiguousHint((word_t *)pd, asid, seL4_LargePageBits, pde_pde_large);
+    }
+#endif
+
     if (unlikely(invLabel != ARMPageDirectoryMap)) {
         current_syscall_error.type = seL4_IllegalOperation;
         return EXCEPTION_SYSCALL_ERROR;
@@ -1985,6 +2565,23 @@ static exception_t decodeARMPageTableInvocation(word_t invLabel, unsigned int le
         return performPageTableInvocationUnmap(cap, cte);
     }
 
+#ifdef CONFIG_ARM_CONTIGUOUS_HINT
+    if (invLabel == ARMPageTableContiguousHint) {
+        pte_t *pt = PTE_PTR(cap_page_table_cap_get_capPTBasePtr(cap));
+        asid = cap_page_table_cap_get_capPTMappedASID(cap);
+        vaddr = cap_page_table_cap_get_capPTMappedAddress(cap);
+
+        if (unlikely(!cap_page_table_cap_get_capPTIsMapped(cap) || !pageTableMapped(asid, vaddr, pt))) {
+            userError("PageTable ContiguousHint: Page table is not mapped.");
+            current_syscall_error.type = seL4_IllegalOperation;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+        return performContiguousHint((word_t *)pt, asid, seL4_PageBits, RESERVED);
+    }
+#endif
+
     if (unlikely(invLabel != ARMPageTableMap)) {
         current_syscall_error.type = seL4_IllegalOperation;
         return EXCEPTION_SYSCALL_ERROR;
@@ -2444,6 +3041,74 @@ void kernelDataAbort(word_t pc)
 }
 #endif /* CONFIG_DEBUG_BUILD */
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+bool_t Arch_checkGrantFrame(cap_t cap, tcb_t *receiver, vptr_t vaddr, bool_t replacing)
+{
+    cap_t threadRoot = TCB_PTR_CTE_PTR(receiver, tcbVTable)->cap;
+    vm_page_size_t frameSize = cap_frame_cap_get_capFSize(cap);
+
+    if (unlikely(!isValidNativeRoot(threadRoot) || !IS_PAGE_ALIGNED(vaddr, frameSize) ||
+                 vaddr + BIT(pageBitsForSize(frameSize)) - 1 > USER_TOP)) {
+        return false;
+    }
+
+    vspace_root_t *vspaceRoot = cap_vtable_root_get_basePtr(threadRoot);
+    cap_t grantCap = TCB_PTR_CTE_PTR(receiver, tcbGrantFrame)->cap;
+    replacing = replacing && cap_frame_cap_get_capFMappedASID(grantCap) == cap_vtable_root_get_mappedASID(threadRoot);
+
+    /* The window must be backed by page tables for this frame size, and must
+     * not be mapped by anything but the previous grant */
+    if (frameSize == ARMSmallPage) {
+        lookupPTSlot_ret_t lu_ret = lookupPTSlot(vspaceRoot, vaddr);
+        return lu_ret.status == EXCEPTION_NONE && (replacing || !pte_ptr_get_present(lu_ret.ptSlot));
+    } else if (frameSize == ARMLargePage) {
+        lookupPDSlot_ret_t lu_ret = lookupPDSlot(vspaceRoot, vaddr);
+        return lu_ret.status == EXCEPTION_NONE && pde_ptr_get_pde_type(lu_ret.pdSlot) != pde_pde_small &&
+               (replacing || pde_ptr_get_pde_type(lu_ret.pdSlot) != pde_pde_large);
+    } else {
+        lookupPUDSlot_ret_t lu_ret = lookupPUDSlot(vspaceRoot, vaddr);
+        return lu_ret.status == EXCEPTION_NONE && pude_ptr_get_pude_type(lu_ret.pudSlot) != pude_pude_pd &&
+               (replacing || pude_ptr_get_pude_type(lu_ret.pudSlot) == pude_pude_invalid);
+    }
+}
+
+void Arch_mapGrantFrame(cap_t cap, cte_t *srcSlot, tcb_t *receiver, vptr_t vaddr)
+{
+    cap_t threadRoot = TCB_PTR_CTE_PTR(receiver, tcbVTable)->cap;
+    vm_page_size_t frameSize = cap_frame_cap_get_capFSize(cap);
+    cte_t *grantSlot = TCB_PTR_CTE_PTR(receiver, tcbGrantFrame);
+    vspace_root_t *vspaceRoot = cap_vtable_root_get_basePtr(threadRoot);
+    asid_t asid = cap_vtable_root_get_mappedASID(threadRoot);
+    vm_rights_t vmRights = cap_frame_cap_get_capFVMRights(cap);
+    vm_attributes_t attributes = vm_attributes_new(true, false, !cap_frame_cap_get_capFIsDevice(cap));
+    paddr_t base = pptr_to_paddr((void *)cap_frame_cap_get_capFBasePtr(cap));
+
+    cap = cap_frame_cap_set_capFMappedASID(cap, asid);
+    cap = cap_frame_cap_set_capFMappedAddress(cap, vaddr);
+
+    if (frameSize == ARMSmallPage) {
+        lookupPTSlot_ret_t lu_ret = lookupPTSlot(vspaceRoot, vaddr);
+        assert(lu_ret.status == EXCEPTION_NONE && !pte_ptr_get_present(lu_ret.ptSlot));
+        cteInsert(cap, srcSlot, grantSlot);
+        performSmallPageInvocationMap(asid, cap, grantSlot,
+                                      makeUser3rdLevel(base, vmRights, attributes), lu_ret.ptSlot);
+    } else if (frameSize == ARMLargePage) {
+        lookupPDSlot_ret_t lu_ret = lookupPDSlot(vspaceRoot, vaddr);
+        assert(lu_ret.status == EXCEPTION_NONE && pde_ptr_get_pde_type(lu_ret.pdSlot) != pde_pde_large &&
+               pde_ptr_get_pde_type(lu_ret.pdSlot) != pde_pde_small);
+        cteInsert(cap, srcSlot, grantSlot);
+        performLargePageInvocationMap(asid, cap, grantSlot,
+                                      makeUser2ndLevel(base, vmRights, attributes), lu_ret.pdSlot);
+    } else {
+        lookupPUDSlot_ret_t lu_ret = lookupPUDSlot(vspaceRoot, vaddr);
+        assert(lu_ret.status == EXCEPTION_NONE && pude_ptr_get_pude_type(lu_ret.pudSlot) == pude_pude_invalid);
+        cteInsert(cap, srcSlot, grantSlot);
+        performHugePageInvocationMap(asid, cap, grantSlot,
+                                     makeUser1stLevel(base, vmRights, attributes), lu_ret.pudSlot);
+    }
+}
+#endif /* CONFIG_IPC_FRAME_GRANT */
+
 #ifdef CONFIG_PRINTING
 typedef struct readWordFromVSpace_ret {
     exception_t status;
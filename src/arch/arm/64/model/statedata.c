@@ -100,13 +100,27 @@ compile_assert(log_pde_is_correct_preallocated_pde,
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
 UP_STATE_DEFINE(vcpu_t, *armHSCurVCPU);
 UP_STATE_DEFINE(bool_t, armHSVCPUActive);
+/* List registers that may hold state in the hardware */
+UP_STATE_DEFINE(uint64_t, armHSVGICLRsInUse);
+UP_STATE_DEFINE(asid_t, armHSActiveASID);
+UP_STATE_DEFINE(asid_t, armHSReservedASID);
 
-/* The hardware VMID to virtual ASID mapping table.
- * The ARMv8 supports 8-bit VMID which is used as logical ASID
- * when the kernel runs in EL2.
+/* The hardware VMID allocator. VMIDs are used as logical ASIDs when the
+ * kernel runs in EL2. They are 8 or 16 bits wide, depending on the hardware,
+ * and are handed out in order within a generation.
  */
-asid_t armKSHWASIDTable[BIT(hwASIDBits)];
-hw_asid_t armKSNextASID;
+word_t armKSNextASID;
+word_t armKSHWASIDBits;
+word_t armKSHWASIDGeneration;
+#ifdef CONFIG_ARM_DIRTY_LOG
+/* Set if any core lacks hardware management of the stage-2 dirty state, in
+ * which case the kernel makes logged pages writable on write faults */
+bool_t armKSSWDirtyLog;
+#endif
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+timestamp_t benchmark_hw_asid_rollovers;
+timestamp_t benchmark_hw_asid_evictions;
+#endif
 #endif
 
 #ifdef CONFIG_ARM_SMMU
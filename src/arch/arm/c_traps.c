@@ -81,6 +81,9 @@ static inline void NORETURN c_handle_vm_fault(vm_fault_type_t type)
     ksKernelEntry.word = getRegister(NODE_STATE(ksCurThread), NextIP);
     ksKernelEntry.is_fastpath = false;
 #endif
+#ifdef CONFIG_VCPU_EXIT_STATS
+    recordVCPUExit(type == seL4_DataFault ? HSR_EC_DABT_LOW : HSR_EC_IABT_LOW);
+#endif
 
 #ifdef CONFIG_EXCEPTION_FASTPATH
     fastpath_vm_fault(type);
@@ -111,6 +114,9 @@ void VISIBLE NORETURN c_handle_interrupt(void)
     ksKernelEntry.word = IRQT_TO_IRQ(getActiveIRQ());
     ksKernelEntry.core = CURRENT_CPU_INDEX();
 #endif
+#ifdef CONFIG_VCPU_EXIT_STATS
+    recordVCPUExit(seL4_ARM_VCPUExit_Interrupt);
+#endif
 
     handleInterruptEntry();
     restore_user_context();
@@ -220,7 +226,15 @@ VISIBLE NORETURN void c_handle_vcpu_fault(word_t hsr)
 
 #ifdef TRACK_KERNEL_ENTRIES
     ksKernelEntry.path = Entry_VCPUFault;
+#ifdef CONFIG_VCPU_EXIT_STATS
+    /* the exception class does not fit next to the syndrome in the log */
+    ksKernelEntry.word = hsr >> HSR_EC_SHIFT;
+#else
     ksKernelEntry.word = hsr;
+#endif
+#endif
+#ifdef CONFIG_VCPU_EXIT_STATS
+    recordVCPUExit(hsr >> HSR_EC_SHIFT);
 #endif
     handleVCPUFault(hsr);
     restore_user_context();
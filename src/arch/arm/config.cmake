@@ -91,6 +91,94 @@ config_option(
 
 config_option(KernelArmGicV3 ARM_GIC_V3_SUPPORT "Build support for GICv3" DEFAULT OFF)
 
+config_option(
+    KernelArmGicV3ITS ARM_GIC_V3_ITS
+    "Build support for the GICv3 Interrupt Translation Service (ITS). This enables LPIs and \
+    adds the seL4_IRQControl_GetLPI invocation, which translates a message-signalled \
+    interrupt from a device ID and event ID into an LPI with its own IRQ handler. The LPI \
+    configuration, pending and ITS tables are statically allocated in the kernel image."
+    DEFAULT OFF
+    DEPENDS "KernelArmGicV3; KernelSel4ArchAarch64; NOT KernelVerificationBuild"
+)
+
+config_string(
+    KernelArmGicV3ITSNumLPIs ARM_GIC_V3_ITS_NUM_LPIS
+    "Number of LPIs that can be handed out through seL4_IRQControl_GetLPI. LPI n is given \
+    the IRQ number maxIRQ + 1 + n."
+    DEFAULT 256
+    DEPENDS "KernelArmGicV3ITS" UNDEF_DISABLED
+    UNQUOTE
+)
+
+config_string(
+    KernelArmGicV3ITSDeviceBits ARM_GIC_V3_ITS_DEVICE_BITS
+    "Number of device ID bits covered by the ITS device table. Device IDs must be smaller \
+    than 2^KernelArmGicV3ITSDeviceBits."
+    DEFAULT 8
+    DEPENDS "KernelArmGicV3ITS" UNDEF_DISABLED
+    UNQUOTE
+)
+
+config_string(
+    KernelArmGicV3ITSEventBits ARM_GIC_V3_ITS_EVENT_BITS
+    "Number of event ID bits per device. Event IDs must be smaller than \
+    2^KernelArmGicV3ITSEventBits."
+    DEFAULT 5
+    DEPENDS "KernelArmGicV3ITS" UNDEF_DISABLED
+    UNQUOTE
+)
+
+config_string(
+    KernelArmGicV3ITSMaxDevices ARM_GIC_V3_ITS_MAX_DEVICES
+    "Number of devices that can have LPIs mapped at the same time. The kernel reserves \
+    one interrupt translation table per device."
+    DEFAULT 16
+    DEPENDS "KernelArmGicV3ITS" UNDEF_DISABLED
+    UNQUOTE
+)
+
+config_option(
+    KernelArmGicV4 ARM_GIC_V4
+    "Build support for GICv4 direct injection of virtual LPIs. A VCPU can then be given \
+    a virtual PE, and seL4_ARM_VCPU_BindVLPI retargets the ITS translation of an LPI so \
+    that the interrupt is delivered straight to the guest without a VMM round trip. The \
+    LPI itself becomes the doorbell that is signalled while the VCPU is not running. On \
+    hardware without GICv4 the invocation fails and seL4_ARM_VCPU_InjectIRQ keeps working."
+    DEFAULT OFF
+    DEPENDS "KernelArmGicV3ITS; KernelArmHypervisorSupport"
+)
+
+config_string(
+    KernelArmGicV4NumVPEs ARM_GIC_V4_NUM_VPES
+    "Number of VCPUs that can have virtual LPIs bound at the same time. Each one needs a \
+    64KiB-aligned virtual pending table in the kernel image."
+    DEFAULT 4
+    DEPENDS "KernelArmGicV4" UNDEF_DISABLED
+    UNQUOTE
+)
+
+config_option(
+    KernelArmContiguousHint ARM_CONTIGUOUS_HINT
+    "Add the ContiguousHint invocations on AArch64 page tables and page directories. \
+    They set the contiguous bit on every aligned run of 16 entries that map one physically \
+    contiguous region with the same attributes, so that the run can be held by a single \
+    TLB entry (64KiB for pages, 32MiB for large pages). The bit is cleared from a run \
+    before any of its entries is changed."
+    DEFAULT OFF
+    DEPENDS "KernelSel4ArchAarch64; NOT KernelVerificationBuild"
+)
+
+config_option(
+    KernelArmDirtyLog ARM_DIRTY_LOG
+    "Add the SetDirtyLog and HarvestDirty invocations on AArch64 VSpaces for tracking \
+    writes to guest memory. Logged pages are mapped read-only in stage 2 until they are \
+    written. Where all cores support hardware management of dirty state (FEAT_HAFDBS) the \
+    hardware makes a page writable on the first write, otherwise the kernel does so on the \
+    permission fault without delivering the fault."
+    DEFAULT OFF
+    DEPENDS "KernelSel4ArchAarch64; KernelArmHypervisorSupport; NOT KernelVerificationBuild"
+)
+
 if(KernelArmPASizeBits40 AND ARM_HYPERVISOR_SUPPORT)
     config_set(KernelAarch64VspaceS2StartL1 AARCH64_VSPACE_S2_START_L1 "ON")
 else()
@@ -347,6 +347,9 @@ static BOOT_CODE bool_t try_init_kernel(
         .start = ui_p_reg_start - pv_offset,
         .end   = ui_p_reg_end   - pv_offset
     };
+#ifdef CONFIG_ROOTSERVER_LARGE_PAGES
+    init_it_large_v_reg(ui_v_reg, pv_offset);
+#endif
 
     ipcbuf_vptr = ui_v_reg.end;
     bi_frame_vptr = ipcbuf_vptr + BIT(PAGE_BITS);
@@ -38,6 +38,137 @@ word_t active_irq[CONFIG_MAX_NUM_NODES] = {IRQ_NONE};
 volatile struct gic_rdist_map *gic_rdist_map[CONFIG_MAX_NUM_NODES] = { 0 };
 volatile struct gic_rdist_sgi_ppi_map *gic_rdist_sgi_ppi_map[CONFIG_MAX_NUM_NODES] = { 0 };
 
+#ifdef CONFIG_ARM_GIC_V3_ITS
+/* LPIs handed out by the kernel have INTIDs from LPI_START to BIT(GIC_LPI_ID_BITS) - 1 */
+#define GIC_LPI_ID_BITS             14
+#define GIC_LPI_PROP_SIZE           (BIT(GIC_LPI_ID_BITS) - LPI_START)
+#define GIC_LPI_PEND_SIZE           (BIT(GIC_LPI_ID_BITS) / 8)
+#define GIC_LPI_PROP_RES1           BIT(1)
+#define GIC_LPI_PROP_ENABLE         BIT(0)
+compile_assert(gic_lpi_id_bits, CONFIG_ARM_GIC_V3_ITS_NUM_LPIS <= GIC_LPI_PROP_SIZE)
+
+/* All GIC tables live in kernel memory: inner shareable, write-back cacheable */
+#define GIC_TABLE_SHAREABLE         (1ull << 10)
+#define GICR_TABLE_CACHE_WB         (7ull << 7)
+#define GICR_PENDBASER_PTZ          BIT(62)
+#define GITS_TABLE_CACHE_WB         (7ull << 59)
+#define GITS_TABLE_PAGE_BITS        16
+
+#define GITS_CTLR_ENABLED           BIT(0)
+#define GITS_CTLR_QUIESCENT         BIT(31)
+#define GITS_TYPER_ITT_ENTRY_SIZE(t) ((((t) >> 4) & 0xf) + 1)
+#define GITS_TYPER_ID_BITS(t)       ((((t) >> 8) & 0x1f) + 1)
+#define GITS_TYPER_DEV_BITS(t)      ((((t) >> 13) & 0x1f) + 1)
+#define GITS_TYPER_PTA              BIT(19)
+#define GITS_TYPER_VIRTUAL          BIT(1)
+#define GITS_VALID                  BIT(63)
+#define GITS_BASER_TYPE(b)          (((b) >> 56) & 0x7)
+#define GITS_BASER_ENTRY_SIZE(b)    ((((b) >> 48) & 0x1f) + 1)
+#define GITS_BASER_PAGE_BITS(b)     (12 + 2 * (((b) >> 8) & 0x3))
+#define GITS_BASER_PAGE_SIZE_64K    (2ull << 8)
+#define GITS_BASER_PAGE_SIZE_MASK   (3ull << 8)
+#define GITS_BASER_TYPE_DEVICE      1
+#define GITS_BASER_TYPE_VPE         2
+#define GITS_BASER_TYPE_COLLECTION  4
+#define GITS_BASER_MAX_ENTRY_SIZE   32
+#define GITS_BASER_MAX_PAGES        256
+#define GITS_CREADR_STALLED         BIT(0)
+#define GITS_CMD_OFFSET(r)          ((r) & MASK(20) & ~MASK(5))
+
+#define GITS_CMD_SYNC               0x05
+#define GITS_CMD_MAPD               0x08
+#define GITS_CMD_MAPC               0x09
+#define GITS_CMD_MAPTI              0x0a
+#define GITS_CMD_INV                0x0c
+#define GITS_CMD_DISCARD            0x0f
+#define GITS_CMD_VMOVP              0x22
+#define GITS_CMD_VSYNC              0x25
+#define GITS_CMD_VMAPP              0x29
+#define GITS_CMD_VMAPTI             0x2a
+
+/* All LPIs are delivered through collection 0, which targets the boot core */
+#define GITS_ICID                   0
+
+#define GITS_MAX_ITT_ENTRY_SIZE     16
+#define GITS_ITT_ALIGN_BITS         8
+#define GITS_ITT_SIZE \
+    ROUND_UP(BIT(CONFIG_ARM_GIC_V3_ITS_EVENT_BITS) * GITS_MAX_ITT_ENTRY_SIZE, GITS_ITT_ALIGN_BITS)
+#define GITS_DEVICE_TABLE_SIZE \
+    ROUND_UP(BIT(CONFIG_ARM_GIC_V3_ITS_DEVICE_BITS) * GITS_BASER_MAX_ENTRY_SIZE, GITS_TABLE_PAGE_BITS)
+
+typedef struct its_cmd {
+    uint64_t raw[4];
+} its_cmd_t;
+
+#define GITS_CMD_QUEUE_ENTRIES      (BIT(PAGE_BITS) / sizeof(its_cmd_t))
+#define GITS_VLPI_UNMAP_CMDS        3
+
+volatile struct gic_its_map *const gic_its = (volatile struct gic_its_map *)(GITS_PPTR);
+bool_t gic_its_enabled;
+
+static uint8_t gic_lpi_prop_table[GIC_LPI_PROP_SIZE] ALIGN(BIT(PAGE_BITS));
+/* The pending table address has to be 64KiB aligned */
+static uint8_t gic_lpi_pend_table[CONFIG_MAX_NUM_NODES][ROUND_UP(GIC_LPI_PEND_SIZE, 16)] ALIGN(BIT(16));
+
+static its_cmd_t its_cmd_queue[GITS_CMD_QUEUE_ENTRIES] ALIGN(BIT(PAGE_BITS));
+static word_t its_cmd_next;
+static uint8_t its_device_table[GITS_DEVICE_TABLE_SIZE] ALIGN(BIT(GITS_TABLE_PAGE_BITS));
+static uint8_t its_collection_table[BIT(GITS_TABLE_PAGE_BITS)] ALIGN(BIT(GITS_TABLE_PAGE_BITS));
+static uint8_t its_itt[CONFIG_ARM_GIC_V3_ITS_MAX_DEVICES][GITS_ITT_SIZE] ALIGN(BIT(GITS_ITT_ALIGN_BITS));
+/* Target of collection 0, already shifted into the RDbase field of a command */
+static uint64_t its_rdbase;
+/* Physical address of the redistributor region, for ITSs that target them by address */
+static paddr_t its_gicr_paddr;
+
+/* Which device owns each ITT. ITTs stay with their device once mapped. */
+static struct {
+    word_t device_id;
+    bool_t used;
+} its_itt_owner[CONFIG_ARM_GIC_V3_ITS_MAX_DEVICES];
+
+/* Which device and event each LPI is translated from */
+static struct {
+    word_t device_id;
+    word_t event_id;
+    bool_t mapped;
+#ifdef CONFIG_ARM_GIC_V4
+    /* vPE the event is translated to, or GIC_VPE_NONE for the physical LPI */
+    word_t vpe;
+#endif
+} its_lpi_map[CONFIG_ARM_GIC_V3_ITS_NUM_LPIS];
+
+compile_assert(gic_its_device_table_pages,
+               GITS_DEVICE_TABLE_SIZE <= GITS_BASER_MAX_PAGES * BIT(GITS_TABLE_PAGE_BITS))
+compile_assert(gic_its_collection_table_size,
+               CONFIG_MAX_NUM_NODES * GITS_BASER_MAX_ENTRY_SIZE <= BIT(GITS_TABLE_PAGE_BITS))
+#endif /* CONFIG_ARM_GIC_V3_ITS */
+
+#ifdef CONFIG_ARM_GIC_V4
+#define GIC_VLPI_PROP_SIZE          (BIT(GIC_VLPI_ID_BITS) - LPI_START)
+#define GIC_VLPI_PEND_SIZE          (BIT(GIC_VLPI_ID_BITS) / 8)
+#define GICR_VLPI_FRAME_OFFSET      (2 * RDIST_BANK_SZ)
+#define GICR_VPENDBASER_VALID       BIT(63)
+#define GICR_VPENDBASER_DIRTY       BIT(60)
+#define GICR_VPENDBASER_PA_MASK     (MASK(52) & ~MASK(16))
+
+bool_t gic_vlpi_enabled;
+
+/* Every vPE shares one virtual configuration table, which enables all vLPIs at
+ * the same priority. The pending tables are per vPE and have to be 64KiB aligned. */
+static uint8_t gic_vlpi_prop_table[GIC_VLPI_PROP_SIZE] ALIGN(BIT(PAGE_BITS));
+static uint8_t gic_vlpi_pend_table[CONFIG_ARM_GIC_V4_NUM_VPES][ROUND_UP(GIC_VLPI_PEND_SIZE, 16)] ALIGN(BIT(16));
+static uint8_t its_vpe_table[BIT(GITS_TABLE_PAGE_BITS)] ALIGN(BIT(GITS_TABLE_PAGE_BITS));
+
+/* Allocation state of each vPE and the core whose redistributor it is mapped to */
+static struct {
+    word_t core;
+    bool_t used;
+} gic_vpe_state[CONFIG_ARM_GIC_V4_NUM_VPES];
+
+compile_assert(gic_its_vpe_table_size,
+               CONFIG_ARM_GIC_V4_NUM_VPES * GITS_BASER_MAX_ENTRY_SIZE <= BIT(GITS_TABLE_PAGE_BITS))
+#endif /* CONFIG_ARM_GIC_V4 */
+
 #ifdef CONFIG_ARCH_AARCH64
 #define MPIDR_AFF0(x) (x & 0xff)
 #define MPIDR_AFF1(x) ((x >> 8) & 0xff)
@@ -121,6 +252,96 @@ static void gicv3_redist_wait_for_rwp(void)
     gicv3_do_wait_for_rwp(&gic_rdist_map[CURRENT_CPU_INDEX()]->ctlr);
 }
 
+#ifdef CONFIG_ARM_GIC_V3_ITS
+static void gic_table_clean(void *table, word_t size)
+{
+    cleanInvalidateCacheRange_RAM((word_t)table, (word_t)table + size - 1, addrFromKPPtr(table));
+}
+
+/* Wait until the ITS has consumed every command up to GITS_CWRITER */
+static bool_t its_wait_for_cmds(void)
+{
+    uint64_t gpt_cnt_tval = 0;
+    uint64_t gpt_cnt_ciel;
+
+    SYSTEM_READ_64(CNT_CT, gpt_cnt_tval);
+    gpt_cnt_ciel = gpt_cnt_tval + (GIC_DEADLINE_MS * TICKS_PER_MS);
+
+    while (GITS_CMD_OFFSET(gic_its->creadr) != GITS_CMD_OFFSET(gic_its->cwriter)) {
+        if (gic_its->creadr & GITS_CREADR_STALLED) {
+            printf("GICv3 ITS command queue stalled\n");
+            return false;
+        }
+        SYSTEM_READ_64(CNT_CT, gpt_cnt_tval);
+        if (gpt_cnt_tval >= gpt_cnt_ciel) {
+            printf("GICv3 ITS command timeout after %u ms\n", GIC_DEADLINE_MS);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Commands are only queued here. The queue is flushed after every
+ * invocation, and in between by those that can queue more than
+ * GITS_CMD_QUEUE_ENTRIES. Should the queue still be full, the commands in it
+ * are handed to the ITS and waited for, rather than overwriting one the ITS
+ * has not read yet. */
+static void its_queue_cmd(uint64_t dw0, uint64_t dw1, uint64_t dw2, uint64_t dw3)
+{
+    its_cmd_t *cmd = &its_cmd_queue[its_cmd_next];
+
+    if (unlikely((its_cmd_next + 1) % GITS_CMD_QUEUE_ENTRIES ==
+                 GITS_CMD_OFFSET(gic_its->creadr) / sizeof(its_cmd_t))) {
+        gic_its->cwriter = its_cmd_next * sizeof(its_cmd_t);
+        if (!its_wait_for_cmds()) {
+            return;
+        }
+    }
+
+    cmd->raw[0] = dw0;
+    cmd->raw[1] = dw1;
+    cmd->raw[2] = dw2;
+    cmd->raw[3] = dw3;
+    cleanCacheRange_RAM((word_t)cmd, (word_t)cmd + sizeof(*cmd) - 1, addrFromKPPtr(cmd));
+
+    its_cmd_next = (its_cmd_next + 1) % GITS_CMD_QUEUE_ENTRIES;
+}
+
+/* Whether the ITS has consumed every queued command and is not stalled.
+ * Invocations check this in decode, so that the commands they queue later
+ * do not fail. */
+bool_t gic_its_ready(void)
+{
+    uint64_t creadr = gic_its->creadr;
+
+    return !(creadr & GITS_CREADR_STALLED) &&
+           GITS_CMD_OFFSET(creadr) == GITS_CMD_OFFSET(gic_its->cwriter);
+}
+
+static bool_t its_flush_cmds(void)
+{
+    its_queue_cmd(GITS_CMD_SYNC, 0, its_rdbase, 0);
+    gic_its->cwriter = its_cmd_next * sizeof(its_cmd_t);
+    return its_wait_for_cmds();
+}
+
+/* Value of the RDbase field of a command that targets the redistributor of core */
+static uint64_t its_core_rdbase(word_t core)
+{
+    if (gic_its->typer & GITS_TYPER_PTA) {
+        return its_gicr_paddr + ((word_t)gic_rdist_map[core] - (word_t)gicr_base);
+    }
+    return GICR_TYPER_PROC_NUM(gic_rdist_map[core]->typer) << 16;
+}
+#endif /* CONFIG_ARM_GIC_V3_ITS */
+
+#ifdef CONFIG_ARM_GIC_V4
+static inline volatile struct gic_rdist_vlpi_map *gic_rdist_vlpi_map(word_t core)
+{
+    return (volatile struct gic_rdist_vlpi_map *)((word_t)gic_rdist_map[core] + GICR_VLPI_FRAME_OFFSET);
+}
+#endif /* CONFIG_ARM_GIC_V4 */
+
 static void gicv3_enable_sre(void)
 {
     uint32_t val = 0;
@@ -181,6 +402,7 @@ BOOT_CODE static void dist_init(void)
 BOOT_CODE static void gicr_locate_interface(void)
 {
     word_t offset;
+    word_t stride = GICR_PER_CORE_SIZE;
     int core_id = CURRENT_CPU_INDEX();
     word_t mpidr = get_current_mpidr();
     uint32_t val;
@@ -189,9 +411,11 @@ BOOT_CODE static void gicr_locate_interface(void)
      * Iterate through all redistributor interfaces looking for one that matches
      * our mpidr.
      */
-    for (offset = 0; offset < GICR_SIZE; offset += GICR_PER_CORE_SIZE) {
+    for (offset = 0; offset < GICR_SIZE; offset += stride) {
 
         uint64_t typer = ((struct gic_rdist_map *)((word_t)gicr_base + offset))->typer;
+        /* GICv4 redistributors have two more frames for virtual LPIs */
+        stride = (typer & GICR_TYPER_VLPIS) ? 2 * GICR_PER_CORE_SIZE : GICR_PER_CORE_SIZE;
         if ((typer >> 32) == ((MPIDR_AFF3(mpidr) << 24) |
                               (MPIDR_AFF2(mpidr) << 16) |
                               (MPIDR_AFF1(mpidr) <<  8) |
@@ -232,6 +456,172 @@ BOOT_CODE static void gicr_locate_interface(void)
 
 }
 
+#ifdef CONFIG_ARM_GIC_V3_ITS
+BOOT_CODE static void gicr_enable_lpis(void)
+{
+    word_t core = CURRENT_CPU_INDEX();
+    volatile struct gic_rdist_map *rdist = gic_rdist_map[core];
+
+    if (!(gic_dist->typer & GICD_TYPE_LPIS) || !(rdist->typer & GICR_TYPER_PLPIS) ||
+        GICD_TYPE_IDBITS(gic_dist->typer) < GIC_LPI_ID_BITS) {
+        printf("GICv3: LPIs not supported on core %d\n", (int)core);
+        return;
+    }
+    /* The tables cannot be changed once LPIs are enabled */
+    if (rdist->ctlr & GICR_CTLR_ENABLE_LPIS) {
+        printf("GICv3: LPIs already enabled on core %d\n", (int)core);
+        return;
+    }
+
+    gic_table_clean(gic_lpi_prop_table, sizeof(gic_lpi_prop_table));
+    gic_table_clean(gic_lpi_pend_table[core], sizeof(gic_lpi_pend_table[core]));
+
+    rdist->propbaser = addrFromKPPtr(gic_lpi_prop_table) | GIC_TABLE_SHAREABLE |
+                       GICR_TABLE_CACHE_WB | (GIC_LPI_ID_BITS - 1);
+    rdist->pendbaser = addrFromKPPtr(gic_lpi_pend_table[core]) | GIC_TABLE_SHAREABLE |
+                       GICR_TABLE_CACHE_WB | GICR_PENDBASER_PTZ;
+    dsb();
+    rdist->ctlr |= GICR_CTLR_ENABLE_LPIS;
+    dsb();
+
+#ifdef CONFIG_ARM_GIC_V4
+    if (!(rdist->typer & GICR_TYPER_VLPIS)) {
+        printf("GICv4: virtual LPIs not supported on core %d\n", (int)core);
+        gic_vlpi_enabled = false;
+        return;
+    }
+    /* No vPE is resident yet, so the shared configuration table can be set */
+    gic_rdist_vlpi_map(core)->vpropbaser = addrFromKPPtr(gic_vlpi_prop_table) | GIC_TABLE_SHAREABLE |
+                                           GICR_TABLE_CACHE_WB | (GIC_VLPI_ID_BITS - 1);
+#endif
+}
+
+BOOT_CODE static paddr_t gicr_paddr(void)
+{
+    for (int i = 0; i < NUM_KERNEL_DEVICE_FRAMES; i++) {
+        if (kernel_device_frames[i].pptr == GICR_PPTR) {
+            return kernel_device_frames[i].paddr;
+        }
+    }
+    return 0;
+}
+
+/* Point a GITS_BASER<n> register at table, which is size bytes long and
+ * aligned to BIT(GITS_TABLE_PAGE_BITS). */
+BOOT_CODE static bool_t its_setup_baser(word_t n, void *table, word_t size)
+{
+    word_t page_bits = GITS_TABLE_PAGE_BITS;
+    uint64_t baser;
+
+    gic_table_clean(table, ROUND_UP(size, GITS_TABLE_PAGE_BITS));
+
+    /* Ask for 64KiB pages. An ITS that only supports one page size
+     * ignores this, and the table is aligned for any page size. */
+    baser = GITS_VALID | GITS_TABLE_CACHE_WB | addrFromKPPtr(table) | GIC_TABLE_SHAREABLE |
+            GITS_BASER_PAGE_SIZE_64K;
+    gic_its->baser[n] = baser | ((ROUND_UP(size, page_bits) >> page_bits) - 1);
+    page_bits = GITS_BASER_PAGE_BITS(gic_its->baser[n]);
+    if (page_bits != GITS_TABLE_PAGE_BITS) {
+        if ((ROUND_UP(size, page_bits) >> page_bits) > GITS_BASER_MAX_PAGES) {
+            printf("GICv3 ITS: table %d does not fit into %d pages\n", (int)n, GITS_BASER_MAX_PAGES);
+            return false;
+        }
+        baser = (baser & ~GITS_BASER_PAGE_SIZE_MASK) | (gic_its->baser[n] & GITS_BASER_PAGE_SIZE_MASK);
+        gic_its->baser[n] = baser | ((ROUND_UP(size, page_bits) >> page_bits) - 1);
+    }
+    return !!(gic_its->baser[n] & GITS_VALID);
+}
+
+BOOT_CODE static void its_init(void)
+{
+    word_t core = CURRENT_CPU_INDEX();
+    uint64_t typer;
+    uint64_t gpt_cnt_tval = 0;
+    uint64_t gpt_cnt_ciel;
+
+    if (!(gic_rdist_map[core]->ctlr & GICR_CTLR_ENABLE_LPIS)) {
+        printf("GICv3 ITS: LPIs are not enabled, not using the ITS\n");
+        return;
+    }
+
+    gic_its->ctlr = 0;
+    SYSTEM_READ_64(CNT_CT, gpt_cnt_tval);
+    gpt_cnt_ciel = gpt_cnt_tval + (GIC_DEADLINE_MS * TICKS_PER_MS);
+    while (!(gic_its->ctlr & GITS_CTLR_QUIESCENT)) {
+        SYSTEM_READ_64(CNT_CT, gpt_cnt_tval);
+        if (gpt_cnt_tval >= gpt_cnt_ciel) {
+            printf("GICv3 ITS: timeout waiting for the ITS to become quiescent\n");
+            return;
+        }
+    }
+
+    typer = gic_its->typer;
+    if (GITS_TYPER_DEV_BITS(typer) < CONFIG_ARM_GIC_V3_ITS_DEVICE_BITS ||
+        GITS_TYPER_ID_BITS(typer) < CONFIG_ARM_GIC_V3_ITS_EVENT_BITS ||
+        GITS_TYPER_ITT_ENTRY_SIZE(typer) > GITS_MAX_ITT_ENTRY_SIZE) {
+        printf("GICv3 ITS: device or event ID bits not supported\n");
+        return;
+    }
+
+    for (word_t i = 0; i < ARRAY_SIZE(gic_its->baser); i++) {
+        uint64_t baser = gic_its->baser[i];
+        bool_t valid = true;
+
+        switch (GITS_BASER_TYPE(baser)) {
+        case GITS_BASER_TYPE_DEVICE:
+            valid = its_setup_baser(i, its_device_table,
+                                    BIT(CONFIG_ARM_GIC_V3_ITS_DEVICE_BITS) * GITS_BASER_ENTRY_SIZE(baser));
+            break;
+        case GITS_BASER_TYPE_COLLECTION:
+            valid = its_setup_baser(i, its_collection_table,
+                                    CONFIG_MAX_NUM_NODES * GITS_BASER_ENTRY_SIZE(baser));
+            break;
+#ifdef CONFIG_ARM_GIC_V4
+        case GITS_BASER_TYPE_VPE:
+            valid = its_setup_baser(i, its_vpe_table,
+                                    CONFIG_ARM_GIC_V4_NUM_VPES * GITS_BASER_ENTRY_SIZE(baser));
+            break;
+#endif
+        default:
+            break;
+        }
+        if (!valid) {
+            printf("GICv3 ITS: failed to set up GITS_BASER%d\n", (int)i);
+            return;
+        }
+    }
+
+    gic_table_clean(its_cmd_queue, sizeof(its_cmd_queue));
+    gic_table_clean(its_itt, sizeof(its_itt));
+    gic_its->cbaser = GITS_VALID | GITS_TABLE_CACHE_WB | addrFromKPPtr(its_cmd_queue) |
+                      GIC_TABLE_SHAREABLE | (sizeof(its_cmd_queue) / BIT(PAGE_BITS) - 1);
+    gic_its->cwriter = 0;
+    its_cmd_next = 0;
+    gic_its->ctlr = GITS_CTLR_ENABLED;
+
+    its_gicr_paddr = gicr_paddr();
+    its_rdbase = its_core_rdbase(core);
+
+    its_queue_cmd(GITS_CMD_MAPC, 0, GITS_VALID | its_rdbase | GITS_ICID, 0);
+    if (!its_flush_cmds()) {
+        return;
+    }
+    gic_its_enabled = true;
+
+#ifdef CONFIG_ARM_GIC_V4
+    if (!(typer & GITS_TYPER_VIRTUAL) || !(gic_rdist_map[core]->typer & GICR_TYPER_VLPIS)) {
+        printf("GICv4: virtual LPIs not supported, using the GICv3 ITS only\n");
+        return;
+    }
+    for (word_t i = 0; i < GIC_VLPI_PROP_SIZE; i++) {
+        gic_vlpi_prop_table[i] = GIC_PRI_IRQ | GIC_LPI_PROP_RES1 | GIC_LPI_PROP_ENABLE;
+    }
+    gic_table_clean(gic_vlpi_prop_table, sizeof(gic_vlpi_prop_table));
+    gic_vlpi_enabled = true;
+#endif
+}
+#endif /* CONFIG_ARM_GIC_V3_ITS */
+
 BOOT_CODE static void gicr_init(void)
 {
     int i;
@@ -261,6 +651,10 @@ BOOT_CODE static void gicr_init(void)
     gic_rdist_sgi_ppi_map[CURRENT_CPU_INDEX()]->icfgr1 = 0x0;
 
     gicv3_redist_wait_for_rwp();
+
+#ifdef CONFIG_ARM_GIC_V3_ITS
+    gicr_enable_lpis();
+#endif
 }
 
 BOOT_CODE static void cpu_iface_init(void)
@@ -329,6 +723,9 @@ void setIRQTrigger(irq_t irq, bool_t trigger)
 BOOT_CODE void initIRQController(void)
 {
     dist_init();
+#ifdef CONFIG_ARM_GIC_V3_ITS
+    its_init();
+#endif
 }
 
 BOOT_CODE void cpu_initLocalIRQController(void)
@@ -342,6 +739,272 @@ BOOT_CODE void cpu_initLocalIRQController(void)
     cpu_iface_init();
 }
 
+#ifdef CONFIG_ARM_GIC_V3_ITS
+bool_t gic_its_device_available(word_t device_id)
+{
+    for (word_t i = 0; i < CONFIG_ARM_GIC_V3_ITS_MAX_DEVICES; i++) {
+        if (!its_itt_owner[i].used || its_itt_owner[i].device_id == device_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+word_t gic_its_find_lpi(word_t device_id, word_t event_id)
+{
+    word_t lpi;
+
+    for (lpi = 0; lpi < CONFIG_ARM_GIC_V3_ITS_NUM_LPIS; lpi++) {
+        if (its_lpi_map[lpi].mapped && its_lpi_map[lpi].device_id == device_id &&
+            its_lpi_map[lpi].event_id == event_id) {
+            break;
+        }
+    }
+    return lpi;
+}
+
+static void its_map_device(word_t device_id)
+{
+    word_t i;
+
+    for (i = 0; i < CONFIG_ARM_GIC_V3_ITS_MAX_DEVICES; i++) {
+        if (its_itt_owner[i].used && its_itt_owner[i].device_id == device_id) {
+            return;
+        }
+    }
+    for (i = 0; i < CONFIG_ARM_GIC_V3_ITS_MAX_DEVICES && its_itt_owner[i].used; i++);
+    assert(i < CONFIG_ARM_GIC_V3_ITS_MAX_DEVICES);
+
+    its_itt_owner[i].device_id = device_id;
+    its_itt_owner[i].used = true;
+    its_queue_cmd(GITS_CMD_MAPD | ((uint64_t)device_id << 32), CONFIG_ARM_GIC_V3_ITS_EVENT_BITS - 1,
+                  GITS_VALID | addrFromKPPtr(its_itt[i]), 0);
+}
+
+static void its_unmap_lpi(word_t lpi)
+{
+    its_queue_cmd(GITS_CMD_DISCARD | ((uint64_t)its_lpi_map[lpi].device_id << 32),
+                  its_lpi_map[lpi].event_id, 0, 0);
+    its_lpi_map[lpi].mapped = false;
+}
+
+/* Translate (device_id, event_id) to LPI number lpi. The caller has checked
+ * that the IDs are in range, that the device can get an ITT, that the event
+ * is not translated to an LPI that has an active handler and that the ITS is
+ * ready. */
+void gic_its_map_lpi(word_t lpi, word_t device_id, word_t event_id)
+{
+    word_t old = gic_its_find_lpi(device_id, event_id);
+
+    if (old < CONFIG_ARM_GIC_V3_ITS_NUM_LPIS) {
+        its_unmap_lpi(old);
+    }
+    if (its_lpi_map[lpi].mapped) {
+        its_unmap_lpi(lpi);
+    }
+    its_map_device(device_id);
+
+    gic_lpi_prop_table[lpi] = GIC_PRI_IRQ | GIC_LPI_PROP_RES1 | GIC_LPI_PROP_ENABLE;
+    cleanCacheRange_RAM((word_t)&gic_lpi_prop_table[lpi], (word_t)&gic_lpi_prop_table[lpi],
+                        addrFromKPPtr(&gic_lpi_prop_table[lpi]));
+
+    its_queue_cmd(GITS_CMD_MAPTI | ((uint64_t)device_id << 32),
+                  event_id | ((uint64_t)(LPI_START + lpi) << 32), GITS_ICID, 0);
+    its_queue_cmd(GITS_CMD_INV | ((uint64_t)device_id << 32), event_id, 0, 0);
+    its_flush_cmds();
+
+    its_lpi_map[lpi].device_id = device_id;
+    its_lpi_map[lpi].event_id = event_id;
+    its_lpi_map[lpi].mapped = true;
+#ifdef CONFIG_ARM_GIC_V4
+    its_lpi_map[lpi].vpe = GIC_VPE_NONE;
+#endif
+}
+#endif /* CONFIG_ARM_GIC_V3_ITS */
+
+#ifdef CONFIG_ARM_GIC_V4
+static bool_t gic_vpe_wait_for_clean(volatile struct gic_rdist_vlpi_map *vlpi)
+{
+    uint64_t gpt_cnt_tval = 0;
+    uint64_t gpt_cnt_ciel;
+
+    SYSTEM_READ_64(CNT_CT, gpt_cnt_tval);
+    gpt_cnt_ciel = gpt_cnt_tval + (GIC_DEADLINE_MS * TICKS_PER_MS);
+
+    while (vlpi->vpendbaser & GICR_VPENDBASER_DIRTY) {
+        SYSTEM_READ_64(CNT_CT, gpt_cnt_tval);
+        if (gpt_cnt_tval >= gpt_cnt_ciel) {
+            printf("GICv4: timeout waiting for the vPE to become non-resident\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool_t gic_vpe_available(void)
+{
+    for (word_t vpe = 0; vpe < CONFIG_ARM_GIC_V4_NUM_VPES; vpe++) {
+        if (!gic_vpe_state[vpe].used) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Map a free vPE to the redistributor of core. The caller has checked that
+ * one is available. */
+word_t gic_vpe_alloc(word_t core)
+{
+    word_t vpe;
+
+    for (vpe = 0; vpe < CONFIG_ARM_GIC_V4_NUM_VPES && gic_vpe_state[vpe].used; vpe++);
+    assert(vpe < CONFIG_ARM_GIC_V4_NUM_VPES);
+
+    /* The pending table must not have stale state from the last owner */
+    memzero(gic_vlpi_pend_table[vpe], sizeof(gic_vlpi_pend_table[vpe]));
+    gic_table_clean(gic_vlpi_pend_table[vpe], sizeof(gic_vlpi_pend_table[vpe]));
+
+    its_queue_cmd(GITS_CMD_VMAPP, (uint64_t)vpe << 32, GITS_VALID | its_core_rdbase(core),
+                  addrFromKPPtr(gic_vlpi_pend_table[vpe]) | (GIC_VLPI_ID_BITS - 1));
+    its_flush_cmds();
+
+    gic_vpe_state[vpe].core = core;
+    gic_vpe_state[vpe].used = true;
+    return vpe;
+}
+
+/* Queue the GITS_VLPI_UNMAP_CMDS commands that translate the event of lpi
+ * back to the physical LPI */
+static void its_unmap_vlpi(word_t lpi)
+{
+    word_t device_id = its_lpi_map[lpi].device_id;
+    word_t event_id = its_lpi_map[lpi].event_id;
+
+    its_queue_cmd(GITS_CMD_DISCARD | ((uint64_t)device_id << 32), event_id, 0, 0);
+    its_queue_cmd(GITS_CMD_MAPTI | ((uint64_t)device_id << 32),
+                  event_id | ((uint64_t)(LPI_START + lpi) << 32), GITS_ICID, 0);
+    its_queue_cmd(GITS_CMD_INV | ((uint64_t)device_id << 32), event_id, 0, 0);
+    its_lpi_map[lpi].vpe = GIC_VPE_NONE;
+}
+
+/* Make vpe non-resident on the core it was last loaded on, which need not be
+ * the current one, if it is still resident there */
+static void gic_vpe_evict(word_t vpe)
+{
+    volatile struct gic_rdist_vlpi_map *vlpi = gic_rdist_vlpi_map(gic_vpe_state[vpe].core);
+    uint64_t vpendbaser = vlpi->vpendbaser;
+
+    if ((vpendbaser & GICR_VPENDBASER_VALID) &&
+        (vpendbaser & GICR_VPENDBASER_PA_MASK) == addrFromKPPtr(gic_vlpi_pend_table[vpe])) {
+        vlpi->vpendbaser = vpendbaser & ~GICR_VPENDBASER_VALID;
+        gic_vpe_wait_for_clean(vlpi);
+    }
+}
+
+/* Translate the event of every LPI bound to vpe back to its physical LPI
+ * and unmap the vPE */
+void gic_vpe_free(word_t vpe)
+{
+    word_t queued = 0;
+
+    gic_vpe_evict(vpe);
+
+    for (word_t lpi = 0; lpi < CONFIG_ARM_GIC_V3_ITS_NUM_LPIS; lpi++) {
+        if (its_lpi_map[lpi].mapped && its_lpi_map[lpi].vpe == vpe) {
+            /* Far more LPIs can be bound than commands fit in the queue, so
+             * flush before the next unmap, the VMAPP and the SYNCs would
+             * overwrite commands the ITS has not consumed yet */
+            if (queued + GITS_VLPI_UNMAP_CMDS + 2 >= GITS_CMD_QUEUE_ENTRIES) {
+                its_flush_cmds();
+                queued = 0;
+            }
+            its_unmap_vlpi(lpi);
+            queued += GITS_VLPI_UNMAP_CMDS;
+        }
+    }
+    its_queue_cmd(GITS_CMD_VMAPP, (uint64_t)vpe << 32, its_core_rdbase(gic_vpe_state[vpe].core), 0);
+    its_flush_cmds();
+
+    gic_vpe_state[vpe].used = false;
+}
+
+/* Make vpe resident on the current core. vLPIs that arrived while it was not
+ * resident are picked up from its pending table. */
+void gic_vpe_load(word_t vpe)
+{
+    word_t core = CURRENT_CPU_INDEX();
+
+    if (unlikely(gic_vpe_state[vpe].core != core)) {
+        its_queue_cmd(GITS_CMD_VMOVP, (uint64_t)vpe << 32, its_core_rdbase(core), 0);
+        its_queue_cmd(GITS_CMD_VSYNC, (uint64_t)vpe << 32, 0, 0);
+        its_flush_cmds();
+        gic_vpe_state[vpe].core = core;
+    }
+
+    gic_rdist_vlpi_map(core)->vpendbaser = GICR_VPENDBASER_VALID | addrFromKPPtr(gic_vlpi_pend_table[vpe]) |
+                                           GIC_TABLE_SHAREABLE | GICR_TABLE_CACHE_WB;
+}
+
+/* Make vpe non-resident. From now on its vLPIs raise their doorbells. */
+void gic_vpe_unload(word_t vpe)
+{
+    volatile struct gic_rdist_vlpi_map *vlpi = gic_rdist_vlpi_map(CURRENT_CPU_INDEX());
+
+    assert(gic_vpe_state[vpe].core == CURRENT_CPU_INDEX());
+    vlpi->vpendbaser = vlpi->vpendbaser & ~GICR_VPENDBASER_VALID;
+    gic_vpe_wait_for_clean(vlpi);
+}
+
+/* Translate the event of LPI lpi to vintid on vpe. The physical LPI stays
+ * enabled and becomes the doorbell for the vLPI. The caller has checked that
+ * the ITS is ready. */
+void gic_its_map_vlpi(word_t lpi, word_t vpe, word_t vintid)
+{
+    word_t device_id = its_lpi_map[lpi].device_id;
+    word_t event_id = its_lpi_map[lpi].event_id;
+
+    assert(its_lpi_map[lpi].mapped);
+
+    its_queue_cmd(GITS_CMD_DISCARD | ((uint64_t)device_id << 32), event_id, 0, 0);
+    its_queue_cmd(GITS_CMD_VMAPTI | ((uint64_t)device_id << 32), event_id | ((uint64_t)vpe << 32),
+                  (LPI_START + lpi) | ((uint64_t)vintid << 32), 0);
+    its_queue_cmd(GITS_CMD_INV | ((uint64_t)device_id << 32), event_id, 0, 0);
+    its_queue_cmd(GITS_CMD_VSYNC, (uint64_t)vpe << 32, 0, 0);
+    its_flush_cmds();
+
+    its_lpi_map[lpi].vpe = vpe;
+}
+
+#endif /* CONFIG_ARM_GIC_V4 */
+
+#ifdef CONFIG_ARM_GIC_V3_ITS
+/* Disable LPI lpi and remove the translation of its event, if it has one.
+ * Called once the last handler for lpi is gone. */
+void gic_its_unmap_lpi(word_t lpi)
+{
+    word_t device_id = its_lpi_map[lpi].device_id;
+    word_t event_id = its_lpi_map[lpi].event_id;
+
+    if (!its_lpi_map[lpi].mapped) {
+        return;
+    }
+#ifdef CONFIG_ARM_GIC_V4
+    /* The INV below has to reach the physical LPI, not the vLPI */
+    if (its_lpi_map[lpi].vpe != GIC_VPE_NONE) {
+        its_unmap_vlpi(lpi);
+    }
+#endif
+
+    gic_lpi_prop_table[lpi] = GIC_PRI_IRQ | GIC_LPI_PROP_RES1;
+    cleanCacheRange_RAM((word_t)&gic_lpi_prop_table[lpi], (word_t)&gic_lpi_prop_table[lpi],
+                        addrFromKPPtr(&gic_lpi_prop_table[lpi]));
+
+    its_queue_cmd(GITS_CMD_INV | ((uint64_t)device_id << 32), event_id, 0, 0);
+    its_unmap_lpi(lpi);
+    its_flush_cmds();
+}
+#endif /* CONFIG_ARM_GIC_V3_ITS */
+
 #ifdef ENABLE_SMP_SUPPORT
 #define MPIDR_MT(x)   (x & BIT(24))
 
@@ -18,6 +18,15 @@ static exception_t Arch_invokeIRQControl(irq_t irq, cte_t *handlerSlot, cte_t *c
     return invokeIRQControl(irq, handlerSlot, controlSlot);
 }
 
+#ifdef CONFIG_ARM_GIC_V3_ITS
+static exception_t Arch_invokeIRQControlLPI(irq_t irq, word_t device_id, word_t event_id,
+                                            cte_t *handlerSlot, cte_t *controlSlot)
+{
+    gic_its_map_lpi(IRQT_TO_IRQ(irq) - LPI_IRQ_BASE, device_id, event_id);
+    return invokeIRQControl(irq, handlerSlot, controlSlot);
+}
+#endif /* CONFIG_ARM_GIC_V3_ITS */
+
 exception_t Arch_decodeIRQControlInvocation(word_t invLabel, word_t length,
                                             cte_t *srcSlot, word_t *buffer)
 {
@@ -130,8 +139,112 @@ exception_t Arch_decodeIRQControlInvocation(word_t invLabel, word_t length,
         }
         return Arch_invokeIRQControl(irq, destSlot, srcSlot, trigger);
 #endif /* ENABLE_SMP_SUPPORT */
+#ifdef CONFIG_ARM_GIC_V3_ITS
+    } else if (invLabel == ARMIRQIssueIRQHandlerLPI) {
+        if (length < 5 || current_extra_caps.excaprefs[0] == NULL) {
+            current_syscall_error.type = seL4_TruncatedMessage;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        word_t lpi = getSyscallArg(0, buffer);
+        word_t device_id = getSyscallArg(1, buffer);
+        word_t event_id = getSyscallArg(2, buffer);
+        word_t index = getSyscallArg(3, buffer);
+        word_t depth = getSyscallArg(4, buffer);
+
+        cap_t cnodeCap = current_extra_caps.excaprefs[0]->cap;
+
+        if (!gic_its_enabled) {
+            userError("IRQControl: the GICv3 ITS is not available.");
+            current_syscall_error.type = seL4_IllegalOperation;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        if (lpi >= CONFIG_ARM_GIC_V3_ITS_NUM_LPIS) {
+            userError("IRQControl: LPI %lu is out of range.", lpi);
+            current_syscall_error.type = seL4_RangeError;
+            current_syscall_error.rangeErrorMin = 0;
+            current_syscall_error.rangeErrorMax = CONFIG_ARM_GIC_V3_ITS_NUM_LPIS - 1;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        if (device_id >= BIT(CONFIG_ARM_GIC_V3_ITS_DEVICE_BITS)) {
+            userError("IRQControl: ITS device ID %lu is out of range.", device_id);
+            current_syscall_error.type = seL4_RangeError;
+            current_syscall_error.rangeErrorMin = 0;
+            current_syscall_error.rangeErrorMax = MASK(CONFIG_ARM_GIC_V3_ITS_DEVICE_BITS);
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        if (event_id >= BIT(CONFIG_ARM_GIC_V3_ITS_EVENT_BITS)) {
+            userError("IRQControl: ITS event ID %lu is out of range.", event_id);
+            current_syscall_error.type = seL4_RangeError;
+            current_syscall_error.rangeErrorMin = 0;
+            current_syscall_error.rangeErrorMax = MASK(CONFIG_ARM_GIC_V3_ITS_EVENT_BITS);
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        irq_t irq = CORE_IRQ_TO_IRQT(0, LPI_IRQ_BASE + lpi);
+        if (isIRQActive(irq)) {
+            current_syscall_error.type = seL4_RevokeFirst;
+            userError("Rejecting request for LPI %lu. Already active.", lpi);
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        word_t old = gic_its_find_lpi(device_id, event_id);
+        if (old < CONFIG_ARM_GIC_V3_ITS_NUM_LPIS && old != lpi &&
+            isIRQActive(CORE_IRQ_TO_IRQT(0, LPI_IRQ_BASE + old))) {
+            current_syscall_error.type = seL4_RevokeFirst;
+            userError("Rejecting request for LPI %lu. Event is translated to active LPI %lu.", lpi, old);
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        if (!gic_its_device_available(device_id)) {
+            userError("IRQControl: no ITS translation table left for device %lu.", device_id);
+            current_syscall_error.type = seL4_IllegalOperation;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        if (!gic_its_ready()) {
+            userError("IRQControl: The ITS is not responding.");
+            current_syscall_error.type = seL4_IllegalOperation;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        lookupSlot_ret_t lu_ret = lookupTargetSlot(cnodeCap, index, depth);
+        if (lu_ret.status != EXCEPTION_NONE) {
+            userError("Target slot for new IRQ Handler cap invalid: cap %lu, LPI %lu.",
+                      getExtraCPtr(buffer, 0), lpi);
+            return lu_ret.status;
+        }
+
+        cte_t *destSlot = lu_ret.slot;
+
+        exception_t status = ensureEmptySlot(destSlot);
+        if (status != EXCEPTION_NONE) {
+            userError("Target slot for new IRQ Handler cap not empty: cap %lu, LPI %lu.",
+                      getExtraCPtr(buffer, 0), lpi);
+            return status;
+        }
+
+        setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+        return Arch_invokeIRQControlLPI(irq, device_id, event_id, destSlot, srcSlot);
+#endif /* CONFIG_ARM_GIC_V3_ITS */
     } else {
         current_syscall_error.type = seL4_IllegalOperation;
         return EXCEPTION_SYSCALL_ERROR;
     }
 }
+
+#ifdef CONFIG_ARM_GIC_V3_ITS
+void Arch_deletedIRQHandler(irq_t irq)
+{
+    word_t hw_irq = IRQT_TO_IRQ(irq);
+
+    /* Neither the host nor a guest may keep receiving the LPI once its
+     * handler is gone */
+    if (HW_IRQ_IS_LPI(hw_irq)) {
+        gic_its_unmap_lpi(hw_irq - LPI_IRQ_BASE);
+    }
+}
+#endif /* CONFIG_ARM_GIC_V3_ITS */
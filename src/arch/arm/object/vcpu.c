@@ -14,6 +14,18 @@
 #include <arch/machine/debug_conf.h>
 #include <drivers/timer/arm_generic.h>
 #include <plat/platform_gen.h> /* Ensure correct GIC header is included */
+#ifdef CONFIG_VCPU_EXIT_STATS
+#include <mode/api/ipc_buffer.h>
+#endif
+
+/* List registers implemented by the hardware */
+static inline uint64_t vgic_lr_mask(void)
+{
+    if (gic_vcpu_num_list_regs >= 64) {
+        return ~0ull;
+    }
+    return (1ull << gic_vcpu_num_list_regs) - 1;
+}
 
 BOOT_CODE void vcpu_boot_init(void)
 {
@@ -26,19 +38,40 @@ BOOT_CODE void vcpu_boot_init(void)
     vcpu_disable(NULL);
     ARCH_NODE_STATE(armHSCurVCPU) = NULL;
     ARCH_NODE_STATE(armHSVCPUActive) = false;
+    ARCH_NODE_STATE(armHSVGICLRsInUse) = vgic_lr_mask();
+}
 
+#ifdef CONFIG_ARM_GIC_V4
+static inline void vcpu_vpe_load(vcpu_t *vcpu)
+{
+    if (vcpu->vpe != GIC_VPE_NONE) {
+        gic_vpe_load(vcpu->vpe);
+    }
 }
 
+static inline void vcpu_vpe_unload(vcpu_t *vcpu)
+{
+    if (vcpu->vpe != GIC_VPE_NONE) {
+        gic_vpe_unload(vcpu->vpe);
+    }
+}
+#else
+#define vcpu_vpe_load(vcpu) do {} while (0)
+#define vcpu_vpe_unload(vcpu) do {} while (0)
+#endif /* CONFIG_ARM_GIC_V4 */
+
 static void vcpu_save(vcpu_t *vcpu, bool_t active)
 {
     word_t i;
     unsigned int lr_num;
+    uint64_t lr_used;
 
     assert(vcpu);
     dsb();
     /* If we aren't active then this state already got stored when
      * we were disabled */
     if (active) {
+        vcpu_vpe_unload(vcpu);
         vcpu_save_reg(vcpu, seL4_VCPUReg_SCTLR);
         vcpu->vgic.hcr = get_gic_vcpu_ctrl_hcr();
         save_virt_timer(vcpu);
@@ -48,9 +81,19 @@ static void vcpu_save(vcpu_t *vcpu, bool_t active)
     vcpu->vgic.vmcr = get_gic_vcpu_ctrl_vmcr();
     vcpu->vgic.apr = get_gic_vcpu_ctrl_apr();
     lr_num = gic_vcpu_num_list_regs;
+    /* Only read back the list registers that the guest has not emptied. The
+     * copies of the empty ones are cleared so that they can be restored
+     * without looking at them again. */
+    lr_used = ~(((uint64_t)get_gic_vcpu_ctrl_elrsr1() << 32) | get_gic_vcpu_ctrl_elrsr0()) & vgic_lr_mask();
     for (i = 0; i < lr_num; i++) {
-        vcpu->vgic.lr[i] = get_gic_vcpu_ctrl_lr(i);
+        if (lr_used & (1ull << i)) {
+            vcpu->vgic.lr[i] = get_gic_vcpu_ctrl_lr(i);
+        } else {
+            vcpu->vgic.lr[i].words[0] = 0;
+        }
     }
+    vcpu->vgic.lr_used = lr_used;
+    ARCH_NODE_STATE(armHSVGICLRsInUse) = lr_used;
     armv_vcpu_save(vcpu, active);
 }
 
@@ -86,6 +129,7 @@ void vcpu_restore(vcpu_t *vcpu)
     assert(vcpu);
     word_t i;
     unsigned int lr_num;
+    uint64_t lr_dirty;
     /* Turn off the VGIC */
     set_gic_vcpu_ctrl_hcr(0);
     isb();
@@ -94,9 +138,15 @@ void vcpu_restore(vcpu_t *vcpu)
     set_gic_vcpu_ctrl_vmcr(vcpu->vgic.vmcr);
     set_gic_vcpu_ctrl_apr(vcpu->vgic.apr);
     lr_num = gic_vcpu_num_list_regs;
+    /* Write the list registers this VCPU uses and clear the ones that still
+     * hold state of the previous VCPU. All others are already empty. */
+    lr_dirty = ARCH_NODE_STATE(armHSVGICLRsInUse) | vcpu->vgic.lr_used;
     for (i = 0; i < lr_num; i++) {
-        set_gic_vcpu_ctrl_lr(i, vcpu->vgic.lr[i]);
+        if (lr_dirty & (1ull << i)) {
+            set_gic_vcpu_ctrl_lr(i, vcpu->vgic.lr[i]);
+        }
     }
+    ARCH_NODE_STATE(armHSVGICLRsInUse) = vcpu->vgic.lr_used;
 
     /* restore registers */
 #ifdef CONFIG_ARCH_AARCH64
@@ -105,6 +155,7 @@ void vcpu_restore(vcpu_t *vcpu)
     vcpu_restore_reg_range(vcpu, seL4_VCPUReg_ACTLR, seL4_VCPUReg_SPSRfiq);
 #endif
     vcpu_enable(vcpu);
+    vcpu_vpe_load(vcpu);
 }
 
 void VPPIEvent(irq_t irq)
@@ -227,6 +278,9 @@ void vcpu_init(vcpu_t *vcpu)
     /* Virtual Timer interface */
     vcpu->virtTimer.last_pcount = 0;
 #endif
+#ifdef CONFIG_ARM_GIC_V4
+    vcpu->vpe = GIC_VPE_NONE;
+#endif
 }
 
 void vcpu_switch(vcpu_t *new)
@@ -244,12 +298,14 @@ void vcpu_switch(vcpu_t *new)
 #ifdef ARM_HYP_CP14_SAVE_AND_RESTORE_VCPU_THREADS
             saveAllBreakpointState(ARCH_NODE_STATE(armHSCurVCPU)->vcpuTCB);
 #endif
+            vcpu_vpe_unload(ARCH_NODE_STATE(armHSCurVCPU));
             vcpu_disable(ARCH_NODE_STATE(armHSCurVCPU));
             ARCH_NODE_STATE(armHSVCPUActive) = false;
         }
     } else if (likely(!ARCH_NODE_STATE(armHSVCPUActive) && new != NULL)) {
         isb();
         vcpu_enable(new);
+        vcpu_vpe_load(new);
         ARCH_NODE_STATE(armHSVCPUActive) = true;
     }
 }
@@ -257,10 +313,13 @@ void vcpu_switch(vcpu_t *new)
 static void vcpu_invalidate_active(void)
 {
     if (ARCH_NODE_STATE(armHSVCPUActive)) {
+        vcpu_vpe_unload(ARCH_NODE_STATE(armHSCurVCPU));
         vcpu_disable(NULL);
         ARCH_NODE_STATE(armHSVCPUActive) = false;
     }
     ARCH_NODE_STATE(armHSCurVCPU) = NULL;
+    /* The list registers were not saved, so their state is unknown */
+    ARCH_NODE_STATE(armHSVGICLRsInUse) = vgic_lr_mask();
 }
 
 void vcpu_finalise(vcpu_t *vcpu)
@@ -268,6 +327,12 @@ void vcpu_finalise(vcpu_t *vcpu)
     if (vcpu->vcpuTCB) {
         dissociateVCPUTCB(vcpu, vcpu->vcpuTCB);
     }
+#ifdef CONFIG_ARM_GIC_V4
+    if (vcpu->vpe != GIC_VPE_NONE) {
+        gic_vpe_free(vcpu->vpe);
+        vcpu->vpe = GIC_VPE_NONE;
+    }
+#endif
 }
 
 void associateVCPUTCB(vcpu_t *vcpu, tcb_t *tcb)
@@ -373,6 +438,112 @@ exception_t decodeVCPUReadReg(cap_t cap, unsigned int length, bool_t call, word_
     return invokeVCPUReadReg(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), field, call);
 }
 
+/* The batched invocations take a count in the first message register,
+ * followed by seL4_VCPUBatchMax register IDs and, for writes, the values. */
+#define VCPU_BATCH_FIELDS 1
+#define VCPU_BATCH_VALUES (VCPU_BATCH_FIELDS + seL4_VCPUBatchMax)
+
+static exception_t decodeVCPUBatchFields(word_t count, unsigned int length, word_t *buffer,
+                                         word_t fields[seL4_VCPUBatchMax])
+{
+    if (count > seL4_VCPUBatchMax) {
+        userError("VCPU batch: Count %lu is too large.", (unsigned long)count);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 0;
+        current_syscall_error.rangeErrorMax = seL4_VCPUBatchMax;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    if (length < VCPU_BATCH_FIELDS + count) {
+        userError("VCPU batch: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    for (word_t i = 0; i < count; i++) {
+        fields[i] = getSyscallArg(VCPU_BATCH_FIELDS + i, buffer);
+        if (fields[i] >= seL4_VCPUReg_Num) {
+            userError("VCPU batch: Invalid field 0x%lx.", (long)fields[i]);
+            current_syscall_error.type = seL4_InvalidArgument;
+            current_syscall_error.invalidArgumentNumber = VCPU_BATCH_FIELDS + i;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+    }
+    return EXCEPTION_NONE;
+}
+
+exception_t invokeVCPUWriteRegsBatch(vcpu_t *vcpu, word_t count, word_t *fields, word_t *buffer)
+{
+    for (word_t i = 0; i < count; i++) {
+        writeVCPUReg(vcpu, fields[i], getSyscallArg(VCPU_BATCH_VALUES + i, buffer));
+    }
+    return EXCEPTION_NONE;
+}
+
+exception_t decodeVCPUWriteRegsBatch(cap_t cap, unsigned int length, word_t *buffer)
+{
+    word_t fields[seL4_VCPUBatchMax];
+    word_t count;
+    exception_t status;
+
+    if (length < 1) {
+        userError("VCPUWriteRegsBatch: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    count = getSyscallArg(0, buffer);
+    status = decodeVCPUBatchFields(count, length, buffer, fields);
+    if (status != EXCEPTION_NONE) {
+        return status;
+    }
+    if (length < VCPU_BATCH_VALUES + count) {
+        userError("VCPUWriteRegsBatch: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return invokeVCPUWriteRegsBatch(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), count, fields, buffer);
+}
+
+exception_t invokeVCPUReadRegsBatch(vcpu_t *vcpu, word_t count, word_t *fields, bool_t call)
+{
+    tcb_t *thread;
+    thread = NODE_STATE(ksCurThread);
+    if (call) {
+        word_t *ipcBuffer = lookupIPCBuffer(true, thread);
+        unsigned int length = 0;
+        setRegister(thread, badgeRegister, 0);
+        for (word_t i = 0; i < count; i++) {
+            length = setMR(thread, ipcBuffer, i, readVCPUReg(vcpu, fields[i]));
+        }
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+exception_t decodeVCPUReadRegsBatch(cap_t cap, unsigned int length, bool_t call, word_t *buffer)
+{
+    word_t fields[seL4_VCPUBatchMax];
+    word_t count;
+    exception_t status;
+
+    if (length < 1) {
+        userError("VCPUReadRegsBatch: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    count = getSyscallArg(0, buffer);
+    status = decodeVCPUBatchFields(count, length, buffer, fields);
+    if (status != EXCEPTION_NONE) {
+        return status;
+    }
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return invokeVCPUReadRegsBatch(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), count, fields, call);
+}
+
 exception_t invokeVCPUInjectIRQ(vcpu_t *vcpu, unsigned long index, virq_t virq)
 {
     if (likely(ARCH_NODE_STATE(armHSCurVCPU) == vcpu)) {
@@ -383,6 +554,7 @@ exception_t invokeVCPUInjectIRQ(vcpu_t *vcpu, unsigned long index, virq_t virq)
 #endif /* CONFIG_ENABLE_SMP */
     } else {
         vcpu->vgic.lr[index] = virq;
+        vcpu->vgic.lr_used |= 1ull << index;
     }
 
     return EXCEPTION_NONE;
@@ -488,10 +660,22 @@ exception_t decodeARMVCPUInvocation(
         return decodeVCPUReadReg(cap, length, call, buffer);
     case ARMVCPUWriteReg:
         return decodeVCPUWriteReg(cap, length, buffer);
+    case ARMVCPUReadRegsBatch:
+        return decodeVCPUReadRegsBatch(cap, length, call, buffer);
+    case ARMVCPUWriteRegsBatch:
+        return decodeVCPUWriteRegsBatch(cap, length, buffer);
     case ARMVCPUInjectIRQ:
         return decodeVCPUInjectIRQ(cap, length, buffer);
     case ARMVCPUAckVPPI:
         return decodeVCPUAckVPPI(cap, length, buffer);
+#ifdef CONFIG_ARM_GIC_V4
+    case ARMVCPUBindVLPI:
+        return decodeVCPUBindVLPI(cap, length, buffer);
+#endif
+#ifdef CONFIG_VCPU_EXIT_STATS
+    case ARMVCPUGetExitStats:
+        return decodeVCPUGetExitStats(cap, length, call, buffer);
+#endif
     default:
         userError("VCPU: Illegal operation.");
         current_syscall_error.type = seL4_IllegalOperation;
@@ -533,6 +717,83 @@ exception_t invokeVCPUAckVPPI(vcpu_t *vcpu, VPPIEventIRQ_t vppi)
     return EXCEPTION_NONE;
 }
 
+#ifdef CONFIG_ARM_GIC_V4
+exception_t decodeVCPUBindVLPI(cap_t cap, unsigned int length, word_t *buffer)
+{
+    vcpu_t *vcpu = VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap));
+    cap_t irqCap;
+    word_t hw_irq;
+    word_t vintid;
+
+    if (length < 1 || current_extra_caps.excaprefs[0] == NULL) {
+        userError("VCPUBindVLPI: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (!gic_vlpi_enabled) {
+        userError("VCPUBindVLPI: GICv4 virtual LPIs are not available.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    irqCap = current_extra_caps.excaprefs[0]->cap;
+    if (cap_get_capType(irqCap) != cap_irq_handler_cap) {
+        userError("VCPUBindVLPI: Not an IRQ handler cap.");
+        current_syscall_error.type = seL4_InvalidCapability;
+        current_syscall_error.invalidCapNumber = 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    hw_irq = IRQT_TO_IRQ(IDX_TO_IRQT(cap_irq_handler_cap_get_capIRQ(irqCap)));
+    if (!HW_IRQ_IS_LPI(hw_irq)) {
+        userError("VCPUBindVLPI: IRQ %lu is not an LPI.", hw_irq);
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    vintid = getSyscallArg(0, buffer);
+    if (vintid < LPI_START || vintid >= BIT(GIC_VLPI_ID_BITS)) {
+        userError("VCPUBindVLPI: Invalid virtual INTID %lu.", vintid);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = LPI_START;
+        current_syscall_error.rangeErrorMax = BIT(GIC_VLPI_ID_BITS) - 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (vcpu->vpe == GIC_VPE_NONE && !gic_vpe_available()) {
+        userError("VCPUBindVLPI: No vPE left.");
+        current_syscall_error.type = seL4_NotEnoughMemory;
+        current_syscall_error.memoryLeft = 0;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (!gic_its_ready()) {
+        userError("VCPUBindVLPI: The ITS is not responding.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return invokeVCPUBindVLPI(vcpu, hw_irq - LPI_IRQ_BASE, vintid);
+}
+
+exception_t invokeVCPUBindVLPI(vcpu_t *vcpu, word_t lpi, word_t vintid)
+{
+    if (vcpu->vpe == GIC_VPE_NONE) {
+        /* The vPE follows the VCPU to whichever core loads it */
+        vcpu->vpe = gic_vpe_alloc(CURRENT_CPU_INDEX());
+        /* The VCPU may be the one running this invocation */
+        if (ARCH_NODE_STATE(armHSCurVCPU) == vcpu && ARCH_NODE_STATE(armHSVCPUActive)) {
+            gic_vpe_load(vcpu->vpe);
+        }
+    }
+    gic_its_map_vlpi(lpi, vcpu->vpe, vintid);
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return EXCEPTION_NONE;
+}
+#endif /* CONFIG_ARM_GIC_V4 */
+
 exception_t decodeVCPUSetTCB(cap_t cap)
 {
     cap_t tcbCap;
@@ -561,6 +822,77 @@ exception_t invokeVCPUSetTCB(vcpu_t *vcpu, tcb_t *tcb)
 }
 
 
+#ifdef CONFIG_VCPU_EXIT_STATS
+/* Called on kernel entry with the reason the guest of the current thread, if
+ * any, stopped running */
+void recordVCPUExit(word_t reason)
+{
+    vcpu_t *vcpu = NODE_STATE(ksCurThread)->tcbArch.tcbVCPU;
+    uint64_t now;
+
+    if (vcpu != NULL) {
+        SYSTEM_READ_64(CNT_CT, now);
+        vcpuExitStatsExit(&vcpu->exit_stats, reason, now);
+    }
+}
+
+/* Called on every kernel exit, completes the pending exit of the guest that
+ * is about to run */
+void recordVCPUResume(void)
+{
+    vcpu_t *vcpu = NODE_STATE(ksCurThread)->tcbArch.tcbVCPU;
+    uint64_t now;
+
+    if (vcpu != NULL && vcpu->exit_stats.pending) {
+        SYSTEM_READ_64(CNT_CT, now);
+        vcpuExitStatsResume(&vcpu->exit_stats, now);
+    }
+}
+
+exception_t invokeVCPUGetExitStats(vcpu_t *vcpu, word_t reason, bool_t call)
+{
+    tcb_t *thread;
+    thread = NODE_STATE(ksCurThread);
+    if (call) {
+        word_t *ipcBuffer = lookupIPCBuffer(true, thread);
+        vcpu_exit_stats_t *stats = &vcpu->exit_stats;
+        unsigned int length = 0;
+        setRegister(thread, badgeRegister, 0);
+        mode_setTimeArg(0, stats->count[reason], ipcBuffer, thread);
+        mode_setTimeArg(VCPU_EXIT_STATS_TICKS, stats->ticks[reason], ipcBuffer, thread);
+        for (word_t i = 0; i < seL4_VCPUExitHistogramBuckets; i++) {
+            length = setMR(thread, ipcBuffer, VCPU_EXIT_STATS_HISTOGRAM + i, stats->histogram[reason][i]);
+        }
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+exception_t decodeVCPUGetExitStats(cap_t cap, unsigned int length, bool_t call, word_t *buffer)
+{
+    word_t reason;
+
+    if (length < 1) {
+        userError("VCPUGetExitStats: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    reason = getSyscallArg(0, buffer);
+    if (reason >= seL4_VCPUExitReasons) {
+        userError("VCPUGetExitStats: Invalid exit reason %lu.", (unsigned long)reason);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 0;
+        current_syscall_error.rangeErrorMax = seL4_VCPUExitReasons - 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return invokeVCPUGetExitStats(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), reason, call);
+}
+#endif /* CONFIG_VCPU_EXIT_STATS */
+
 void handleVCPUFault(word_t hsr)
 {
     MCS_DO_IF_BUDGET({
@@ -582,6 +914,7 @@ void handleVCPUInjectInterruptIPI(vcpu_t *vcpu, unsigned long index, virq_t virq
         set_gic_vcpu_ctrl_lr(index, virq);
     } else {
         vcpu->vgic.lr[index] = virq;
+        vcpu->vgic.lr_used |= 1ull << index;
     }
 }
 #endif /* ENABLE_SMP_SUPPORT */
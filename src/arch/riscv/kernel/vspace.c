@@ -198,9 +198,9 @@ BOOT_CODE void map_it_frame_cap(cap_t vspace_cap, cap_t frame_cap)
     pte_t *frame_pptr   = PTE_PTR(pptr_of_cap(frame_cap));
     vptr_t frame_vptr = cap_frame_cap_get_capFMappedAddress(frame_cap);
 
-    /* We deal with a frame as 4KiB */
+    /* The frame is either 4KiB or a large page without a page table */
     lookupPTSlot_ret_t lu_ret = lookupPTSlot(lvl1pt, frame_vptr);
-    assert(lu_ret.ptBitsLeft == seL4_PageBits);
+    assert(lu_ret.ptBitsLeft == pageBitsForSize(cap_frame_cap_get_capFSize(frame_cap)));
 
     pte_t *targetSlot = lu_ret.ptSlot;
 
@@ -254,7 +254,7 @@ BOOT_CODE word_t arch_get_n_paging(v_region_t it_v_reg)
     for (int i = 0; i < CONFIG_PT_LEVELS - 1; i++) {
         n += get_n_paging(it_v_reg, RISCV_GET_LVL_PGSIZE_BITS(i));
     }
-    return n;
+    return n - get_n_it_large_pages();
 }
 
 /* Create an address space for the initial thread.
@@ -283,6 +283,10 @@ BOOT_CODE cap_t create_it_address_space(cap_t root_cnode_cap, v_region_t it_v_re
         for (pt_vptr = ROUND_DOWN(it_v_reg.start, RISCV_GET_LVL_PGSIZE_BITS(i));
              pt_vptr < it_v_reg.end;
              pt_vptr += RISCV_GET_LVL_PGSIZE(i)) {
+            /* the last level of page tables is not needed for large pages */
+            if (i == CONFIG_PT_LEVELS - 2 && it_is_large_vptr(pt_vptr)) {
+                continue;
+            }
             if (!provide_cap(root_cnode_cap,
                              create_it_pt_cap(lvl1pt_cap, it_alloc_paging(), pt_vptr, IT_ASID))
                ) {
@@ -444,6 +448,9 @@ void deleteASIDPool(asid_t asid_base, asid_pool_t *pool)
 
     if (riscvKSASIDTable[asid_base >> asidLowBits] == pool) {
         riscvKSASIDTable[asid_base >> asidLowBits] = NULL;
+        /* The ASIDs of the pool may be reused, so none of their translations
+         * may survive */
+        sfence();
         setVMRoot(NODE_STATE(ksCurThread));
     }
 }
@@ -540,7 +547,7 @@ void unmapPageTable(asid_t asid, vptr_t vptr, pte_t *target_pt)
                   0,  /* read */
                   0  /* valid */
               );
-    sfence();
+    hwASIDFlush(asid);
 }
 
 static pte_t pte_pte_invalid_new(void)
@@ -570,7 +577,7 @@ void unmapPage(vm_page_size_t page_size, asid_t asid, vptr_t vptr, pptr_t pptr)
     }
 
     lu_ret.ptSlot[0] = pte_pte_invalid_new();
-    sfence();
+    hwASIDFlushVAddr(asid, vptr);
 }
 
 void setVMRoot(tcb_t *tcb)
@@ -1078,7 +1085,7 @@ exception_t performPageTableInvocationMap(cap_t cap, cte_t *ctSlot,
 {
     ctSlot->cap = cap;
     *ptSlot = pte;
-    sfence();
+    hwASIDFlush(cap_page_table_cap_get_capPTMappedASID(cap));
 
     return EXCEPTION_NONE;
 }
@@ -1118,10 +1125,10 @@ static exception_t performPageGetAddress(void *vbase_ptr, bool_t call)
     return EXCEPTION_NONE;
 }
 
-static exception_t updatePTE(pte_t pte, pte_t *base)
+static exception_t updatePTE(pte_t pte, pte_t *base, asid_t asid, vptr_t vaddr)
 {
     *base = pte;
-    sfence();
+    hwASIDFlushVAddr(asid, vaddr);
     return EXCEPTION_NONE;
 }
 
@@ -1129,7 +1136,7 @@ exception_t performPageInvocationMapPTE(cap_t cap, cte_t *ctSlot,
                                         pte_t pte, pte_t *base)
 {
     ctSlot->cap = cap;
-    return updatePTE(pte, base);
+    return updatePTE(pte, base, cap_frame_cap_get_capFMappedASID(cap), cap_frame_cap_get_capFMappedAddress(cap));
 }
 
 exception_t performPageInvocationUnmap(cap_t cap, cte_t *ctSlot)
@@ -1150,6 +1157,46 @@ exception_t performPageInvocationUnmap(cap_t cap, cte_t *ctSlot)
     return EXCEPTION_NONE;
 }
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+bool_t Arch_checkGrantFrame(cap_t cap, tcb_t *receiver, vptr_t vaddr, bool_t replacing)
+{
+    cap_t threadRoot = TCB_PTR_CTE_PTR(receiver, tcbVTable)->cap;
+    vm_page_size_t frameSize = cap_frame_cap_get_capFSize(cap);
+
+    if (unlikely(!isValidVTableRoot(threadRoot) || !checkVPAlignment(frameSize, vaddr) ||
+                 vaddr + BIT(pageBitsForSize(frameSize)) - 1 >= USER_TOP)) {
+        return false;
+    }
+
+    cap_t grantCap = TCB_PTR_CTE_PTR(receiver, tcbGrantFrame)->cap;
+    replacing = replacing && cap_frame_cap_get_capFMappedASID(grantCap) == cap_page_table_cap_get_capPTMappedASID(threadRoot);
+
+    /* The window must be backed by page tables for this frame size, and must
+     * not be mapped by anything but the previous grant */
+    lookupPTSlot_ret_t lu_ret = lookupPTSlot(PTE_PTR(cap_page_table_cap_get_capPTBasePtr(threadRoot)), vaddr);
+    return lu_ret.ptBitsLeft == pageBitsForSize(frameSize) && (replacing || !pte_ptr_get_valid(lu_ret.ptSlot));
+}
+
+void Arch_mapGrantFrame(cap_t cap, cte_t *srcSlot, tcb_t *receiver, vptr_t vaddr)
+{
+    cap_t threadRoot = TCB_PTR_CTE_PTR(receiver, tcbVTable)->cap;
+    pte_t *lvl1pt = PTE_PTR(cap_page_table_cap_get_capPTBasePtr(threadRoot));
+    asid_t asid = cap_page_table_cap_get_capPTMappedASID(threadRoot);
+
+    lookupPTSlot_ret_t lu_ret = lookupPTSlot(lvl1pt, vaddr);
+    assert(lu_ret.ptBitsLeft == pageBitsForSize(cap_frame_cap_get_capFSize(cap)) &&
+           !pte_ptr_get_valid(lu_ret.ptSlot));
+
+    paddr_t frame_paddr = addrFromPPtr((void *) cap_frame_cap_get_capFBasePtr(cap));
+    pte_t pte = makeUserPTE(frame_paddr, false, cap_frame_cap_get_capFVMRights(cap));
+    cap = cap_frame_cap_set_capFMappedASID(cap, asid);
+    cap = cap_frame_cap_set_capFMappedAddress(cap, vaddr);
+
+    cteInsert(cap, srcSlot, TCB_PTR_CTE_PTR(receiver, tcbGrantFrame));
+    updatePTE(pte, lu_ret.ptSlot, asid, vaddr);
+}
+#endif /* CONFIG_IPC_FRAME_GRANT */
+
 #ifdef CONFIG_PRINTING
 void Arch_userStackTrace(tcb_t *tptr)
 {
@@ -167,6 +167,14 @@ static inline bool_t isIRQPending(void)
     return (sip & (BIT(SIP_STIP) | BIT(SIP_SEIP)));
 }
 
+#ifdef ENABLE_SMP_SUPPORT
+/* All IPIs share the software interrupt, so this reports any pending IPI. */
+static inline bool_t isIPIPending(UNUSED word_t ipi)
+{
+    return !!(read_sip() & BIT(SIP_SSIP));
+}
+#endif
+
 /**
  * Disable or enable IRQs.
  *
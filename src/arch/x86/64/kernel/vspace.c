@@ -495,6 +495,9 @@ void setVMRoot(tcb_t *tcb)
     cr3 = makeCR3(pptr_to_paddr(pml4), asid);
     if (getCurrentUserCR3().words[0] != cr3.words[0]) {
         SMP_COND_STATEMENT(tlb_bitmap_set(pml4, getCurrentCPUIndex());)
+#if defined(ENABLE_SMP_SUPPORT) && defined(CONFIG_SUPPORT_PCID)
+        flushStalePCID(asid);
+#endif
         setCurrentUserCR3(cr3);
     }
 }
@@ -540,6 +543,22 @@ BOOT_CODE void map_it_frame_cap(cap_t pd_cap, cap_t frame_cap)
     assert(pdpte_pdpte_pd_ptr_get_present(pdpt));
     pd = paddr_to_pptr(pdpte_pdpte_pd_ptr_get_pd_base_address(pdpt));
     pd += GET_PD_INDEX(vptr);
+    if (cap_frame_cap_get_capFSize(frame_cap) == X86_LargePage) {
+        *pd = pde_pde_large_new(
+                  0,                      /* xd                   */
+                  pptr_to_paddr(pptr),    /* page_base_address    */
+                  0,                      /* pat                  */
+                  0,                      /* global               */
+                  0,                      /* dirty                */
+                  0,                      /* accessed             */
+                  0,                      /* cache_disabled       */
+                  0,                      /* write_through        */
+                  1,                      /* super_user           */
+                  1,                      /* read_write           */
+                  1                       /* present              */
+              );
+        return;
+    }
     assert(pde_pde_pt_ptr_get_present(pd));
     pt = paddr_to_pptr(pde_pde_pt_ptr_get_pt_base_address(pd));
     *(pt + GET_PT_INDEX(vptr)) = pte_new(
@@ -678,7 +697,7 @@ static BOOT_CODE cap_t create_it_pt_cap(cap_t vspace_cap, pptr_t pptr, vptr_t vp
 
 BOOT_CODE word_t arch_get_n_paging(v_region_t it_v_reg)
 {
-    word_t n = get_n_paging(it_v_reg, PD_INDEX_OFFSET);
+    word_t n = get_n_paging(it_v_reg, PD_INDEX_OFFSET) - get_n_it_large_pages();
     n += get_n_paging(it_v_reg, PDPT_INDEX_OFFSET);
     n += get_n_paging(it_v_reg, PML4_INDEX_OFFSET);
 #ifdef CONFIG_IOMMU
@@ -731,6 +750,9 @@ BOOT_CODE cap_t create_it_address_space(cap_t root_cnode_cap, v_region_t it_v_re
     for (vptr = ROUND_DOWN(it_v_reg.start, PD_INDEX_OFFSET);
          vptr < it_v_reg.end;
          vptr += BIT(PD_INDEX_OFFSET)) {
+        if (it_is_large_vptr(vptr)) {
+            continue;
+        }
         if (!provide_cap(root_cnode_cap,
                          create_it_pt_cap(vspace_cap, it_alloc_paging(), vptr, IT_ASID))
            ) {
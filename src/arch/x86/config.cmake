@@ -104,16 +104,74 @@ config_string(
     UNQUOTE
 )
 
+config_option(
+    KernelIOMMUInterruptRemapping IOMMU_INTERRUPT_REMAPPING
+    "Enable VT-d interrupt remapping. MSIs issued through IRQControl are entered into the \
+    interrupt remapping table at the index given by their handle, and should be programmed \
+    by user level in the remappable format. Compatibility format interrupts are still \
+    accepted so that IOAPIC routing keeps working."
+    DEFAULT OFF
+    DEPENDS "KernelIOMMU;NOT KernelVerificationBuild"
+)
+
 config_string(
     KernelMaxVPIDs MAX_VPIDS
-    "The kernel maintains a mapping of 16-bit VPIDs to VCPUs. This option should be \
-    sized as small as possible to save memory, but be at least the number of VCPUs that \
-    will be run for optimum performance."
+    "Size of the table through which IO port capabilities refer to VCPUs. This option \
+    should be sized as small as possible to save memory, but be at least the number of \
+    VCPUs that are given IO ports, as VCPUs evicted from the table lose their IO ports. \
+    Hardware VPIDs are allocated per core independently of this table."
     DEFAULT 1024
     DEPENDS "KernelVTX" DEFAULT_DISABLED 0
     UNQUOTE
 )
 
+config_option(
+    KernelVTXPostedInterrupts VTX_POSTED_INTERRUPTS
+    "Support VT-x posted interrupts. A VCPU can have remapped MSIs bound to it, which are \
+    then delivered by the IOMMU directly into the running guest without an exit to the \
+    kernel or the VCPU owner. An interrupt posted while the guest is not running wakes \
+    the VCPU owner through its bound notification. This increases the size of a VCPU \
+    object to hold its virtual-APIC page."
+    DEFAULT OFF
+    DEPENDS "KernelVTX;KernelIOMMUInterruptRemapping;KernelSel4ArchX86_64;NOT KernelVerificationBuild"
+)
+
+config_option(
+    KernelVTXFastExits VTX_FAST_EXITS
+    "Allow the VCPU owner to have selected VM exits handled by the kernel instead of \
+    returning them from seL4_VMEnter. CPUID is answered from a per-VCPU table of leaves, \
+    RDTSC from the TSC, RDMSR and WRMSR of whitelisted MSRs from a per-VCPU MSR area, \
+    and HLT waits on the bound notification of the VCPU thread."
+    DEFAULT OFF
+    DEPENDS "KernelVTX;NOT KernelVerificationBuild"
+)
+
+config_string(
+    KernelVTXFastExitCPUIDEntries VTX_FAST_EXIT_CPUID_ENTRIES
+    "Number of CPUID leaves that each VCPU holds for the in-kernel handling of CPUID exits."
+    DEFAULT 8
+    DEPENDS "KernelVTXFastExits" DEFAULT_DISABLED 0
+    UNQUOTE
+)
+
+config_string(
+    KernelVTXFastExitMSREntries VTX_FAST_EXIT_MSR_ENTRIES
+    "Number of MSRs that each VCPU holds for the in-kernel handling of RDMSR and WRMSR exits."
+    DEFAULT 8
+    DEPENDS "KernelVTXFastExits" DEFAULT_DISABLED 0
+    UNQUOTE
+)
+
+config_option(
+    KernelVTXEPTDirtyFlags VTX_EPT_DIRTY_FLAGS
+    "Enable the accessed and dirty flags of EPT on processors that support them, so that \
+    the VCPU owner can collect the guest pages written to with seL4_X86_EPTPML4_HarvestDirty. \
+    The processor then sets the flags on guest accesses, which adds to the cost of guest \
+    page walks."
+    DEFAULT OFF
+    DEPENDS "KernelVTX;NOT KernelVerificationBuild"
+)
+
 config_option(
     KernelHugePage HUGE_PAGE
     "Add support for 1GB huge page. Not all recent processor models support this feature."
@@ -170,6 +228,7 @@ config_choice(
     "XSAVEOPT;KernelXSaveXSaveOpt;XSAVE_XSAVEOPT;KernelFPUXSave"
     "XSAVE;KernelXSaveXSave;XSAVE_XSAVE;KernelFPUXSave"
     "XSAVEC;KernelXSaveXSaveC;XSAVE_XSAVEC;KernelFPUXSave"
+    "XSAVES;KernelXSaveXSaveS;XSAVE_XSAVES;KernelFPUXSave"
 )
 config_string(
     KernelXSaveFeatureSet XSAVE_FEATURE_SET
@@ -179,7 +238,8 @@ config_string(
         0 - FPU \
         1 - SSE \
         2 - AVX \
-        FPU and SSE is guaranteed to exist if XSAVE exists."
+        FPU and SSE is guaranteed to exist if XSAVE exists. Supervisor state components, such \
+        as 8 - PT or 11, 12 - CET, are enabled through IA32_XSS and require KernelXSave to be XSAVES."
     DEFAULT 3
     DEPENDS "KernelFPUXSave" DEFAULT_DISABLED 0
     UNQUOTE
@@ -201,6 +261,18 @@ config_string(
     UNQUOTE
 )
 
+config_option(
+    KernelXSaveThreadFeatures XSAVE_THREAD_FEATURES
+    "Allow the XSAVE feature mask of a thread to be restricted to a subset of \
+    KernelXSaveFeatureSet with seL4_TCB_SetXSaveFeatures. Only the selected state components \
+    are saved and restored for the thread, and XCR0 is set to the selected mask while the \
+    thread owns the FPU, so accessing any other component raises an invalid opcode fault. \
+    With XSAVEC or XSAVES the state is stored in compacted format, so a thread that only \
+    uses the FPU and SSE state never touches the space reserved for larger components."
+    DEFAULT OFF
+    DEPENDS "KernelFPUXSave; NOT KernelVerificationBuild"
+)
+
 config_choice(
     KernelFSGSBase
     KERNEL_FSGS_BASE
@@ -42,6 +42,10 @@ BOOT_CODE static void init_irqs(cap_t root_cnode_cap)
 #ifdef CONFIG_IOMMU
         } else if (i == irq_iommu) {
             setIRQState(IRQReserved, i);
+#endif
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+        } else if (i == irq_posted_interrupt) {
+            setIRQState(IRQReserved, i);
 #endif
         } else if (i == 2 && config_set(CONFIG_IRQ_PIC)) {
             /* cascaded legacy PIC */
@@ -120,6 +124,9 @@ BOOT_CODE bool_t init_sys_state(
     v_region_t it_v_reg;
     ui_v_reg.start = ui_info.p_reg.start - ui_info.pv_offset;
     ui_v_reg.end   = ui_info.p_reg.end   - ui_info.pv_offset;
+#ifdef CONFIG_ROOTSERVER_LARGE_PAGES
+    init_it_large_v_reg(ui_v_reg, ui_info.pv_offset);
+#endif
 
     ipcbuf_vptr = ui_v_reg.end;
     bi_frame_vptr = ipcbuf_vptr + BIT(PAGE_BITS);
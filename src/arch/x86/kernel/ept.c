@@ -130,7 +130,8 @@ static lookupEPTPDSlot_ret_t lookupEPTPDSlot(ept_pml4e_t *pml4, vptr_t vptr)
         return ret;
     }
 
-    if (!ept_pdpte_ptr_get_read(lu_ret.pdptSlot)) {
+    if ((ept_pdpte_ptr_get_page_size(lu_ret.pdptSlot) != ept_pdpte_ept_pdpte_pd) ||
+        !ept_pdpte_ept_pdpte_pd_ptr_get_read(lu_ret.pdptSlot)) {
         current_lookup_fault = lookup_fault_missing_capability_new(EPT_PDPT_INDEX_OFFSET);
 
         ret.pdSlot = NULL;
@@ -138,7 +139,7 @@ static lookupEPTPDSlot_ret_t lookupEPTPDSlot(ept_pml4e_t *pml4, vptr_t vptr)
         return ret;
     }
 
-    ept_pde_t *pd = paddr_to_pptr(ept_pdpte_ptr_get_pd_base_address(lu_ret.pdptSlot));
+    ept_pde_t *pd = paddr_to_pptr(ept_pdpte_ept_pdpte_pd_ptr_get_pd_base_address(lu_ret.pdptSlot));
     uint32_t index = GET_EPT_PD_INDEX(vptr);
     ret.pdSlot = pd + index;
     ret.status = EXCEPTION_NONE;
@@ -360,6 +361,228 @@ static exception_t decodeX86EPTPDPTInvocation(
     return performEPTPDPTInvocationMap(cap, cte, pml4e, pml4Slot, pml4);
 }
 
+/* Marks the guest physical pages [first, first + count) of a dirty mapping in
+ * the bitmap */
+static void setEPTDirtyBits(word_t *bitmap, word_t first, word_t count)
+{
+    word_t i;
+
+    for (i = first; i < first + count; i++) {
+        bitmap[i / wordBits] |= BIT(i % wordBits);
+    }
+}
+
+/* Number of 4K pages from vptr to the end of the region of size BIT(bits)
+ * that contains it */
+static inline uint64_t eptPagesToBoundary(uint64_t vptr, word_t bits)
+{
+    return ((1ull << bits) - (vptr & ((1ull << bits) - 1))) >> seL4_PageBits;
+}
+
+/* Whether span pages from vptr cover the whole leaf of size BIT(bits) */
+static inline bool_t eptSpanCoversLeaf(uint64_t vptr, word_t span, word_t bits)
+{
+    return (vptr & ((1ull << bits) - 1)) == 0 && span == BIT(bits - seL4_PageBits);
+}
+
+/* Whether the 1G region that contains vptr is mapped by a single 1G page */
+static bool_t eptHasHugePage(ept_pml4e_t *pml4, uint64_t vptr)
+{
+    ept_pml4e_t *pml4Slot = lookupEPTPML4Slot(pml4, vptr);
+    ept_pdpte_t *pdptSlot;
+
+    if (!ept_pml4e_ptr_get_read(pml4Slot)) {
+        return false;
+    }
+    pdptSlot = (ept_pdpte_t *)paddr_to_pptr(ept_pml4e_ptr_get_pdpt_base_address(pml4Slot)) +
+               GET_EPT_PDPT_INDEX(vptr);
+    return ept_pdpte_ptr_get_page_size(pdptSlot) == ept_pdpte_ept_pdpte_1g &&
+           ept_pdpte_ept_pdpte_1g_ptr_get_read(pdptSlot);
+}
+
+static exception_t performEPTPML4InvocationHarvestDirty(ept_pml4e_t *pml4, word_t *bitmap, vptr_t gpa,
+                                                        word_t pages)
+{
+    word_t page;
+    word_t dirty;
+    word_t span;
+    uint64_t vptr;
+    word_t *buffer;
+
+    memzero(bitmap, ROUND_UP(pages, wordRadix) / 8);
+
+    /* Walk the range and skip over anything that is not mapped. The
+     * hardware sets the dirty flag in the leaf entry of a mapping on the
+     * first guest write after it was cleared, so every dirty leaf is
+     * reported for all of the 4K pages it covers within the range. A large
+     * leaf that extends beyond the range keeps its flag, as clearing it
+     * would lose the writes to the pages outside the range */
+    dirty = 0;
+    for (page = 0; page < pages; page += span) {
+        ept_pml4e_t *pml4Slot;
+        ept_pdpte_t *pdptSlot;
+        ept_pde_t *pdSlot;
+        ept_pte_t *ptSlot;
+
+        vptr = (uint64_t)gpa + ((uint64_t)page << seL4_PageBits);
+
+        pml4Slot = lookupEPTPML4Slot(pml4, vptr);
+        if (!ept_pml4e_ptr_get_read(pml4Slot)) {
+            span = MIN(eptPagesToBoundary(vptr, EPT_PML4_INDEX_OFFSET), pages - page);
+            continue;
+        }
+
+        pdptSlot = (ept_pdpte_t *)paddr_to_pptr(ept_pml4e_ptr_get_pdpt_base_address(pml4Slot)) +
+                   GET_EPT_PDPT_INDEX(vptr);
+        span = MIN(eptPagesToBoundary(vptr, EPT_PDPT_INDEX_OFFSET), pages - page);
+        if (ept_pdpte_ptr_get_page_size(pdptSlot) == ept_pdpte_ept_pdpte_1g) {
+            /* ranges with 1G pages are rejected by the decode */
+            assert(!ept_pdpte_ept_pdpte_1g_ptr_get_read(pdptSlot));
+            continue;
+        }
+        if (!ept_pdpte_ept_pdpte_pd_ptr_get_read(pdptSlot)) {
+            continue;
+        }
+
+        pdSlot = (ept_pde_t *)paddr_to_pptr(ept_pdpte_ept_pdpte_pd_ptr_get_pd_base_address(pdptSlot)) +
+                 GET_EPT_PD_INDEX(vptr);
+        span = MIN(eptPagesToBoundary(vptr, EPT_PD_INDEX_OFFSET), pages - page);
+        if (ept_pde_ptr_get_page_size(pdSlot) == ept_pde_ept_pde_2m) {
+            if (ept_pde_ept_pde_2m_ptr_get_read(pdSlot) &&
+                ept_pde_ept_pde_2m_ptr_get_dirty(pdSlot)) {
+                if (eptSpanCoversLeaf(vptr, span, EPT_PD_INDEX_OFFSET)) {
+                    ept_pde_ept_pde_2m_ptr_set_dirty(pdSlot, 0);
+                }
+                setEPTDirtyBits(bitmap, page, span);
+                dirty += span;
+            }
+            continue;
+        }
+        if (!ept_pde_ept_pde_pt_ptr_get_read(pdSlot)) {
+            continue;
+        }
+
+        ptSlot = (ept_pte_t *)paddr_to_pptr(ept_pde_ept_pde_pt_ptr_get_pt_base_address(pdSlot)) +
+                 GET_EPT_PT_INDEX(vptr);
+        span = 1;
+        if (ept_pte_ptr_get_read(ptSlot) && ept_pte_ptr_get_dirty(ptSlot)) {
+            ept_pte_ptr_set_dirty(ptSlot, 0);
+            setEPTDirtyBits(bitmap, page, 1);
+            dirty++;
+        }
+    }
+
+    /* Cached translations may still allow writes without setting the dirty
+     * flag again */
+    if (dirty != 0) {
+        invept(pml4);
+    }
+
+    buffer = lookupIPCBuffer(true, NODE_STATE(ksCurThread));
+    setRegister(NODE_STATE(ksCurThread), badgeRegister, 0);
+    setMR(NODE_STATE(ksCurThread), buffer, 0, dirty);
+    setRegister(NODE_STATE(ksCurThread), msgInfoRegister,
+                wordFromMessageInfo(seL4_MessageInfo_new(0, 0, 0, 1)));
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
+
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeX86EPTPML4Invocation(
+    word_t invLabel,
+    word_t length,
+    cte_t *cte,
+    cap_t cap,
+    word_t *buffer
+)
+{
+    vptr_t gpa;
+    word_t pages;
+    uint64_t end;
+    uint64_t vptr;
+    cap_t bitmapCap;
+    ept_pml4e_t *pml4;
+    findEPTForASID_ret_t find_ret;
+
+    if (invLabel != X86EPTPML4HarvestDirty) {
+        userError("X86EPTPML4: Illegal operation.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (length < 2 || current_extra_caps.excaprefs[0] == NULL) {
+        userError("X86EPTPML4HarvestDirty: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (!vmx_feature_ept_ad) {
+        userError("X86EPTPML4HarvestDirty: EPT dirty flags are not enabled or not supported by the processor.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    gpa = getSyscallArg(0, buffer);
+    pages = getSyscallArg(1, buffer);
+    bitmapCap = current_extra_caps.excaprefs[0]->cap;
+
+    if (!cap_ept_pml4_cap_get_capPML4IsMapped(cap)) {
+        userError("X86EPTPML4HarvestDirty: EPT PML4 is not assigned to an ASID pool.");
+        current_syscall_error.type = seL4_InvalidCapability;
+        current_syscall_error.invalidCapNumber = 0;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    pml4 = (ept_pml4e_t *)cap_ept_pml4_cap_get_capPML4BasePtr(cap);
+    find_ret = findEPTForASID(cap_ept_pml4_cap_get_capPML4MappedASID(cap));
+    if (find_ret.status != EXCEPTION_NONE || find_ret.ept != pml4) {
+        userError("X86EPTPML4HarvestDirty: EPT PML4 is not assigned to an ASID pool.");
+        current_syscall_error.type = seL4_InvalidCapability;
+        current_syscall_error.invalidCapNumber = 0;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (cap_get_capType(bitmapCap) != cap_frame_cap ||
+        cap_frame_cap_get_capFIsDevice(bitmapCap) ||
+        cap_frame_cap_get_capFVMRights(bitmapCap) != VMReadWrite) {
+        userError("X86EPTPML4HarvestDirty: Bitmap must be a writable frame of memory.");
+        current_syscall_error.type = seL4_InvalidCapability;
+        current_syscall_error.invalidCapNumber = 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (!IS_ALIGNED(gpa, seL4_PageBits)) {
+        userError("X86EPTPML4HarvestDirty: Guest physical address must be page aligned.");
+        current_syscall_error.type = seL4_AlignmentError;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    /* The smallest frame holds a bit for each of the most pages we allow */
+    compile_assert(ept_harvest_bitmap_fits, seL4_X86_EPTHarvestMaxPages <= BIT(seL4_PageBits + 3))
+    end = (uint64_t)gpa + ((uint64_t)pages << seL4_PageBits);
+    if (pages == 0 || pages > seL4_X86_EPTHarvestMaxPages ||
+        end > (1ull << (EPT_PML4_INDEX_OFFSET + EPT_PML4_INDEX_BITS)) || (vptr_t)(end - 1) != end - 1) {
+        userError("X86EPTPML4HarvestDirty: Invalid range.");
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 1;
+        current_syscall_error.rangeErrorMax = seL4_X86_EPTHarvestMaxPages;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    /* A call can never cover all of a 1G page, so its dirty flag could never
+     * be cleared. The range spans at most two 1G regions. */
+    for (vptr = gpa; vptr < end; vptr = (vptr | MASK(EPT_PDPT_INDEX_OFFSET)) + 1) {
+        if (eptHasHugePage(pml4, vptr)) {
+            userError("X86EPTPML4HarvestDirty: Range contains a 1G page.");
+            current_syscall_error.type = seL4_IllegalOperation;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+    }
+
+    return performEPTPML4InvocationHarvestDirty(pml4, (word_t *)cap_frame_cap_get_capFBasePtr(bitmapCap), gpa,
+                                                pages);
+}
+
 exception_t decodeX86EPTInvocation(
     word_t invLabel,
     word_t length,
@@ -370,6 +593,8 @@ exception_t decodeX86EPTInvocation(
 )
 {
     switch (cap_get_capType(cap)) {
+    case cap_ept_pml4_cap:
+        return decodeX86EPTPML4Invocation(invLabel, length, cte, cap, buffer);
     case cap_ept_pdpt_cap:
         return decodeX86EPTPDPTInvocation(invLabel, length, cte, cap, buffer);
     case cap_ept_pd_cap:
@@ -403,8 +628,9 @@ EPTPageDirectoryMapped_ret_t EPTPageDirectoryMapped(asid_t asid, vptr_t vaddr, e
         return ret;
     }
 
-    if (ept_pdpte_ptr_get_read(find_ret.pdptSlot)
-        && ptrFromPAddr(ept_pdpte_ptr_get_pd_base_address(find_ret.pdptSlot)) == pd) {
+    if (ept_pdpte_ptr_get_page_size(find_ret.pdptSlot) == ept_pdpte_ept_pdpte_pd
+        && ept_pdpte_ept_pdpte_pd_ptr_get_read(find_ret.pdptSlot)
+        && ptrFromPAddr(ept_pdpte_ept_pdpte_pd_ptr_get_pd_base_address(find_ret.pdptSlot)) == pd) {
         ret.pml4 = asid_ret.ept;
         ret.pdptSlot = find_ret.pdptSlot;
         ret.status = EXCEPTION_NONE;
@@ -424,7 +650,7 @@ void unmapEPTPageDirectory(asid_t asid, vptr_t vaddr, ept_pde_t *pd)
     lu_ret = EPTPageDirectoryMapped(asid, vaddr, pd);
 
     if (lu_ret.status == EXCEPTION_NONE) {
-        *lu_ret.pdptSlot = ept_pdpte_new(
+        *lu_ret.pdptSlot = ept_pdpte_ept_pdpte_pd_new(
                                0,  /* pd_base_address  */
                                0,  /* avl_cte_depth    */
                                0,  /* execute          */
@@ -546,14 +772,17 @@ exception_t decodeX86EPTPDInvocation(
         return EXCEPTION_SYSCALL_ERROR;
     }
 
-    if (ept_pdpte_ptr_get_read(lu_ret.pdptSlot)) {
+    if (((ept_pdpte_ptr_get_page_size(lu_ret.pdptSlot) == ept_pdpte_ept_pdpte_pd) &&
+         ept_pdpte_ept_pdpte_pd_ptr_get_read(lu_ret.pdptSlot)) ||
+        ((ept_pdpte_ptr_get_page_size(lu_ret.pdptSlot) == ept_pdpte_ept_pdpte_1g) &&
+         ept_pdpte_ept_pdpte_1g_ptr_get_read(lu_ret.pdptSlot))) {
         userError("X86EPTPDMap: Page directory already mapped here.");
         current_syscall_error.type = seL4_DeleteFirst;
         return EXCEPTION_SYSCALL_ERROR;
     }
 
     paddr = pptr_to_paddr((void *)(cap_ept_pd_cap_get_capPDBasePtr(cap)));
-    pdpte = ept_pdpte_new(
+    pdpte = ept_pdpte_ept_pdpte_pd_new(
                 paddr,  /* pd_base_address  */
                 0,      /* avl_cte_depth    */
                 1,      /* execute          */
@@ -781,6 +1010,18 @@ static exception_t performEPTPageMapPDE(cap_t cap, cte_t *cte, ept_pde_t *pdSlot
     return EXCEPTION_NONE;
 }
 
+#ifdef CONFIG_HUGE_PAGE
+static exception_t performEPTPageMapPDPTE(cap_t cap, cte_t *cte, ept_pdpte_t *pdptSlot, ept_pdpte_t pdpte,
+                                          ept_pml4e_t *pml4)
+{
+    *pdptSlot = pdpte;
+    cte->cap = cap;
+    invept(pml4);
+
+    return EXCEPTION_NONE;
+}
+#endif
+
 exception_t decodeX86EPTPageMap(
     word_t invLabel,
     word_t length,
@@ -884,6 +1125,8 @@ exception_t decodeX86EPTPageMap(
                   paddr,
                   0,
                   0,
+                  0,
+                  0,
                   eptCacheFromVmAttr(vmAttr),
                   1,
                   WritableFromVMRights(vmRights),
@@ -931,6 +1174,8 @@ exception_t decodeX86EPTPageMap(
                              paddr,
                              0,
                              0,
+                             0,
+                             0,
                              eptCacheFromVmAttr(vmAttr),
                              1,
                              WritableFromVMRights(vmRights),
@@ -940,6 +1185,8 @@ exception_t decodeX86EPTPageMap(
                              paddr + BIT(EPT_PD_INDEX_OFFSET),
                              0,
                              0,
+                             0,
+                             0,
                              eptCacheFromVmAttr(vmAttr),
                              1,
                              WritableFromVMRights(vmRights),
@@ -949,9 +1196,60 @@ exception_t decodeX86EPTPageMap(
         return performEPTPageMapPDE(cap, cte, lu_ret.pdSlot, pde1, pde2, pml4);
     }
 
+#ifdef CONFIG_HUGE_PAGE
+    /* PDPTE mappings */
+    case X64_HugePage: {
+        lookupEPTPDPTSlot_ret_t lu_ret;
+        ept_pdpte_t pdpte;
+
+        if (!vmx_feature_ept_1g) {
+            userError("X86EPTPageMap: 1G pages are not supported by the processor.");
+            current_syscall_error.type = seL4_InvalidCapability;
+            current_syscall_error.invalidCapNumber = 0;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        lu_ret = lookupEPTPDPTSlot(pml4, vaddr);
+        if (lu_ret.status != EXCEPTION_NONE) {
+            userError("X86EPTPageMap: Need a page directory pointer table first.");
+            current_syscall_error.type = seL4_FailedLookup;
+            current_syscall_error.failedLookupWasSource = false;
+            /* current_lookup_fault will have been set by lookupEPTPDPTSlot */
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        if ((ept_pdpte_ptr_get_page_size(lu_ret.pdptSlot) == ept_pdpte_ept_pdpte_pd) &&
+            ept_pdpte_ept_pdpte_pd_ptr_get_read(lu_ret.pdptSlot)) {
+            userError("X86EPTPageMap: Page directory already present.");
+            current_syscall_error.type = seL4_DeleteFirst;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+        if ((ept_pdpte_ptr_get_page_size(lu_ret.pdptSlot) == ept_pdpte_ept_pdpte_1g) &&
+            ept_pdpte_ept_pdpte_1g_ptr_get_read(lu_ret.pdptSlot)) {
+            userError("X86EPTPageMap: Mapping already present.");
+            current_syscall_error.type = seL4_DeleteFirst;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        pdpte = ept_pdpte_ept_pdpte_1g_new(
+                    paddr,
+                    0,
+                    0,
+                    0,
+                    eptCacheFromVmAttr(vmAttr),
+                    1,
+                    WritableFromVMRights(vmRights),
+                    1);
+
+        setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+        return performEPTPageMapPDPTE(cap, cte, lu_ret.pdptSlot, pdpte, pml4);
+    }
+#endif
+
     default:
         /* When initializing EPT we only checked for support for 4K and 2M
-         * pages, so we must disallow attempting to use any other */
+         * pages, and 1G pages are only used if the processor supports them,
+         * so we must disallow attempting to use any other */
         userError("X86EPTPageMap: Attempted to map unsupported page size.");
         current_syscall_error.type = seL4_InvalidCapability;
         current_syscall_error.invalidCapNumber = 0;
@@ -984,7 +1282,7 @@ void unmapEPTPage(vm_page_size_t page_size, asid_t asid, vptr_t vptr, void *pptr
             return;
         }
 
-        *lu_ret.ptSlot = ept_pte_new(0, 0, 0, 0, 0, 0, 0);
+        *lu_ret.ptSlot = ept_pte_new(0, 0, 0, 0, 0, 0, 0, 0, 0);
         break;
     }
     case X86_LargePage: {
@@ -1004,17 +1302,39 @@ void unmapEPTPage(vm_page_size_t page_size, asid_t asid, vptr_t vptr, void *pptr
             return;
         }
 
-        lu_ret.pdSlot[0] = ept_pde_ept_pde_2m_new(0, 0, 0, 0, 0, 0, 0);
+        lu_ret.pdSlot[0] = ept_pde_ept_pde_2m_new(0, 0, 0, 0, 0, 0, 0, 0, 0);
 
         if (LARGE_PAGE_BITS != EPT_PD_INDEX_OFFSET) {
             assert(ept_pde_ptr_get_page_size(lu_ret.pdSlot + 1) == ept_pde_ept_pde_2m);
             assert(ept_pde_ept_pde_2m_ptr_get_read(lu_ret.pdSlot + 1));
             assert(ept_pde_ept_pde_2m_ptr_get_page_base_address(lu_ret.pdSlot + 1) == addr + BIT(21));
 
-            lu_ret.pdSlot[1] = ept_pde_ept_pde_2m_new(0, 0, 0, 0, 0, 0, 0);
+            lu_ret.pdSlot[1] = ept_pde_ept_pde_2m_new(0, 0, 0, 0, 0, 0, 0, 0, 0);
         }
         break;
     }
+#ifdef CONFIG_HUGE_PAGE
+    case X64_HugePage: {
+        lookupEPTPDPTSlot_ret_t lu_ret;
+
+        lu_ret = lookupEPTPDPTSlot(find_ret.ept, vptr);
+        if (lu_ret.status != EXCEPTION_NONE) {
+            return;
+        }
+        if (ept_pdpte_ptr_get_page_size(lu_ret.pdptSlot) != ept_pdpte_ept_pdpte_1g) {
+            return;
+        }
+        if (!ept_pdpte_ept_pdpte_1g_ptr_get_read(lu_ret.pdptSlot)) {
+            return;
+        }
+        if (ept_pdpte_ept_pdpte_1g_ptr_get_page_base_address(lu_ret.pdptSlot) != addr) {
+            return;
+        }
+
+        *lu_ret.pdptSlot = ept_pdpte_ept_pdpte_1g_new(0, 0, 0, 0, 0, 0, 0, 0);
+        break;
+    }
+#endif
     default:
         /* we did not allow mapping additional page sizes into EPT objects,
          * so this should not happen. As we have no way to return an error
@@ -924,6 +924,80 @@ static create_mapping_pde_return_t createSafeMappingEntries_PDE(paddr_t base, wo
 }
 
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+bool_t Arch_checkGrantFrame(cap_t cap, tcb_t *receiver, vptr_t vaddr, bool_t replacing)
+{
+    cap_t threadRoot = TCB_PTR_CTE_PTR(receiver, tcbVTable)->cap;
+    vm_page_size_t frameSize = cap_frame_cap_get_capFSize(cap);
+
+    if (unlikely(!isValidNativeRoot(threadRoot) || !checkVPAlignment(frameSize, vaddr) ||
+                 vaddr + BIT(pageBitsForSize(frameSize)) > USER_TOP)) {
+        return false;
+    }
+
+    vspace_root_t *vspace = (vspace_root_t *)pptr_of_cap(threadRoot);
+    vm_rights_t vmRights = cap_frame_cap_get_capFVMRights(cap);
+    paddr_t paddr = pptr_to_paddr((void *)cap_frame_cap_get_capFBasePtr(cap));
+    cap_t grantCap = TCB_PTR_CTE_PTR(receiver, tcbGrantFrame)->cap;
+    replacing = replacing && cap_frame_cap_get_capFMappedASID(grantCap) == cap_get_capMappedASID(threadRoot);
+
+    /* The window must be backed by paging structures for this frame size, and
+     * must not be mapped by anything but the previous grant */
+    switch (frameSize) {
+    case X86_SmallPage: {
+        create_mapping_pte_return_t map_ret;
+
+        map_ret = createSafeMappingEntries_PTE(paddr, vaddr, vmRights, vmAttributesFromWord(0), vspace);
+        return map_ret.status == EXCEPTION_NONE && (replacing || !pte_ptr_get_present(map_ret.ptSlot));
+    }
+
+    case X86_LargePage: {
+        create_mapping_pde_return_t map_ret;
+
+        map_ret = createSafeMappingEntries_PDE(paddr, vaddr, vmRights, vmAttributesFromWord(0), vspace);
+        return map_ret.status == EXCEPTION_NONE &&
+               (replacing || pde_ptr_get_page_size(map_ret.pdSlot) != pde_pde_large ||
+                !pde_pde_large_ptr_get_present(map_ret.pdSlot));
+    }
+
+    default:
+        /* Huge pages are refused, they would need the mode specific PDPTE path */
+        return false;
+    }
+}
+
+void Arch_mapGrantFrame(cap_t cap, cte_t *srcSlot, tcb_t *receiver, vptr_t vaddr)
+{
+    cap_t threadRoot = TCB_PTR_CTE_PTR(receiver, tcbVTable)->cap;
+    vm_page_size_t frameSize = cap_frame_cap_get_capFSize(cap);
+    cte_t *grantSlot = TCB_PTR_CTE_PTR(receiver, tcbGrantFrame);
+    vspace_root_t *vspace = (vspace_root_t *)pptr_of_cap(threadRoot);
+    vm_rights_t vmRights = cap_frame_cap_get_capFVMRights(cap);
+    paddr_t paddr = pptr_to_paddr((void *)cap_frame_cap_get_capFBasePtr(cap));
+
+    cap = cap_frame_cap_set_capFMappedASID(cap, cap_get_capMappedASID(threadRoot));
+    cap = cap_frame_cap_set_capFMappedAddress(cap, vaddr);
+    cap = cap_frame_cap_set_capFMapType(cap, X86_MappingVSpace);
+
+    if (frameSize == X86_SmallPage) {
+        create_mapping_pte_return_t map_ret;
+
+        map_ret = createSafeMappingEntries_PTE(paddr, vaddr, vmRights, vmAttributesFromWord(0), vspace);
+        assert(map_ret.status == EXCEPTION_NONE && !pte_ptr_get_present(map_ret.ptSlot));
+        cteInsert(cap, srcSlot, grantSlot);
+        performX86PageInvocationMapPTE(cap, grantSlot, map_ret.ptSlot, map_ret.pte, vspace);
+    } else {
+        create_mapping_pde_return_t map_ret;
+
+        assert(frameSize == X86_LargePage);
+        map_ret = createSafeMappingEntries_PDE(paddr, vaddr, vmRights, vmAttributesFromWord(0), vspace);
+        assert(map_ret.status == EXCEPTION_NONE);
+        cteInsert(cap, srcSlot, grantSlot);
+        performX86PageInvocationMapPDE(cap, grantSlot, map_ret.pdSlot, map_ret.pde, vspace);
+    }
+}
+#endif /* CONFIG_IPC_FRAME_GRANT */
+
 exception_t decodeX86FrameInvocation(
     word_t invLabel,
     word_t length,
@@ -55,6 +55,11 @@ bool_t apic_is_interrupt_pending(void)
     return false;
 }
 
+bool_t apic_is_vector_pending(interrupt_t vector)
+{
+    return !!(apic_read_reg(APIC_IRR_BASE + vector / 32) & BIT(vector % 32));
+}
+
 BOOT_CODE void apic_send_init_ipi(cpu_id_t cpu_id)
 {
     apic_write_icr(
@@ -36,7 +36,10 @@ BOOT_CODE bool_t Arch_initFpu(void)
     if (config_set(CONFIG_XSAVE)) {
         uint64_t xsave_features;
         uint32_t xsave_instruction;
+        uint32_t xsave_size;
         uint64_t desired_features = config_ternary(CONFIG_XSAVE, CONFIG_XSAVE_FEATURE_SET, 1);
+        uint64_t user_features = desired_features & ~XSAVE_SUPERVISOR_FEATURES;
+        uint64_t supervisor_features = desired_features & XSAVE_SUPERVISOR_FEATURES;
         xsave_state_t *nullFpuState = (xsave_state_t *) &x86KSnullFpuState;
 
         /* create NULL state for FPU to be used by XSAVE variants */
@@ -51,22 +54,20 @@ BOOT_CODE bool_t Arch_initFpu(void)
         write_cr4(read_cr4() | CR4_OSXSAVE);
         /* check feature mask */
         xsave_features = ((uint64_t)x86_cpuid_edx(0x0d, 0x0) << 32) | x86_cpuid_eax(0x0d, 0x0);
-        if ((xsave_features & desired_features) != desired_features) {
-            printf("Requested feature mask is 0x%llx, but only 0x%llx supported\n", desired_features, (long long)xsave_features);
+        if ((xsave_features & user_features) != user_features) {
+            printf("Requested feature mask is 0x%llx, but only 0x%llx supported\n", user_features, (long long)xsave_features);
             return false;
         }
-        /* enable feature mask */
-        write_xcr0(desired_features);
-        /* validate the xsave buffer size and instruction */
-        if (x86_cpuid_ebx(0x0d, 0x0) > CONFIG_XSAVE_SIZE) {
-            printf("XSAVE buffer set set to %d, but needs to be at least %d\n", CONFIG_XSAVE_SIZE, x86_cpuid_ebx(0x0d, 0x0));
+        if (supervisor_features && !config_set(CONFIG_XSAVE_XSAVES)) {
+            printf("Supervisor state 0x%llx requested, but only XSAVES can save it\n", supervisor_features);
             return false;
         }
-        if (x86_cpuid_ebx(0x0d, 0x0) < CONFIG_XSAVE_SIZE) {
-            printf("XSAVE buffer set set to %d, but only needs to be %d.\n"
-                   "Warning: Memory may be wasted with larger than needed TCBs.\n",
-                   CONFIG_XSAVE_SIZE, x86_cpuid_ebx(0x0d, 0x0));
-        }
+        /* enable feature mask */
+        write_xcr0(user_features);
+#ifdef CONFIG_XSAVE_THREAD_FEATURES
+        ARCH_NODE_STATE(x86KSCurrentXCR0) = user_features;
+#endif
+        xsave_size = x86_cpuid_ebx(0x0d, 0x0);
         /* check if a specialized XSAVE instruction was requested */
         xsave_instruction = x86_cpuid_eax(0x0d, 0x1);
         if (config_set(CONFIG_XSAVE_XSAVEOPT)) {
@@ -85,11 +86,32 @@ BOOT_CODE bool_t Arch_initFpu(void)
                 return false;
             }
 
+            /* supervisor state components are enabled through IA32_XSS, not XCR0 */
+            xsave_features = ((uint64_t)x86_cpuid_edx(0x0d, 0x1) << 32) | x86_cpuid_ecx(0x0d, 0x1);
+            if ((xsave_features & supervisor_features) != supervisor_features) {
+                printf("Requested supervisor mask is 0x%llx, but only 0x%llx supported\n", supervisor_features,
+                       (long long)xsave_features);
+                return false;
+            }
+
             /* AVX state from extended region should be in compacted format */
             nullFpuState->header.xcomp_bv = XCOMP_BV_COMPACTED_FORMAT;
 
             /* initialize the XSS MSR */
-            x86_wrmsr(IA32_XSS_MSR, desired_features);
+            x86_wrmsr(IA32_XSS_MSR, supervisor_features);
+
+            /* the compacted area holds the XCR0 | IA32_XSS components */
+            xsave_size = x86_cpuid_ebx(0x0d, 0x1);
+        }
+        /* validate the xsave buffer size */
+        if (xsave_size > CONFIG_XSAVE_SIZE) {
+            printf("XSAVE buffer set set to %d, but needs to be at least %d\n", CONFIG_XSAVE_SIZE, xsave_size);
+            return false;
+        }
+        if (xsave_size < CONFIG_XSAVE_SIZE) {
+            printf("XSAVE buffer set set to %d, but only needs to be %d.\n"
+                   "Warning: Memory may be wasted with larger than needed TCBs.\n",
+                   CONFIG_XSAVE_SIZE, xsave_size);
         }
 
         /* copy i387 FPU initial state from FPU */
@@ -29,6 +29,11 @@ asid_pool_t *x86KSASIDTable[BIT(asidHighBits)];
 UP_STATE_DEFINE(word_t, x86KSCurrentFSBase);
 UP_STATE_DEFINE(word_t, x86KSCurrentGSBase);
 
+#ifdef CONFIG_XSAVE_THREAD_FEATURES
+/* User state components currently enabled in XCR0 */
+UP_STATE_DEFINE(uint64_t, x86KSCurrentXCR0);
+#endif
+
 UP_STATE_DEFINE(word_t, x86KSGPExceptReturnTo);
 
 /* ==== read-only kernel state (only written during bootstrapping) ==== */
@@ -51,10 +56,26 @@ vtd_rte_t *x86KSvtdRootTable;
 uint32_t x86KSnumIOPTLevels;
 uint32_t x86KSnumIODomainIDBits;
 uint32_t x86KSFirstValidIODomain;
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+/* Intel VT-d Interrupt Remapping Table */
+vtd_irte_t *x86KSvtdIRT;
+/* Invalidation queue of each IOMMU and the next free descriptor in it */
+uint64_t *x86KSvtdInvQueue[MAX_NUM_DRHU];
+uint32_t x86KSvtdInvQueueTail[MAX_NUM_DRHU];
+#endif
 #endif
 
 #ifdef CONFIG_VTX
 UP_STATE_DEFINE(vcpu_t *, x86KSCurrentVCPU);
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+UP_STATE_DEFINE(vcpu_t *, x86KSPostedVCPUs);
+#endif
+UP_STATE_DEFINE(word_t, x86KSNextVPID);
+UP_STATE_DEFINE(uint64_t, x86KSVPIDGeneration);
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+UP_STATE_DEFINE(timestamp_t, benchmark_vpid_rollovers);
+UP_STATE_DEFINE(timestamp_t, benchmark_vpid_evictions);
+#endif
 #endif
 
 #ifdef CONFIG_PRINTING
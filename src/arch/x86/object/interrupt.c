@@ -19,6 +19,9 @@ void Arch_irqStateInit(void)
         if (i == irq_timer
 #ifdef CONFIG_IOMMU
             || i == irq_iommu
+#endif
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+            || i == irq_posted_interrupt
 #endif
            ) {
             x86KSIRQState[i] = x86_irq_state_irq_reserved_new();
@@ -51,6 +54,18 @@ exception_t Arch_checkIRQ(word_t irq_w)
     return EXCEPTION_SYSCALL_ERROR;
 }
 
+void Arch_deletedIRQHandler(irq_t irq)
+{
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+    x86_irq_state_t state = x86KSIRQState[irq];
+
+    /* The entry may post the MSI to a VCPU, which must not outlive the handler */
+    if (x86_irq_state_get_irqType(state) == x86_irq_state_irq_msi) {
+        vtd_unmap_msi(x86_irq_state_irq_msi_get_handle(state));
+    }
+#endif
+}
+
 static exception_t Arch_invokeIRQControl(irq_t irq, cte_t *handlerSlot, cte_t *controlSlot, x86_irq_state_t irqState)
 {
     updateIRQState(irq, irqState);
@@ -151,8 +166,8 @@ exception_t Arch_decodeIRQControlInvocation(word_t invLabel, word_t length, cte_
         word_t pci_func = getSyscallArg(4, buffer);
         word_t handle = getSyscallArg(5, buffer);
         x86_irq_state_t irqState;
-        /* until we support msi interrupt remaping through vt-d we ignore the
-         * vector and trust the user */
+        /* without interrupt remapping we ignore the vector and trust the user,
+         * otherwise the handle selects the remapping entry for the device */
 
         if (pci_bus > PCI_BUS_MAX) {
             current_syscall_error.type = seL4_RangeError;
@@ -175,9 +190,32 @@ exception_t Arch_decodeIRQControlInvocation(word_t invLabel, word_t length, cte_
             return EXCEPTION_SYSCALL_ERROR;
         }
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+        if (handle >= N_VTD_IRTES) {
+            userError("IRQControl: MSI handle %d should be less than %d", (int)handle, (int)N_VTD_IRTES);
+            current_syscall_error.type = seL4_RangeError;
+            current_syscall_error.rangeErrorMin = 0;
+            current_syscall_error.rangeErrorMax = N_VTD_IRTES - 1;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        for (irq_t other = irq_user_min; other <= irq_user_max; other++) {
+            x86_irq_state_t otherState = x86KSIRQState[other];
+            if (isIRQActive(other) && x86_irq_state_get_irqType(otherState) == x86_irq_state_irq_msi &&
+                x86_irq_state_irq_msi_get_handle(otherState) == handle) {
+                userError("IRQControl: MSI handle %d is already in use.", (int)handle);
+                current_syscall_error.type = seL4_RevokeFirst;
+                return EXCEPTION_SYSCALL_ERROR;
+            }
+        }
+#endif
+
         irqState = x86_irq_state_irq_msi_new(pci_bus, pci_dev, pci_func, handle);
 
         setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+        vtd_map_msi(handle, (pci_bus << 8) | (pci_dev << 3) | pci_func, vector);
+#endif
         return Arch_invokeIRQControl(irq, destSlot, srcSlot, irqState);
     }
     break;
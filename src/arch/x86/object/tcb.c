@@ -81,6 +81,41 @@ exception_t decodeSetEPTRoot(cap_t cap)
 }
 #endif
 
+#ifdef CONFIG_XSAVE_THREAD_FEATURES
+static exception_t performSetXSaveFeatures(tcb_t *tcb, uint64_t features)
+{
+    /* Save out any live state with the old mask before changing it */
+    if (nativeThreadUsingFPU(tcb)) {
+        switchFpuOwner(NULL, SMP_TERNARY(tcb->tcbAffinity, 0));
+    }
+    ((xsave_state_t *)&tcb->tcbArch.tcbContext.fpuState)->i387.sw_xfeatures = features;
+
+    return EXCEPTION_NONE;
+}
+
+exception_t decodeSetXSaveFeatures(cap_t cap, word_t length, word_t *buffer)
+{
+    uint64_t features;
+
+    if (length < 1) {
+        userError("TCB SetXSaveFeatures: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    features = getSyscallArg(0, buffer);
+    if (features != 0 && !xsave_features_valid(features)) {
+        userError("TCB SetXSaveFeatures: Invalid feature mask 0x%llx.", (unsigned long long)features);
+        current_syscall_error.type = seL4_InvalidArgument;
+        current_syscall_error.invalidArgumentNumber = 0;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return performSetXSaveFeatures(TCB_PTR(cap_thread_cap_get_capTCBPtr(cap)), features);
+}
+#endif /* CONFIG_XSAVE_THREAD_FEATURES */
+
 #ifdef ENABLE_SMP_SUPPORT
 void Arch_migrateTCB(tcb_t *thread)
 {
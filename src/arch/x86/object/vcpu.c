@@ -20,6 +20,13 @@
 #include <arch/object/ioport.h>
 #include <util.h>
 #include <sel4/arch/vmenter.h>
+#include <benchmark/benchmark_track.h>
+#ifdef CONFIG_VTX_FAST_EXITS
+#include <object/notification.h>
+#endif
+#if defined(CONFIG_VTX_FAST_EXITS) || defined(CONFIG_VCPU_EXIT_STATS)
+#include <mode/api/ipc_buffer.h>
+#endif
 
 #define VMX_EXIT_QUAL_TYPE_MOV_CR 0
 #define VMX_EXIT_QUAL_TYPE_CLTS 2
@@ -84,9 +91,32 @@ static uint32_t cr4_low;
 static bool_t vmx_feature_vpid;
 static bool_t vmx_feature_load_perf_global_ctrl;
 static bool_t vmx_feature_ack_on_exit;
+/* Optional EPT features that the EPT code checks for when mapping pages or
+ * harvesting dirty bits */
+bool_t vmx_feature_ept_1g;
+bool_t vmx_feature_ept_ad;
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+static bool_t vmx_feature_posted_interrupts;
+
+/* Controls that stay set for as long as a VCPU uses posted interrupts */
+#define VMX_PIN_POSTED_INTERRUPTS   BIT(7)  //Process posted interrupts
+#define VMX_PRIMARY_TPR_SHADOW      BIT(21) //Use TPR shadow
+#define VMX_SECONDARY_VIRTUAL_APIC  (BIT(0) | BIT(8) | BIT(9)) //Virtualize APIC accesses, APIC-register
+                                                               //virtualization, virtual-interrupt delivery
+#endif
+
+#ifdef CONFIG_VTX_FAST_EXITS
+#define VMX_PRIMARY_TSC_OFFSETTING  BIT(3)  //Use TSC offsetting
+#define VMX_GUEST_INTERRUPTABILITY_STI_MOV_SS MASK(2) //Blocking by STI and by MOV SS
 
-static vcpu_t *x86KSVPIDTable[VPID_LAST + 1];
-static vpid_t x86KSNextVPID = VPID_FIRST;
+#define MSR_VALUE_ARG_SIZE (sizeof(uint64_t) / sizeof(word_t))
+#endif
+
+/* VCPUs that IO port capabilities refer to, indexed by the capIOPortVPID of
+ * the capability. This is separate from the hardware VPIDs, which are
+ * allocated per core. */
+static vcpu_t *x86KSIOPortVCPUTable[VPID_LAST + 1];
+static vpid_t x86KSNextIOPortID = VPID_FIRST;
 
 static inline bool_t vmxon(paddr_t vmxon_region)
 {
@@ -157,6 +187,48 @@ void vcpu_restore_host_msrs(void)
 }
 #endif
 
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+static cpu_id_t currentAPICID(void)
+{
+#ifdef ENABLE_SMP_SUPPORT
+    return getCurrentCPUID();
+#else
+    /* xAPIC IDs are held in the top byte of the ID register */
+    return config_set(CONFIG_XAPIC) ? apic_read_reg(APIC_ID) >> 24 : apic_read_reg(APIC_ID);
+#endif
+}
+
+static uint32_t postedInterruptDestination(void)
+{
+    /* in xAPIC mode the APIC ID sits in bits 15:8 of the destination */
+    return config_set(CONFIG_XAPIC) ? currentAPICID() << 8 : currentAPICID();
+}
+
+/* Record vcpu as one whose notifications are sent to the current core */
+static void postedVCPUsAdd(vcpu_t *vcpu)
+{
+    vcpu->pi_prev = NULL;
+    vcpu->pi_next = ARCH_NODE_STATE(x86KSPostedVCPUs);
+    if (vcpu->pi_next) {
+        vcpu->pi_next->pi_prev = vcpu;
+    }
+    ARCH_NODE_STATE(x86KSPostedVCPUs) = vcpu;
+}
+
+/* Remove vcpu from the list of the core it was last loaded on */
+static void postedVCPUsRemove(vcpu_t *vcpu)
+{
+    if (vcpu->pi_prev) {
+        vcpu->pi_prev->pi_next = vcpu->pi_next;
+    } else {
+        ARCH_NODE_STATE_ON_CORE(x86KSPostedVCPUs, SMP_TERNARY(vcpu->last_cpu, 0)) = vcpu->pi_next;
+    }
+    if (vcpu->pi_next) {
+        vcpu->pi_next->pi_prev = vcpu->pi_prev;
+    }
+}
+#endif
+
 static void switchVCPU(vcpu_t *vcpu)
 {
 #ifdef ENABLE_SMP_SUPPORT
@@ -175,6 +247,14 @@ static void switchVCPU(vcpu_t *vcpu)
         vmwrite(VMX_HOST_IDTR_BASE, (word_t)x86KSGlobalState[CURRENT_CPU_INDEX()].x86KSidt);
         vmwrite(VMX_HOST_SYSENTER_ESP, (uint64_t)(word_t)((char *)&x86KSGlobalState[CURRENT_CPU_INDEX()].x86KStss.tss.words[0] +
                                                           4));
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+        if (vcpu->posted_interrupts) {
+            /* notifications must now be sent to this core */
+            postedVCPUsRemove(vcpu);
+            postedVCPUsAdd(vcpu);
+            vcpu->pi_desc.ndst = postedInterruptDestination();
+        }
+#endif
     }
     vcpu->last_cpu = getCurrentCPUIndex();
 #endif
@@ -300,8 +380,20 @@ static bool_t BOOT_CODE init_vtx_fixed_values(bool_t useTrueMsrs)
         vmx_feature_vpid = 0;
         printf("vt-x: VPIDs are not supported. Expect performance degredation\n");
     } else {
-        vmx_feature_vpid = 1;
-        secondary_control_mask |= BIT(5);
+        /* The VMX_EPT_VPID_CAP MSR exists as VPIDs are supported. A VPID is
+         * flushed with the single-context INVVPID whenever its translations
+         * may be stale */
+        vmx_ept_vpid_cap_msr_t vpid_cap;
+        vpid_cap.words[0] = x86_rdmsr_low(IA32_VMX_EPT_VPID_CAP_MSR);
+        vpid_cap.words[1] = x86_rdmsr_high(IA32_VMX_EPT_VPID_CAP_MSR);
+        if (!vmx_ept_vpid_cap_msr_get_invvpid(vpid_cap) ||
+            !vmx_ept_vpid_cap_msr_get_invvpid_single_context(vpid_cap)) {
+            vmx_feature_vpid = 0;
+            printf("vt-x: Single-context INVVPID is not supported. Expect performance degredation\n");
+        } else {
+            vmx_feature_vpid = 1;
+            secondary_control_mask |= BIT(5);
+        }
     }
 
     /* Check for load perf global control */
@@ -322,6 +414,20 @@ static bool_t BOOT_CODE init_vtx_fixed_values(bool_t useTrueMsrs)
         exit_control_mask |= BIT(15);
     }
 
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    /* Check for posted interrupts and the APIC virtualisation they rely on.
+     * Processing posted interrupts also requires interrupts to be acknowledged
+     * on exit */
+    if (!vmx_feature_ack_on_exit || !(pin_control_low & VMX_PIN_POSTED_INTERRUPTS) ||
+        !(primary_control_low & VMX_PRIMARY_TPR_SHADOW) ||
+        (~secondary_control_low & VMX_SECONDARY_VIRTUAL_APIC)) {
+        vmx_feature_posted_interrupts = 0;
+        printf("vt-x: Posted interrupts not supported\n");
+    } else {
+        vmx_feature_posted_interrupts = 1;
+    }
+#endif
+
     /* See if the hardware requires bits that require to be high to be low */
     uint32_t missing;
     missing = (~pin_control_low) & pin_control_mask;
@@ -428,11 +534,35 @@ static inline uint32_t applyFixedBits(uint32_t original, uint32_t high, uint32_t
     return original;
 }
 
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+static inline word_t applyPostedInterruptBits(vcpu_t *vcpu, word_t field, word_t value)
+{
+    if (!vcpu->posted_interrupts) {
+        return value;
+    }
+    switch (field) {
+    case VMX_CONTROL_PIN_EXECUTION_CONTROLS:
+        return value | VMX_PIN_POSTED_INTERRUPTS;
+    case VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS:
+        return value | VMX_PRIMARY_TPR_SHADOW;
+    case VMX_CONTROL_SECONDARY_PROCESSOR_CONTROLS:
+        return value | VMX_SECONDARY_VIRTUAL_APIC;
+    default:
+        return value;
+    }
+}
+#endif
+
 void vcpu_init(vcpu_t *vcpu)
 {
     vcpu->vcpuTCB = NULL;
     vcpu->launched = false;
 
+    if (config_set(CONFIG_XSAVE_XSAVES)) {
+        /* XRSTORS faults on a zeroed area, as it requires the compacted format bit */
+        vcpu->fpuState = x86KSnullFpuState;
+    }
+
     memcpy(vcpu->vmcs, &vmcs_revision, 4);
 
     switchVCPU(vcpu);
@@ -442,9 +572,16 @@ void vcpu_init(vcpu_t *vcpu)
     vcpu->cr0_mask = 0;
     vcpu->exception_bitmap = 0;
     vcpu->vpid = VPID_INVALID;
+    vcpu->ioport_id = VPID_INVALID;
 #ifdef ENABLE_SMP_SUPPORT
     vcpu->last_cpu = getCurrentCPUIndex();
 #endif /* ENABLE_SMP_SUPPORT */
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    vcpu->posted_interrupts = false;
+#endif
+#ifdef CONFIG_VTX_FAST_EXITS
+    vcpu->fast_exits = 0;
+#endif
 
     vmwrite(VMX_HOST_PAT, x86_rdmsr(IA32_PAT_MSR));
     vmwrite(VMX_HOST_EFER, x86_rdmsr(IA32_EFER_MSR));
@@ -515,6 +652,17 @@ void vcpu_finalise(vcpu_t *vcpu)
     if (vcpu->vcpuTCB) {
         dissociateVcpuTcb(vcpu->vcpuTCB, vcpu);
     }
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    if (vcpu->posted_interrupts) {
+        /* stop the IOMMU from writing into the descriptor */
+        vtd_unmap_posted_msis(pptr_to_paddr(&vcpu->pi_desc));
+        postedVCPUsRemove(vcpu);
+    }
+#endif
+    if (vcpu->ioport_id != VPID_INVALID) {
+        assert(x86KSIOPortVCPUTable[vcpu->ioport_id] == vcpu);
+        x86KSIOPortVCPUTable[vcpu->ioport_id] = NULL;
+    }
     if (ARCH_NODE_STATE_ON_CORE(x86KSCurrentVCPU, vcpu->last_cpu) == vcpu) {
 #ifdef ENABLE_SMP_SUPPORT
         if (vcpu->last_cpu != getCurrentCPUIndex()) {
@@ -669,16 +817,73 @@ static exception_t decodeVCPUReadMSR(cap_t cap, word_t length, word_t *buffer)
 }
 #endif  /* CONFIG_X86_64_VTX_64BIT_GUESTS */
 
+void clearVPIDIOPortMappings(vpid_t vpid, uint16_t first, uint16_t last)
+{
+    if (vpid == VPID_INVALID) {
+        return;
+    }
+    vcpu_t *vcpu = x86KSIOPortVCPUTable[vpid];
+    if (vcpu == NULL) {
+        return;
+    }
+    assert(vcpu->ioport_id == vpid);
+    setIOPortMask(vcpu->io, first, last, true);
+}
+
+static inline vpid_t nextIOPortID(vpid_t id)
+{
+    if (id == VPID_LAST) {
+        return VPID_FIRST;
+    } else {
+        return id + 1;
+    }
+}
+
+static vpid_t findFreeIOPortID(void)
+{
+    vpid_t id;
+    vcpu_t *vcpu;
+
+    id = x86KSNextIOPortID;
+    do {
+        if (x86KSIOPortVCPUTable[id] == NULL) {
+            return id;
+        }
+        id = nextIOPortID(id);
+    } while (id != x86KSNextIOPortID);
+
+    /* Forcibly take the next index. Clear the IO bitmap of its owner, as the
+     * references in IO port capabilities can no longer revoke its ports. */
+    id = x86KSNextIOPortID;
+    vcpu = x86KSIOPortVCPUTable[id];
+    memset(vcpu->io, ~0, sizeof(vcpu->io));
+    vcpu->ioport_id = VPID_INVALID;
+    x86KSIOPortVCPUTable[id] = NULL;
+
+    x86KSNextIOPortID = nextIOPortID(x86KSNextIOPortID);
+    return id;
+}
+
+static void storeIOPortID(vcpu_t *vcpu, vpid_t id)
+{
+    assert(x86KSIOPortVCPUTable[id] == NULL);
+    assert(vcpu->ioport_id == VPID_INVALID);
+    x86KSIOPortVCPUTable[id] = vcpu;
+    vcpu->ioport_id = id;
+}
+
 static exception_t invokeEnableIOPort(vcpu_t *vcpu, cte_t *slot, cap_t cap, uint16_t low, uint16_t high)
 {
     /* remove any existing io ports from this cap */
     clearVPIDIOPortMappings(cap_io_port_cap_get_capIOPortVPID(cap),
                             cap_io_port_cap_get_capIOPortFirstPort(cap),
                             cap_io_port_cap_get_capIOPortLastPort(cap));
-    /* update the assigned vpid. If the vcpu does not have a valid vpid then
-     * this is fine as whilst the cap will not point to the vcpu, the vcpu
-     * will have its port mask cleared when it gets assigned a vpid */
-    cap = cap_io_port_cap_set_capIOPortVPID(cap, vcpu->vpid);
+    /* point the cap at the vcpu through its IO port table index, assigning
+     * one if the vcpu does not have one yet */
+    if (vcpu->ioport_id == VPID_INVALID) {
+        storeIOPortID(vcpu, findFreeIOPortID());
+    }
+    cap = cap_io_port_cap_set_capIOPortVPID(cap, vcpu->ioport_id);
     slot->cap = cap;
     setIOPortMask(vcpu->io, low, high, false);
     return EXCEPTION_NONE;
@@ -752,53 +957,8 @@ static exception_t decodeDisableIOPort(cap_t cap, word_t length, word_t *buffer)
     return invokeDisableIOPort(vcpu, low, high);
 }
 
-static exception_t invokeWriteVMCS(vcpu_t *vcpu, bool_t call, word_t *buffer, word_t field, word_t value)
-{
-    tcb_t *thread;
-    thread = NODE_STATE(ksCurThread);
-
-    if (ARCH_NODE_STATE(x86KSCurrentVCPU) != vcpu) {
-        switchVCPU(vcpu);
-    }
-    switch (field) {
-    case VMX_CONTROL_EXCEPTION_BITMAP:
-        vcpu->exception_bitmap = vcpu->cached_exception_bitmap = value;
-        break;
-    case VMX_GUEST_CR0:
-        vcpu->cr0 = vcpu->cached_cr0 = value;
-        break;
-    case VMX_CONTROL_CR0_MASK:
-        vcpu->cr0_mask = vcpu->cached_cr0_mask = value;
-        break;
-    case VMX_CONTROL_CR0_READ_SHADOW:
-        vcpu->cr0_shadow = vcpu->cached_cr0_shadow = value;
-        break;
-    }
-    vmwrite(field, value);
-
-    if (call) {
-        setRegister(thread, badgeRegister, 0);
-        unsigned int length = setMR(thread, buffer, 0, value);
-        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
-                        seL4_MessageInfo_new(0, 0, 0, length)));
-    }
-    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
-    return EXCEPTION_NONE;
-}
-
-static exception_t decodeWriteVMCS(cap_t cap, word_t length, bool_t call, word_t *buffer)
+static bool_t isWritableVMCSField(word_t field)
 {
-    word_t field;
-    word_t value;
-
-    if (length < 2) {
-        userError("VCPU WriteVMCS: Not enough arguments.");
-        current_syscall_error.type = seL4_IllegalOperation;
-        return EXCEPTION_SYSCALL_ERROR;
-    }
-
-    field = getSyscallArg(0, buffer);
-    value = getSyscallArg(1, buffer);
     switch (field) {
     case VMX_GUEST_RIP:
     case VMX_GUEST_RSP:
@@ -864,74 +1024,49 @@ static exception_t decodeWriteVMCS(cap_t cap, word_t length, bool_t call, word_t
     case VMX_CONTROL_EXCEPTION_BITMAP:
     case VMX_CONTROL_ENTRY_INTERRUPTION_INFO:
     case VMX_CONTROL_ENTRY_EXCEPTION_ERROR_CODE:
-        break;
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    case VMX_CONTROL_TPR_THRESHOLD:
+    case VMX_CONTROL_EOI_EXIT_BITMAP0:
+    case VMX_CONTROL_EOI_EXIT_BITMAP1:
+    case VMX_CONTROL_EOI_EXIT_BITMAP2:
+    case VMX_CONTROL_EOI_EXIT_BITMAP3:
+    case VMX_GUEST_INTERRUPT_STATUS:
+#endif
     case VMX_CONTROL_PIN_EXECUTION_CONTROLS:
-        value = applyFixedBits(value, pin_control_high, pin_control_low);
-        break;
     case VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS:
-        value = applyFixedBits(value, primary_control_high, primary_control_low);
-        break;
     case VMX_CONTROL_SECONDARY_PROCESSOR_CONTROLS:
-        value = applyFixedBits(value, secondary_control_high, secondary_control_low);
-        break;
     case VMX_CONTROL_EXIT_CONTROLS:
-        value = applyFixedBits(value, exit_control_high, exit_control_low);
-        break;
     case VMX_GUEST_CR0:
-        value = applyFixedBits(value, cr0_high, cr0_low);
-        break;
     case VMX_GUEST_CR4:
-        value = applyFixedBits(value, cr4_high, cr4_low);
-        break;
+        return true;
     default:
-        userError("VCPU WriteVMCS: Invalid field %lx.", (long)field);
-        current_syscall_error.type = seL4_IllegalOperation;
-        return EXCEPTION_SYSCALL_ERROR;
+        return false;
     }
-    return invokeWriteVMCS(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), call, buffer, field, value);
 }
 
-static word_t readVMCSField(vcpu_t *vcpu, word_t field)
+/* Force the bits of a writable field that are fixed by the hardware */
+static word_t applyVMCSFixedBits(word_t field, word_t value)
 {
     switch (field) {
-    case VMX_CONTROL_EXCEPTION_BITMAP:
-        return vcpu->exception_bitmap;
+    case VMX_CONTROL_PIN_EXECUTION_CONTROLS:
+        return applyFixedBits(value, pin_control_high, pin_control_low);
+    case VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS:
+        return applyFixedBits(value, primary_control_high, primary_control_low);
+    case VMX_CONTROL_SECONDARY_PROCESSOR_CONTROLS:
+        return applyFixedBits(value, secondary_control_high, secondary_control_low);
+    case VMX_CONTROL_EXIT_CONTROLS:
+        return applyFixedBits(value, exit_control_high, exit_control_low);
     case VMX_GUEST_CR0:
-        return vcpu->cr0;
-    case VMX_CONTROL_CR0_MASK:
-        return vcpu->cr0_mask;
-    case VMX_CONTROL_CR0_READ_SHADOW:
-        return vcpu->cr0_shadow;
-    }
-    if (ARCH_NODE_STATE(x86KSCurrentVCPU) != vcpu) {
-        switchVCPU(vcpu);
-    }
-    return vmread(field);
-}
-
-static exception_t invokeReadVMCS(vcpu_t *vcpu, word_t field, bool_t call, word_t *buffer)
-{
-    tcb_t *thread;
-    thread = NODE_STATE(ksCurThread);
-    word_t value = readVMCSField(vcpu, field);
-    if (call) {
-        setRegister(thread, badgeRegister, 0);
-        unsigned int length = setMR(thread, buffer, 0, value);
-        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
-                        seL4_MessageInfo_new(0, 0, 0, length)));
+        return applyFixedBits(value, cr0_high, cr0_low);
+    case VMX_GUEST_CR4:
+        return applyFixedBits(value, cr4_high, cr4_low);
+    default:
+        return value;
     }
-    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
-    return EXCEPTION_NONE;
 }
 
-static exception_t decodeReadVMCS(cap_t cap, word_t length, bool_t call, word_t *buffer)
+static bool_t isReadableVMCSField(word_t field)
 {
-    if (length < 1) {
-        userError("VCPU ReadVMCS: Not enough arguments.");
-        current_syscall_error.type = seL4_IllegalOperation;
-        return EXCEPTION_SYSCALL_ERROR;
-    }
-    word_t field = getSyscallArg(0, buffer);
     switch (field) {
     case VMX_GUEST_RIP:
     case VMX_GUEST_RSP:
@@ -1014,56 +1149,703 @@ static exception_t decodeReadVMCS(cap_t cap, word_t length, bool_t call, word_t
     case VMX_GUEST_CR0:
     case VMX_GUEST_CR3:
     case VMX_GUEST_CR4:
-        break;
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    case VMX_CONTROL_TPR_THRESHOLD:
+    case VMX_CONTROL_EOI_EXIT_BITMAP0:
+    case VMX_CONTROL_EOI_EXIT_BITMAP1:
+    case VMX_CONTROL_EOI_EXIT_BITMAP2:
+    case VMX_CONTROL_EOI_EXIT_BITMAP3:
+    case VMX_GUEST_INTERRUPT_STATUS:
+#endif
+        return true;
     default:
-        userError("VCPU ReadVMCS: Invalid field %lx.", (long)field);
-        current_syscall_error.type = seL4_IllegalOperation;
-        return EXCEPTION_SYSCALL_ERROR;
+        return false;
     }
-    return invokeReadVMCS(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), field, call, buffer);
 }
 
-static exception_t invokeSetTCB(vcpu_t *vcpu, tcb_t *tcb)
+/* Write a validated field and return the value that reached the hardware */
+static word_t writeVMCSField(vcpu_t *vcpu, word_t field, word_t value)
 {
-    associateVcpuTcb(tcb, vcpu);
+    if (ARCH_NODE_STATE(x86KSCurrentVCPU) != vcpu) {
+        switchVCPU(vcpu);
+    }
+    switch (field) {
+    case VMX_CONTROL_EXCEPTION_BITMAP:
+        vcpu->exception_bitmap = vcpu->cached_exception_bitmap = value;
+        break;
+    case VMX_GUEST_CR0:
+        vcpu->cr0 = vcpu->cached_cr0 = value;
+        break;
+    case VMX_CONTROL_CR0_MASK:
+        vcpu->cr0_mask = vcpu->cached_cr0_mask = value;
+        break;
+    case VMX_CONTROL_CR0_READ_SHADOW:
+        vcpu->cr0_shadow = vcpu->cached_cr0_shadow = value;
+        break;
+    }
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    value = applyPostedInterruptBits(vcpu, field, value);
+#endif
+    vmwrite(field, value);
+    return value;
+}
 
-    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+static exception_t invokeWriteVMCS(vcpu_t *vcpu, bool_t call, word_t *buffer, word_t field, word_t value)
+{
+    tcb_t *thread;
+    thread = NODE_STATE(ksCurThread);
+
+    value = writeVMCSField(vcpu, field, value);
+
+    if (call) {
+        setRegister(thread, badgeRegister, 0);
+        unsigned int length = setMR(thread, buffer, 0, value);
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
     return EXCEPTION_NONE;
 }
 
-static exception_t decodeSetTCB(cap_t cap, word_t length, word_t *buffer)
+static exception_t decodeWriteVMCS(cap_t cap, word_t length, bool_t call, word_t *buffer)
 {
-    cap_t tcbCap;
-    if (current_extra_caps.excaprefs[0] == NULL) {
-        userError("VCPU SetTCB: Truncated message.");
-        current_syscall_error.type = seL4_TruncatedMessage;
+    word_t field;
+    word_t value;
+
+    if (length < 2) {
+        userError("VCPU WriteVMCS: Not enough arguments.");
+        current_syscall_error.type = seL4_IllegalOperation;
         return EXCEPTION_SYSCALL_ERROR;
     }
-    tcbCap  = current_extra_caps.excaprefs[0]->cap;
 
-    if (cap_get_capType(tcbCap) != cap_thread_cap) {
-        userError("TCB cap is not a TCB cap.");
+    field = getSyscallArg(0, buffer);
+    value = getSyscallArg(1, buffer);
+    if (!isWritableVMCSField(field)) {
+        userError("VCPU WriteVMCS: Invalid field %lx.", (long)field);
         current_syscall_error.type = seL4_IllegalOperation;
         return EXCEPTION_SYSCALL_ERROR;
     }
-
-    return invokeSetTCB(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), TCB_PTR(cap_thread_cap_get_capTCBPtr(tcbCap)));
+    value = applyVMCSFixedBits(field, value);
+    return invokeWriteVMCS(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), call, buffer, field, value);
 }
 
-void vcpu_update_state_sysvmenter(vcpu_t *vcpu)
+static word_t readVMCSField(vcpu_t *vcpu, word_t field)
 {
-    word_t *buffer;
-    if (ARCH_NODE_STATE(x86KSCurrentVCPU) != vcpu) {
-        switchVCPU(vcpu);
-    }
-    buffer = lookupIPCBuffer(false, NODE_STATE(ksCurThread));
-    if (!buffer) {
-        userError("No IPC buffer.");
-        return;
+    switch (field) {
+    case VMX_CONTROL_EXCEPTION_BITMAP:
+        return vcpu->exception_bitmap;
+    case VMX_GUEST_CR0:
+        return vcpu->cr0;
+    case VMX_CONTROL_CR0_MASK:
+        return vcpu->cr0_mask;
+    case VMX_CONTROL_CR0_READ_SHADOW:
+        return vcpu->cr0_shadow;
+    }
+    if (ARCH_NODE_STATE(x86KSCurrentVCPU) != vcpu) {
+        switchVCPU(vcpu);
+    }
+    return vmread(field);
+}
+
+static exception_t invokeReadVMCS(vcpu_t *vcpu, word_t field, bool_t call, word_t *buffer)
+{
+    tcb_t *thread;
+    thread = NODE_STATE(ksCurThread);
+    word_t value = readVMCSField(vcpu, field);
+    if (call) {
+        setRegister(thread, badgeRegister, 0);
+        unsigned int length = setMR(thread, buffer, 0, value);
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeReadVMCS(cap_t cap, word_t length, bool_t call, word_t *buffer)
+{
+    if (length < 1) {
+        userError("VCPU ReadVMCS: Not enough arguments.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    word_t field = getSyscallArg(0, buffer);
+    if (!isReadableVMCSField(field)) {
+        userError("VCPU ReadVMCS: Invalid field %lx.", (long)field);
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    return invokeReadVMCS(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), field, call, buffer);
+}
+
+/* The batched invocations take a count in the first message register,
+ * followed by seL4_VCPUBatchMax field encodings and, for writes, the values.
+ * The fields are copied out of the message before any of them is used. */
+#define VMCS_BATCH_FIELDS 1
+#define VMCS_BATCH_VALUES (VMCS_BATCH_FIELDS + seL4_VCPUBatchMax)
+
+static exception_t decodeVMCSBatchFields(word_t length, word_t *buffer, bool_t write,
+                                         word_t *count, word_t fields[seL4_VCPUBatchMax])
+{
+    if (length < 1) {
+        userError("VCPU VMCS batch: Not enough arguments.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    *count = getSyscallArg(0, buffer);
+    if (*count > seL4_VCPUBatchMax) {
+        userError("VCPU VMCS batch: Count %lu is too large.", (unsigned long)*count);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 0;
+        current_syscall_error.rangeErrorMax = seL4_VCPUBatchMax;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    if (length < (write ? VMCS_BATCH_VALUES : VMCS_BATCH_FIELDS) + *count) {
+        userError("VCPU VMCS batch: Not enough arguments.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    for (word_t i = 0; i < *count; i++) {
+        fields[i] = getSyscallArg(VMCS_BATCH_FIELDS + i, buffer);
+        if (write ? !isWritableVMCSField(fields[i]) : !isReadableVMCSField(fields[i])) {
+            userError("VCPU VMCS batch: Invalid field %lx.", (long)fields[i]);
+            current_syscall_error.type = seL4_IllegalOperation;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+    }
+    return EXCEPTION_NONE;
+}
+
+static exception_t invokeWriteVMCSBatch(vcpu_t *vcpu, word_t count, word_t *fields, bool_t call, word_t *buffer)
+{
+    tcb_t *thread;
+    thread = NODE_STATE(ksCurThread);
+    unsigned int length = 0;
+
+    for (word_t i = 0; i < count; i++) {
+        word_t value = applyVMCSFixedBits(fields[i], getSyscallArg(VMCS_BATCH_VALUES + i, buffer));
+        value = writeVMCSField(vcpu, fields[i], value);
+        /* Results only overwrite message registers that have already been consumed */
+        if (call) {
+            length = setMR(thread, buffer, i, value);
+        }
+    }
+    if (call) {
+        setRegister(thread, badgeRegister, 0);
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeWriteVMCSBatch(cap_t cap, word_t length, bool_t call, word_t *buffer)
+{
+    word_t fields[seL4_VCPUBatchMax];
+    word_t count;
+    exception_t status;
+
+    status = decodeVMCSBatchFields(length, buffer, true, &count, fields);
+    if (status != EXCEPTION_NONE) {
+        return status;
+    }
+    return invokeWriteVMCSBatch(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), count, fields, call, buffer);
+}
+
+static exception_t invokeReadVMCSBatch(vcpu_t *vcpu, word_t count, word_t *fields, bool_t call, word_t *buffer)
+{
+    tcb_t *thread;
+    thread = NODE_STATE(ksCurThread);
+    if (call) {
+        unsigned int length = 0;
+        setRegister(thread, badgeRegister, 0);
+        for (word_t i = 0; i < count; i++) {
+            length = setMR(thread, buffer, i, readVMCSField(vcpu, fields[i]));
+        }
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeReadVMCSBatch(cap_t cap, word_t length, bool_t call, word_t *buffer)
+{
+    word_t fields[seL4_VCPUBatchMax];
+    word_t count;
+    exception_t status;
+
+    status = decodeVMCSBatchFields(length, buffer, false, &count, fields);
+    if (status != EXCEPTION_NONE) {
+        return status;
+    }
+    return invokeReadVMCSBatch(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), count, fields, call, buffer);
+}
+
+static exception_t invokeSetTCB(vcpu_t *vcpu, tcb_t *tcb)
+{
+    associateVcpuTcb(tcb, vcpu);
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeSetTCB(cap_t cap, word_t length, word_t *buffer)
+{
+    cap_t tcbCap;
+    if (current_extra_caps.excaprefs[0] == NULL) {
+        userError("VCPU SetTCB: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    tcbCap  = current_extra_caps.excaprefs[0]->cap;
+
+    if (cap_get_capType(tcbCap) != cap_thread_cap) {
+        userError("TCB cap is not a TCB cap.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return invokeSetTCB(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), TCB_PTR(cap_thread_cap_get_capTCBPtr(tcbCap)));
+}
+
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+static exception_t invokeEnablePostedInterrupts(vcpu_t *vcpu, paddr_t apic_access)
+{
+    if (ARCH_NODE_STATE(x86KSCurrentVCPU) != vcpu) {
+        switchVCPU(vcpu);
+    }
+    memzero(&vcpu->pi_desc, sizeof(vcpu->pi_desc));
+    vcpu->pi_desc.control = int_posted_interrupt << PI_DESC_NV;
+    vcpu->pi_desc.ndst = postedInterruptDestination();
+    if (!vcpu->posted_interrupts) {
+        postedVCPUsAdd(vcpu);
+    }
+    vcpu->posted_interrupts = true;
+
+    vmwrite(VMX_CONTROL_VIRTUAL_APIC_ADDRESS, pptr_to_paddr(vcpu->vapic));
+    /* The processor only ever compares guest accesses against the APIC-access
+     * address and never accesses the frame itself, so the frame does not need
+     * to outlive this call */
+    vmwrite(VMX_CONTROL_APIC_ACCESS_ADDRESS, apic_access);
+    vmwrite(VMX_CONTROL_POSTED_INTERRUPT_VECTOR, int_posted_interrupt);
+    vmwrite(VMX_CONTROL_POSTED_INTERRUPT_DESC_ADDRESS, pptr_to_paddr(&vcpu->pi_desc));
+    vmwrite(VMX_CONTROL_PIN_EXECUTION_CONTROLS,
+            applyPostedInterruptBits(vcpu, VMX_CONTROL_PIN_EXECUTION_CONTROLS,
+                                     vmread(VMX_CONTROL_PIN_EXECUTION_CONTROLS)));
+    vmwrite(VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS,
+            applyPostedInterruptBits(vcpu, VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS,
+                                     vmread(VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS)));
+    vmwrite(VMX_CONTROL_SECONDARY_PROCESSOR_CONTROLS,
+            applyPostedInterruptBits(vcpu, VMX_CONTROL_SECONDARY_PROCESSOR_CONTROLS,
+                                     vmread(VMX_CONTROL_SECONDARY_PROCESSOR_CONTROLS)));
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeEnablePostedInterrupts(cap_t cap)
+{
+    cap_t frameCap;
+
+    if (!vmx_feature_posted_interrupts) {
+        userError("VCPU EnablePostedInterrupts: Posted interrupts are not supported.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    if (current_extra_caps.excaprefs[0] == NULL) {
+        userError("VCPU EnablePostedInterrupts: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    frameCap = current_extra_caps.excaprefs[0]->cap;
+
+    if (cap_get_capType(frameCap) != cap_frame_cap || cap_frame_cap_get_capFSize(frameCap) != X86_SmallPage) {
+        userError("VCPU EnablePostedInterrupts: APIC access page is not a 4K frame cap.");
+        current_syscall_error.type = seL4_InvalidCapability;
+        current_syscall_error.invalidCapNumber = 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return invokeEnablePostedInterrupts(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)),
+                                        pptr_to_paddr((void *)cap_frame_cap_get_capFBasePtr(frameCap)));
+}
+
+static exception_t invokeBindPostedIRQ(vcpu_t *vcpu, x86_irq_state_t irqState, word_t vector)
+{
+    uint32_t source_id = (x86_irq_state_irq_msi_get_bus(irqState) << 8) |
+                         (x86_irq_state_irq_msi_get_dev(irqState) << 3) |
+                         x86_irq_state_irq_msi_get_func(irqState);
+
+    vtd_map_posted_msi(x86_irq_state_irq_msi_get_handle(irqState), source_id, vector,
+                       pptr_to_paddr(&vcpu->pi_desc));
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeBindPostedIRQ(cap_t cap, word_t length, word_t *buffer)
+{
+    vcpu_t *vcpu = VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap));
+    cap_t irqCap;
+    x86_irq_state_t irqState;
+    word_t vector;
+
+    if (length < 1 || current_extra_caps.excaprefs[0] == NULL) {
+        userError("VCPU BindPostedIRQ: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    if (!vcpu->posted_interrupts) {
+        userError("VCPU BindPostedIRQ: Posted interrupts are not enabled.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    irqCap = current_extra_caps.excaprefs[0]->cap;
+    if (cap_get_capType(irqCap) != cap_irq_handler_cap) {
+        userError("VCPU BindPostedIRQ: IRQ handler cap is not an IRQ handler cap.");
+        current_syscall_error.type = seL4_InvalidCapability;
+        current_syscall_error.invalidCapNumber = 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    irqState = x86KSIRQState[IDX_TO_IRQT(cap_irq_handler_cap_get_capIRQ(irqCap))];
+    if (x86_irq_state_get_irqType(irqState) != x86_irq_state_irq_msi) {
+        userError("VCPU BindPostedIRQ: Only MSIs can be posted.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    /* vectors below 16 are reserved for exceptions */
+    vector = getSyscallArg(0, buffer);
+    if (vector < 16 || vector > 255) {
+        userError("VCPU BindPostedIRQ: Invalid guest vector %d.", (int)vector);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 16;
+        current_syscall_error.rangeErrorMax = 255;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return invokeBindPostedIRQ(vcpu, irqState, vector);
+}
+
+static exception_t invokeReadVAPIC(vcpu_t *vcpu, word_t offset, bool_t call, word_t *buffer)
+{
+    tcb_t *thread = NODE_STATE(ksCurThread);
+    if (call) {
+        setRegister(thread, badgeRegister, 0);
+        unsigned int length = setMR(thread, buffer, 0, vcpu->vapic[offset / sizeof(uint32_t)]);
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(thread, ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+static exception_t invokeWriteVAPIC(vcpu_t *vcpu, word_t offset, uint32_t value)
+{
+    vcpu->vapic[offset / sizeof(uint32_t)] = value;
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeAccessVAPIC(word_t invLabel, cap_t cap, word_t length, bool_t call, word_t *buffer)
+{
+    vcpu_t *vcpu = VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap));
+    word_t offset;
+
+    if (length < (invLabel == X86VCPUWriteVAPIC ? 2 : 1)) {
+        userError("VCPU Read/WriteVAPIC: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    if (!vcpu->posted_interrupts) {
+        userError("VCPU Read/WriteVAPIC: Posted interrupts are not enabled.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    offset = getSyscallArg(0, buffer);
+    if (offset >= VCPU_VAPIC_SIZE || offset % sizeof(uint32_t) != 0) {
+        userError("VCPU Read/WriteVAPIC: Invalid offset %lx.", (long)offset);
+        current_syscall_error.type = seL4_InvalidArgument;
+        current_syscall_error.invalidArgumentNumber = 0;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (invLabel == X86VCPUWriteVAPIC) {
+        return invokeWriteVAPIC(vcpu, offset, getSyscallArg(1, buffer));
+    }
+    return invokeReadVAPIC(vcpu, offset, call, buffer);
+}
+
+/* Called on entry to a VCPU using posted interrupts. Notifications that arrived
+ * whilst the guest was not running were taken by the kernel, leaving interrupts
+ * outstanding in the descriptor. A self notification has them processed by the
+ * processor straight after the VM entry */
+static void resendPostedInterruptNotification(vcpu_t *vcpu)
+{
+    if (__atomic_load_n(&vcpu->pi_desc.control, __ATOMIC_RELAXED) & PI_DESC_ON) {
+        apic_send_ipi_core(int_posted_interrupt, currentAPICID());
+    }
+}
+
+/* Called when a notification arrives whilst no guest is running on this core.
+ * The interrupts stay outstanding in the descriptor until the VCPU is next
+ * entered, so a VCPU thread that is not about to enter its guest is woken
+ * through its bound notification. The processor only sends another
+ * notification once the outstanding ones have been processed. */
+void handlePostedInterruptNotification(void)
+{
+    for (vcpu_t *vcpu = ARCH_NODE_STATE(x86KSPostedVCPUs); vcpu; vcpu = vcpu->pi_next) {
+        tcb_t *tcb = vcpu->vcpuTCB;
+        if ((__atomic_load_n(&vcpu->pi_desc.control, __ATOMIC_RELAXED) & PI_DESC_ON) &&
+            tcb && tcb->tcbBoundNotification &&
+            thread_state_get_tsType(tcb->tcbState) != ThreadState_RunningVM) {
+            sendSignal(tcb->tcbBoundNotification, 0);
+        }
+    }
+}
+#endif /* CONFIG_VTX_POSTED_INTERRUPTS */
+
+#ifdef CONFIG_VTX_FAST_EXITS
+static exception_t invokeSetFastExits(vcpu_t *vcpu, word_t exits)
+{
+    vcpu->fast_exits = exits;
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeSetFastExits(cap_t cap, word_t length, word_t *buffer)
+{
+    word_t exits;
+
+    if (length < 1) {
+        userError("VCPU SetFastExits: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    exits = getSyscallArg(0, buffer);
+    if (exits & ~MASK(seL4_X86_FastExit_Num)) {
+        userError("VCPU SetFastExits: Invalid exits %lx.", (long)exits);
+        current_syscall_error.type = seL4_InvalidArgument;
+        current_syscall_error.invalidArgumentNumber = 0;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return invokeSetFastExits(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), exits);
+}
+
+static exception_t invokeSetCPUIDEntry(vcpu_t *vcpu, word_t index, vcpu_cpuid_entry_t entry)
+{
+    vcpu->cpuid_entries[index] = entry;
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeSetCPUIDEntry(cap_t cap, word_t length, word_t *buffer)
+{
+    vcpu_cpuid_entry_t entry;
+    word_t index;
+    word_t flags;
+
+    if (length < 8) {
+        userError("VCPU SetCPUIDEntry: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    index = getSyscallArg(0, buffer);
+    flags = getSyscallArg(1, buffer);
+    if (index >= CONFIG_VTX_FAST_EXIT_CPUID_ENTRIES) {
+        userError("VCPU SetCPUIDEntry: Invalid index %lu.", (unsigned long)index);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 0;
+        current_syscall_error.rangeErrorMax = CONFIG_VTX_FAST_EXIT_CPUID_ENTRIES - 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    if (flags & ~(word_t)(seL4_X86_CPUIDEntry_Valid | seL4_X86_CPUIDEntry_AnySubleaf)) {
+        userError("VCPU SetCPUIDEntry: Invalid flags %lx.", (long)flags);
+        current_syscall_error.type = seL4_InvalidArgument;
+        current_syscall_error.invalidArgumentNumber = 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    entry.flags = flags;
+    entry.leaf = getSyscallArg(2, buffer);
+    entry.subleaf = getSyscallArg(3, buffer);
+    entry.eax = getSyscallArg(4, buffer);
+    entry.ebx = getSyscallArg(5, buffer);
+    entry.ecx = getSyscallArg(6, buffer);
+    entry.edx = getSyscallArg(7, buffer);
+    return invokeSetCPUIDEntry(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), index, entry);
+}
+
+static exception_t invokeSetMSREntry(vcpu_t *vcpu, word_t index, vcpu_msr_entry_t entry)
+{
+    vcpu->msr_entries[index] = entry;
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeSetMSREntry(cap_t cap, word_t length, word_t *buffer)
+{
+    vcpu_msr_entry_t entry;
+    word_t index;
+    word_t flags;
+
+    if (length < 3 + MSR_VALUE_ARG_SIZE) {
+        userError("VCPU SetMSREntry: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    index = getSyscallArg(0, buffer);
+    flags = getSyscallArg(1, buffer);
+    if (index >= CONFIG_VTX_FAST_EXIT_MSR_ENTRIES) {
+        userError("VCPU SetMSREntry: Invalid index %lu.", (unsigned long)index);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 0;
+        current_syscall_error.rangeErrorMax = CONFIG_VTX_FAST_EXIT_MSR_ENTRIES - 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    if (flags & ~(word_t)(seL4_X86_MSREntry_Read | seL4_X86_MSREntry_Write)) {
+        userError("VCPU SetMSREntry: Invalid flags %lx.", (long)flags);
+        current_syscall_error.type = seL4_InvalidArgument;
+        current_syscall_error.invalidArgumentNumber = 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    entry.flags = flags;
+    entry.msr = getSyscallArg(2, buffer);
+    entry.value = mode_parseTimeArg(3, buffer);
+    return invokeSetMSREntry(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), index, entry);
+}
+
+static exception_t invokeReadMSREntry(vcpu_t *vcpu, word_t index, bool_t call, word_t *buffer)
+{
+    tcb_t *thread = NODE_STATE(ksCurThread);
+    if (call) {
+        setRegister(thread, badgeRegister, 0);
+        unsigned int length = mode_setTimeArg(0, vcpu->msr_entries[index].value, buffer, thread);
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(thread, ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeReadMSREntry(cap_t cap, word_t length, bool_t call, word_t *buffer)
+{
+    word_t index;
+
+    if (length < 1) {
+        userError("VCPU ReadMSREntry: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    index = getSyscallArg(0, buffer);
+    if (index >= CONFIG_VTX_FAST_EXIT_MSR_ENTRIES) {
+        userError("VCPU ReadMSREntry: Invalid index %lu.", (unsigned long)index);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 0;
+        current_syscall_error.rangeErrorMax = CONFIG_VTX_FAST_EXIT_MSR_ENTRIES - 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return invokeReadMSREntry(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), index, call, buffer);
+}
+
+static exception_t invokeGetFastExitCount(vcpu_t *vcpu, word_t exit, bool_t call, word_t *buffer)
+{
+    tcb_t *thread = NODE_STATE(ksCurThread);
+    if (call) {
+        setRegister(thread, badgeRegister, 0);
+        unsigned int length = setMR(thread, buffer, 0, vcpu->fast_exit_count[exit]);
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(thread, ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeGetFastExitCount(cap_t cap, word_t length, bool_t call, word_t *buffer)
+{
+    word_t exit;
+
+    if (length < 1) {
+        userError("VCPU GetFastExitCount: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    exit = getSyscallArg(0, buffer);
+    if (exit >= seL4_X86_FastExit_Num) {
+        userError("VCPU GetFastExitCount: Invalid exit %lu.", (unsigned long)exit);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 0;
+        current_syscall_error.rangeErrorMax = seL4_X86_FastExit_Num - 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return invokeGetFastExitCount(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), exit, call, buffer);
+}
+#endif /* CONFIG_VTX_FAST_EXITS */
+
+#ifdef CONFIG_VCPU_EXIT_STATS
+static exception_t invokeGetExitStats(vcpu_t *vcpu, word_t reason, bool_t call, word_t *buffer)
+{
+    tcb_t *thread = NODE_STATE(ksCurThread);
+    if (call) {
+        vcpu_exit_stats_t *stats = &vcpu->exit_stats;
+        unsigned int length = 0;
+        setRegister(thread, badgeRegister, 0);
+        mode_setTimeArg(0, stats->count[reason], buffer, thread);
+        mode_setTimeArg(VCPU_EXIT_STATS_TICKS, stats->ticks[reason], buffer, thread);
+        for (word_t i = 0; i < seL4_VCPUExitHistogramBuckets; i++) {
+            length = setMR(thread, buffer, VCPU_EXIT_STATS_HISTOGRAM + i, stats->histogram[reason][i]);
+        }
+        setRegister(thread, msgInfoRegister, wordFromMessageInfo(
+                        seL4_MessageInfo_new(0, 0, 0, length)));
+    }
+    setThreadState(thread, ThreadState_Running);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeGetExitStats(cap_t cap, word_t length, bool_t call, word_t *buffer)
+{
+    word_t reason;
+
+    if (length < 1) {
+        userError("VCPU GetExitStats: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    reason = getSyscallArg(0, buffer);
+    if (reason >= seL4_VCPUExitReasons) {
+        userError("VCPU GetExitStats: Invalid exit reason %lu.", (unsigned long)reason);
+        current_syscall_error.type = seL4_RangeError;
+        current_syscall_error.rangeErrorMin = 0;
+        current_syscall_error.rangeErrorMax = seL4_VCPUExitReasons - 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return invokeGetExitStats(VCPU_PTR(cap_vcpu_cap_get_capVCPUPtr(cap)), reason, call, buffer);
+}
+#endif /* CONFIG_VCPU_EXIT_STATS */
+
+void vcpu_update_state_sysvmenter(vcpu_t *vcpu)
+{
+    word_t *buffer;
+    if (ARCH_NODE_STATE(x86KSCurrentVCPU) != vcpu) {
+        switchVCPU(vcpu);
+    }
+    buffer = lookupIPCBuffer(false, NODE_STATE(ksCurThread));
+    if (!buffer) {
+        userError("No IPC buffer.");
+        return;
     }
     vmwrite(VMX_GUEST_RIP, getSyscallArg(0, buffer));
-    vmwrite(VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS, applyFixedBits(getSyscallArg(1, buffer), primary_control_high,
-                                                                   primary_control_low));
+    word_t primary_controls = applyFixedBits(getSyscallArg(1, buffer), primary_control_high, primary_control_low);
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    primary_controls = applyPostedInterruptBits(vcpu, VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS, primary_controls);
+#endif
+    vmwrite(VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS, primary_controls);
     vmwrite(VMX_CONTROL_ENTRY_INTERRUPTION_INFO, getSyscallArg(2, buffer));
 }
 
@@ -1105,6 +1887,10 @@ exception_t decodeX86VCPUInvocation(
         return decodeReadVMCS(cap, length, call, buffer);
     case X86VCPUWriteVMCS:
         return decodeWriteVMCS(cap, length, call, buffer);
+    case X86VCPUReadVMCSBatch:
+        return decodeReadVMCSBatch(cap, length, call, buffer);
+    case X86VCPUWriteVMCSBatch:
+        return decodeWriteVMCSBatch(cap, length, call, buffer);
     case X86VCPUEnableIOPort:
         return decodeEnableIOPort(cap, length, buffer);
     case X86VCPUDisableIOPort:
@@ -1117,6 +1903,31 @@ exception_t decodeX86VCPUInvocation(
     case X86VCPUReadMSR:
         return decodeVCPUReadMSR(cap, length, buffer);
 #endif /* CONFIG_X86_64_VTX_64BIT_GUESTS */
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    case X86VCPUEnablePostedInterrupts:
+        return decodeEnablePostedInterrupts(cap);
+    case X86VCPUBindPostedIRQ:
+        return decodeBindPostedIRQ(cap, length, buffer);
+    case X86VCPUReadVAPIC:
+    case X86VCPUWriteVAPIC:
+        return decodeAccessVAPIC(invLabel, cap, length, call, buffer);
+#endif /* CONFIG_VTX_POSTED_INTERRUPTS */
+#ifdef CONFIG_VTX_FAST_EXITS
+    case X86VCPUSetFastExits:
+        return decodeSetFastExits(cap, length, buffer);
+    case X86VCPUSetCPUIDEntry:
+        return decodeSetCPUIDEntry(cap, length, buffer);
+    case X86VCPUSetMSREntry:
+        return decodeSetMSREntry(cap, length, buffer);
+    case X86VCPUReadMSREntry:
+        return decodeReadMSREntry(cap, length, call, buffer);
+    case X86VCPUGetFastExitCount:
+        return decodeGetFastExitCount(cap, length, call, buffer);
+#endif /* CONFIG_VTX_FAST_EXITS */
+#ifdef CONFIG_VCPU_EXIT_STATS
+    case X86VCPUGetExitStats:
+        return decodeGetExitStats(cap, length, call, buffer);
+#endif
     default:
         userError("VCPU: Illegal operation.");
         current_syscall_error.type = seL4_IllegalOperation;
@@ -1177,6 +1988,7 @@ BOOT_CODE bool_t vtx_init(void)
         return false;
     }
     write_cr4(read_cr4() | CR4_VMXE);
+    ARCH_NODE_STATE(x86KSNextVPID) = VPID_FIRST;
     /* we are required to set the VMCS region in the VMXON region */
     vmxon_region.revision = vmcs_revision;
     /* Before calling vmxon, we must check that CR0 and CR4 are not set to values
@@ -1220,6 +2032,9 @@ BOOT_CODE bool_t vtx_init(void)
         printf("vt-x: Expected supported for 2m pages\n");
         return false;
     }
+    vmx_feature_ept_1g = vmx_ept_vpid_cap_msr_get_ept_1g(vpid_capability);
+    vmx_feature_ept_ad = config_set(CONFIG_VTX_EPT_DIRTY_FLAGS) &&
+                         vmx_ept_vpid_cap_msr_get_ept_flags(vpid_capability);
 
     return true;
 }
@@ -1265,6 +2080,158 @@ static void handleVmxFault(uint32_t reason, word_t qualification)
     activateThread();
 }
 
+#ifdef CONFIG_VTX_FAST_EXITS
+/* Move the guest past an instruction that the kernel has emulated */
+static void skipGuestInstruction(void)
+{
+    vmwrite(VMX_GUEST_RIP, vmread(VMX_GUEST_RIP) + vmread(VMX_DATA_EXIT_INSTRUCTION_LENGTH));
+    /* Blocking by STI or MOV SS only covers the instruction that was emulated */
+    vmwrite(VMX_GUEST_INTERRUPTABILITY,
+            vmread(VMX_GUEST_INTERRUPTABILITY) & ~VMX_GUEST_INTERRUPTABILITY_STI_MOV_SS);
+}
+
+static void setGuestEDXEAX(vcpu_t *vcpu, uint64_t value)
+{
+    vcpu->gp_registers[VCPU_EAX] = (uint32_t)value;
+    vcpu->gp_registers[VCPU_EDX] = (uint32_t)(value >> 32);
+}
+
+static bool_t handleFastCPUID(vcpu_t *vcpu)
+{
+    uint32_t leaf = vcpu->gp_registers[VCPU_EAX];
+    uint32_t subleaf = vcpu->gp_registers[VCPU_ECX];
+
+    for (word_t i = 0; i < CONFIG_VTX_FAST_EXIT_CPUID_ENTRIES; i++) {
+        vcpu_cpuid_entry_t *entry = &vcpu->cpuid_entries[i];
+        if ((entry->flags & seL4_X86_CPUIDEntry_Valid) && entry->leaf == leaf &&
+            ((entry->flags & seL4_X86_CPUIDEntry_AnySubleaf) || entry->subleaf == subleaf)) {
+            vcpu->gp_registers[VCPU_EAX] = entry->eax;
+            vcpu->gp_registers[VCPU_EBX] = entry->ebx;
+            vcpu->gp_registers[VCPU_ECX] = entry->ecx;
+            vcpu->gp_registers[VCPU_EDX] = entry->edx;
+            return true;
+        }
+    }
+    return false;
+}
+
+static vcpu_msr_entry_t *lookupMSREntry(vcpu_t *vcpu, uint32_t msr, word_t access)
+{
+    for (word_t i = 0; i < CONFIG_VTX_FAST_EXIT_MSR_ENTRIES; i++) {
+        if ((vcpu->msr_entries[i].flags & access) && vcpu->msr_entries[i].msr == msr) {
+            return &vcpu->msr_entries[i];
+        }
+    }
+    return NULL;
+}
+
+/* A halted guest has nothing to do until the VCPU owner is notified, so wait on
+ * the bound notification as if seL4_VMEnter had been interrupted by it */
+static bool_t handleFastHLT(vcpu_t *vcpu)
+{
+    tcb_t *thread = NODE_STATE(ksCurThread);
+    notification_t *ntfnPtr = thread->tcbBoundNotification;
+
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    /* Posted interrupts are not seen by the bound notification */
+    if (vcpu->posted_interrupts) {
+        return false;
+    }
+#endif
+    if (!ntfnPtr) {
+        return false;
+    }
+
+    skipGuestInstruction();
+    vcpu_sysvmenter_reply_to_user(thread);
+    setRegister(thread, msgInfoRegister, SEL4_VMENTER_RESULT_NOTIF);
+    setThreadState(thread, ThreadState_Running);
+    receiveSignal(thread, cap_notification_cap_new(0, true, false, NTFN_REF(ntfnPtr)), true);
+    return true;
+}
+
+/* Handles an exit without involving the VCPU owner if it enabled that for the
+ * exit reason and the kernel has what it needs to emulate the instruction */
+static bool_t handleFastVmexit(vcpu_t *vcpu, uint32_t reason)
+{
+    word_t exit;
+    vcpu_msr_entry_t *entry;
+
+    switch (reason) {
+    case CPUID:
+        exit = seL4_X86_FastExit_CPUID;
+        break;
+    case RDTSC:
+        exit = seL4_X86_FastExit_RDTSC;
+        break;
+    case RDMSR:
+        exit = seL4_X86_FastExit_RDMSR;
+        break;
+    case WRMSR:
+        exit = seL4_X86_FastExit_WRMSR;
+        break;
+    case HLT:
+        exit = seL4_X86_FastExit_HLT;
+        break;
+    default:
+        return false;
+    }
+    if (!(vcpu->fast_exits & BIT(exit))) {
+        return false;
+    }
+
+    switch (exit) {
+    case seL4_X86_FastExit_CPUID:
+        if (!handleFastCPUID(vcpu)) {
+            return false;
+        }
+        skipGuestInstruction();
+        break;
+    case seL4_X86_FastExit_RDTSC: {
+        uint64_t tsc = x86_rdtsc();
+        if (vmread(VMX_CONTROL_PRIMARY_PROCESSOR_CONTROLS) & VMX_PRIMARY_TSC_OFFSETTING) {
+            tsc += vmread(VMX_CONTROL_TSC_OFFSET);
+        }
+        setGuestEDXEAX(vcpu, tsc);
+        skipGuestInstruction();
+        break;
+    }
+    case seL4_X86_FastExit_RDMSR:
+        entry = lookupMSREntry(vcpu, vcpu->gp_registers[VCPU_ECX], seL4_X86_MSREntry_Read);
+        if (!entry) {
+            return false;
+        }
+        setGuestEDXEAX(vcpu, entry->value);
+        skipGuestInstruction();
+        break;
+    case seL4_X86_FastExit_WRMSR:
+        entry = lookupMSREntry(vcpu, vcpu->gp_registers[VCPU_ECX], seL4_X86_MSREntry_Write);
+        if (!entry) {
+            return false;
+        }
+        entry->value = ((uint64_t)(uint32_t)vcpu->gp_registers[VCPU_EDX] << 32) |
+                       (uint32_t)vcpu->gp_registers[VCPU_EAX];
+        skipGuestInstruction();
+        break;
+    case seL4_X86_FastExit_HLT:
+        if (!handleFastHLT(vcpu)) {
+            return false;
+        }
+        vcpu->fast_exit_count[exit]++;
+#ifdef CONFIG_KERNEL_MCS
+        updateTimestamp();
+        checkBudget();
+#endif
+        schedule();
+        activateThread();
+        return true;
+    }
+
+    vcpu->fast_exit_count[exit]++;
+    return true;
+}
+#endif /* CONFIG_VTX_FAST_EXITS */
+
 static inline void finishVmexitSaving(void)
 {
     vcpu_t *vcpu = ARCH_NODE_STATE(x86KSCurrentVCPU);
@@ -1302,6 +2269,12 @@ exception_t handleVmexit(void)
 #endif
     /* the basic exit reason is the bottom 16 bits of the exit reason field */
     reason = vmread(VMX_DATA_EXIT_REASON) & MASK(16);
+#ifdef CONFIG_VCPU_EXIT_STATS
+    vcpuExitStatsExit(&NODE_STATE(ksCurThread)->tcbArch.tcbVCPU->exit_stats, reason, x86_rdtsc());
+#endif
+#ifdef TRACK_KERNEL_ENTRIES
+    ksKernelEntry.word = reason;
+#endif
     if (reason == EXTERNAL_INTERRUPT) {
         if (vmx_feature_ack_on_exit) {
             interrupt = vmread(VMX_DATA_EXIT_INTERRUPT_INFO);
@@ -1401,6 +2374,12 @@ exception_t handleVmexit(void)
             }
         }
     }
+#ifdef CONFIG_VTX_FAST_EXITS
+    if (handleFastVmexit(NODE_STATE(ksCurThread)->tcbArch.tcbVCPU, reason)) {
+        return EXCEPTION_NONE;
+    }
+#endif
+
     switch (reason) {
     case EXCEPTION_OR_NMI:
     case MOV_DR:
@@ -1481,6 +2460,16 @@ static void invvpid_context(uint16_t vpid)
     asm volatile("invvpid %0, %1" :: "m"(operand), "r"((word_t)1) : "cc");
 }
 
+static void invvpid_all_context(void)
+{
+    struct {
+        uint64_t vpid : 16;
+        uint64_t rsvd : 48;
+        uint64_t address;
+    } PACKED operand = {0, 0, 0};
+    asm volatile("invvpid %0, %1" :: "m"(operand), "r"((word_t)2) : "cc");
+}
+
 static void setEPTRoot(cap_t vmxSpace, vcpu_t *vcpu)
 {
     paddr_t ept_root;
@@ -1503,7 +2492,7 @@ static void setEPTRoot(cap_t vmxSpace, vcpu_t *vcpu)
         vcpu->last_ept_root = ept_root;
         vmx_eptp_t eptp = vmx_eptp_new(
                               ept_root,       /* paddr of ept */
-                              0,              /* do not use accessed and dirty flags */
+                              vmx_feature_ept_ad, /* track accessed and dirty pages if enabled */
                               3,              /* depth (4) minus 1 of desired table walking */
                               6               /* write back memory type */
                           );
@@ -1567,69 +2556,64 @@ static void handleLazyFpu(void)
     }
 }
 
-void clearVPIDIOPortMappings(vpid_t vpid, uint16_t first, uint16_t last)
+/* Hardware VPIDs are handed out in order on each core. Once they run out the
+ * generation of the core is bumped and the TLB entries of all VPIDs flushed,
+ * so that any VCPU still holding a VPID of an older generation is given a new
+ * one when it next runs. Without the all-context INVVPID, each VPID is instead
+ * flushed by findFreeVPID as it is handed out in the new generation. */
+static void rolloverVPIDGeneration(void)
 {
-    if (vpid == VPID_INVALID) {
-        return;
+    ARCH_NODE_STATE(x86KSVPIDGeneration)++;
+    ARCH_NODE_STATE(x86KSNextVPID) = VPID_FIRST;
+    if (vmx_feature_vpid && vmx_ept_vpid_cap_msr_get_invvpid_all_context(vpid_capability)) {
+        invvpid_all_context();
     }
-    vcpu_t *vcpu = x86KSVPIDTable[vpid];
-    if (vcpu == NULL) {
-        return;
-    }
-    assert(vcpu->vpid == vpid);
-    setIOPortMask(vcpu->io, first, last, true);
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+    ARCH_NODE_STATE(benchmark_vpid_rollovers)++;
+#endif
 }
 
-static inline vpid_t nextVPID(vpid_t vpid)
+static vpid_t findFreeVPID(void)
 {
-    if (vpid == VPID_LAST) {
-        return VPID_FIRST;
-    } else {
-        return vpid + 1;
-    }
-}
+    vpid_t vpid;
 
-static void invalidateVPID(vpid_t vpid)
-{
-    vcpu_t *vcpu = x86KSVPIDTable[vpid];
-    /* clear the IO bitmap as when we sever the VPID asignment we lose
-     * the ability for the references in IO port capabilities to invalidate */
-    memset(vcpu->io, ~0, sizeof(vcpu->io));
-    /* invalidate the VPID context */
-    if (vmx_feature_vpid) {
+    if (unlikely(ARCH_NODE_STATE(x86KSNextVPID) > HW_VPID_LAST)) {
+        rolloverVPIDGeneration();
+    }
+    vpid = ARCH_NODE_STATE(x86KSNextVPID)++;
+    if (vmx_feature_vpid && ARCH_NODE_STATE(x86KSVPIDGeneration) != 0 &&
+        !vmx_ept_vpid_cap_msr_get_invvpid_all_context(vpid_capability)) {
         invvpid_context(vpid);
     }
+    return vpid;
 }
 
-static vpid_t findFreeVPID(void)
+static inline bool_t isVPIDValid(vcpu_t *vcpu)
 {
-    vpid_t vpid;
-
-    vpid = x86KSNextVPID;
-    do {
-        if (x86KSVPIDTable[vpid] == NULL) {
-            return vpid;
-        }
-        vpid = nextVPID(vpid);
-    } while (vpid != x86KSNextVPID);
-
-    /* Forcively take the next VPID */
-    vpid = x86KSNextVPID;
-    invalidateVPID(vpid);
-
-    x86KSVPIDTable[vpid]->vpid = VPID_INVALID;
-    x86KSVPIDTable[vpid] = NULL;
-
-    x86KSNextVPID = nextVPID(x86KSNextVPID);
-    return vpid;
+    return vcpu->vpid != VPID_INVALID &&
+#ifdef ENABLE_SMP_SUPPORT
+           vcpu->vpid_core == getCurrentCPUIndex() &&
+#endif
+           vcpu->vpid_generation == ARCH_NODE_STATE(x86KSVPIDGeneration);
 }
 
 static void storeVPID(vcpu_t *vcpu, vpid_t vpid)
 {
-    assert(x86KSVPIDTable[vpid] == NULL);
-    assert(vcpu->vpid == VPID_INVALID);
-    x86KSVPIDTable[vpid] = vcpu;
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+    /* The previous VPID of this core was retired by a rollover */
+    if (vcpu->vpid != VPID_INVALID
+#ifdef ENABLE_SMP_SUPPORT
+        && vcpu->vpid_core == getCurrentCPUIndex()
+#endif
+       ) {
+        ARCH_NODE_STATE(benchmark_vpid_evictions)++;
+    }
+#endif
     vcpu->vpid = vpid;
+    vcpu->vpid_generation = ARCH_NODE_STATE(x86KSVPIDGeneration);
+#ifdef ENABLE_SMP_SUPPORT
+    vcpu->vpid_core = getCurrentCPUIndex();
+#endif
 }
 
 void restoreVMCS(void)
@@ -1647,15 +2631,22 @@ void restoreVMCS(void)
         vmwrite(VMX_HOST_CR3, getCurrentCR3().words[0]);
     }
 #endif
-    if (expected_vmcs->vpid == VPID_INVALID) {
-        vpid_t vpid = findFreeVPID();
-        storeVPID(expected_vmcs, vpid);
+    if (!isVPIDValid(expected_vmcs)) {
+        storeVPID(expected_vmcs, findFreeVPID());
         if (vmx_feature_vpid) {
-            vmwrite(VMX_CONTROL_VPID, vpid);
+            vmwrite(VMX_CONTROL_VPID, expected_vmcs->vpid);
         }
     }
     setEPTRoot(TCB_PTR_CTE_PTR(NODE_STATE(ksCurThread), tcbArchEPTRoot)->cap, expected_vmcs);
     handleLazyFpu();
+#ifdef CONFIG_VCPU_EXIT_STATS
+    vcpuExitStatsResume(&expected_vmcs->exit_stats, x86_rdtsc());
+#endif
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+    if (expected_vmcs->posted_interrupts) {
+        resendPostedInterruptNotification(expected_vmcs);
+    }
+#endif
 }
 
 void invept(ept_pml4e_t *ept_pml4)
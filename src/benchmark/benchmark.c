@@ -51,6 +51,26 @@ exception_t handle_SysBenchmarkResetLog(void)
     NODE_STATE(benchmark_kernel_time) = 0;
     NODE_STATE(benchmark_kernel_number_entries) = 0;
     NODE_STATE(benchmark_kernel_number_schedules) = 1;
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+    NODE_STATE(benchmark_lookup_cache_hits) = 0;
+    NODE_STATE(benchmark_lookup_cache_misses) = 0;
+    NODE_STATE(benchmark_lookup_cache_invalidations) = 0;
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+#ifdef CONFIG_FPU_SWITCH_POLICY
+    NODE_STATE(benchmark_fpu_faults) = 0;
+    NODE_STATE(benchmark_fpu_eager_restores) = 0;
+    NODE_STATE(benchmark_fpu_switches) = 0;
+    NODE_STATE(benchmark_fpu_switch_cycles) = 0;
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+#ifdef CONFIG_IRQ_BATCHING
+    NODE_STATE(benchmark_irq_entries) = 0;
+    NODE_STATE(benchmark_irqs_handled) = 0;
+#endif /* CONFIG_IRQ_BATCHING */
+#ifdef CONFIG_SCHED_EDF
+    NODE_STATE(benchmark_schedule_cycles) = 0;
+    NODE_STATE(benchmark_edf_dispatches) = 0;
+    NODE_STATE(benchmark_edf_deadline_misses) = 0;
+#endif /* CONFIG_SCHED_EDF */
     benchmark_arch_utilisation_reset();
 #endif /* CONFIG_BENCHMARK_TRACK_UTILISATION */
 
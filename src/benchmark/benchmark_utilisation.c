@@ -65,6 +65,40 @@ void benchmark_track_utilisation_dump(void)
     buffer[BENCHMARK_TOTAL_KERNEL_UTILISATION] = NODE_STATE(benchmark_kernel_time);
     buffer[BENCHMARK_TOTAL_NUMBER_KERNEL_ENTRIES] = NODE_STATE(benchmark_kernel_number_entries);
 
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+    buffer[BENCHMARK_LOOKUP_CACHE_HITS] = NODE_STATE(benchmark_lookup_cache_hits);
+    buffer[BENCHMARK_LOOKUP_CACHE_MISSES] = NODE_STATE(benchmark_lookup_cache_misses);
+    buffer[BENCHMARK_LOOKUP_CACHE_INVALIDATIONS] = NODE_STATE(benchmark_lookup_cache_invalidations);
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+
+#ifdef CONFIG_FPU_SWITCH_POLICY
+    buffer[BENCHMARK_FPU_FAULTS] = NODE_STATE(benchmark_fpu_faults);
+    buffer[BENCHMARK_FPU_EAGER_RESTORES] = NODE_STATE(benchmark_fpu_eager_restores);
+    buffer[BENCHMARK_FPU_SWITCHES] = NODE_STATE(benchmark_fpu_switches);
+    buffer[BENCHMARK_FPU_SWITCH_CYCLES] = NODE_STATE(benchmark_fpu_switch_cycles);
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+
+#ifdef CONFIG_IRQ_BATCHING
+    buffer[BENCHMARK_IRQ_ENTRIES] = NODE_STATE(benchmark_irq_entries);
+    buffer[BENCHMARK_IRQS_HANDLED] = NODE_STATE(benchmark_irqs_handled);
+#endif /* CONFIG_IRQ_BATCHING */
+
+#ifdef CONFIG_SCHED_EDF
+    buffer[BENCHMARK_SCHEDULE_CYCLES] = NODE_STATE(benchmark_schedule_cycles);
+    buffer[BENCHMARK_EDF_DISPATCHES] = NODE_STATE(benchmark_edf_dispatches);
+    buffer[BENCHMARK_EDF_DEADLINE_MISSES] = NODE_STATE(benchmark_edf_deadline_misses);
+#endif /* CONFIG_SCHED_EDF */
+
+#if defined(CONFIG_ARCH_AARCH64) && defined(CONFIG_ARM_HYPERVISOR_SUPPORT)
+    buffer[BENCHMARK_HW_ASID_ROLLOVERS] = benchmark_hw_asid_rollovers;
+    buffer[BENCHMARK_HW_ASID_EVICTIONS] = benchmark_hw_asid_evictions;
+#endif
+
+#ifdef CONFIG_VTX
+    buffer[BENCHMARK_VPID_ROLLOVERS] = ARCH_NODE_STATE(benchmark_vpid_rollovers);
+    buffer[BENCHMARK_VPID_EVICTIONS] = ARCH_NODE_STATE(benchmark_vpid_evictions);
+#endif
+
 }
 
 void benchmark_track_reset_utilisation(tcb_t *tcb)
@@ -43,7 +43,7 @@ void NORETURN fastpath_call(word_t cptr, word_t msgInfo)
     }
 
     /* Lookup the cap */
-    ep_cap = lookup_fp(TCB_PTR_CTE_PTR(NODE_STATE(ksCurThread), tcbCTable)->cap, cptr);
+    ep_cap = lookup_fp_cached(NODE_STATE(ksCurThread), cptr);
 
     /* Check it's an endpoint */
     if (unlikely(!cap_capType_equals(ep_cap, cap_endpoint_cap) ||
@@ -105,7 +105,7 @@ void NORETURN fastpath_call(word_t cptr, word_t msgInfo)
     }
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
     /* Ensure the vmid is valid. */
-    if (unlikely(!asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map))) {
+    if (unlikely(!isStoredVMIDValid(asid_map))) {
         slowpath(SysCall);
     }
     /* vmids are the tags used instead of hw_asids in hyp mode */
@@ -196,6 +196,7 @@ void NORETURN fastpath_call(word_t cptr, word_t msgInfo)
     sc->scTcb = dest;
     dest->tcbSchedContext = sc;
     NODE_STATE(ksCurThread)->tcbSchedContext = NULL;
+    edfDonate(NODE_STATE(ksCurThread), dest);
 
     reply_t *old_caller = sc->scReply;
     reply->replyPrev = call_stack_new(REPLY_REF(sc->scReply), false);
@@ -269,8 +270,7 @@ void NORETURN fastpath_reply_recv(word_t cptr, word_t msgInfo)
     }
 
     /* Lookup the cap */
-    ep_cap = lookup_fp(TCB_PTR_CTE_PTR(NODE_STATE(ksCurThread), tcbCTable)->cap,
-                       cptr);
+    ep_cap = lookup_fp_cached(NODE_STATE(ksCurThread), cptr);
 
     /* Check it's an endpoint */
     if (unlikely(!cap_capType_equals(ep_cap, cap_endpoint_cap) ||
@@ -280,7 +280,7 @@ void NORETURN fastpath_reply_recv(word_t cptr, word_t msgInfo)
 
 #ifdef CONFIG_KERNEL_MCS
     /* lookup the reply object */
-    cap_t reply_cap = lookup_fp(TCB_PTR_CTE_PTR(NODE_STATE(ksCurThread), tcbCTable)->cap, reply);
+    cap_t reply_cap = lookup_fp_cached(NODE_STATE(ksCurThread), reply);
 
     /* check it's a reply object */
     if (unlikely(!cap_capType_equals(reply_cap, cap_reply_cap))) {
@@ -294,6 +294,13 @@ void NORETURN fastpath_reply_recv(word_t cptr, word_t msgInfo)
         slowpath(SysReplyRecv);
     }
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+    /* The slowpath removes a granted frame on reply */
+    if (unlikely(!cap_capType_equals(TCB_PTR_CTE_PTR(NODE_STATE(ksCurThread), tcbGrantFrame)->cap, cap_null_cap))) {
+        slowpath(SysReplyRecv);
+    }
+#endif
+
     /* Get the endpoint address */
     ep_ptr = EP_PTR(cap_endpoint_cap_get_capEPPtr(ep_cap));
 
@@ -382,7 +389,7 @@ void NORETURN fastpath_reply_recv(word_t cptr, word_t msgInfo)
     }
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
     /* Ensure the vmid is valid. */
-    if (unlikely(!asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map))) {
+    if (unlikely(!isStoredVMIDValid(asid_map))) {
         slowpath(SysReplyRecv);
     }
 
@@ -492,6 +499,7 @@ void NORETURN fastpath_reply_recv(word_t cptr, word_t msgInfo)
     NODE_STATE(ksCurThread)->tcbSchedContext = NULL;
     caller->tcbSchedContext = sc;
     sc->scTcb = caller;
+    edfDonate(NODE_STATE(ksCurThread), caller);
 
     sc->scReply = REPLY_PTR(prev_ptr);
     if (unlikely(REPLY_PTR(prev_ptr) != NULL)) {
@@ -579,7 +587,7 @@ void NORETURN fastpath_signal(word_t cptr, word_t msgInfo)
     }
 
     /* Lookup the cap */
-    cap_t cap = lookup_fp(TCB_PTR_CTE_PTR(NODE_STATE(ksCurThread), tcbCTable)->cap, cptr);
+    cap_t cap = lookup_fp_cached(NODE_STATE(ksCurThread), cptr);
 
     /* Check it's a notification */
     if (unlikely(!cap_capType_equals(cap, cap_notification_cap))) {
@@ -708,6 +716,7 @@ void NORETURN fastpath_signal(word_t cptr, word_t msgInfo)
      * the slowpath doesn't seem to do anything special besides just not
      * not scheduling the dest thread. */
     if (schedulable) {
+        edfRelease(dest);
         if (NODE_STATE(ksCurThread)->tcbPriority > dest->tcbPriority || crossnode) {
             SCHED_ENQUEUE(dest);
         } else {
@@ -741,7 +750,7 @@ void NORETURN fastpath_vm_fault(vm_fault_type_t type)
 #else
     cptr_t handlerCPtr;
     handlerCPtr = NODE_STATE(ksCurThread)->tcbFaultHandler;
-    handler_cap = lookup_fp(TCB_PTR_CTE_PTR(NODE_STATE(ksCurThread), tcbCTable)->cap, handlerCPtr);
+    handler_cap = lookup_fp_cached(NODE_STATE(ksCurThread), handlerCPtr);
 #endif
 
     /* Check that the cap is an endpoint cap and on non-mcs, that you can send to it and create the reply cap */
@@ -787,7 +796,7 @@ void NORETURN fastpath_vm_fault(vm_fault_type_t type)
     }
 #ifdef CONFIG_ARM_HYPERVISOR_SUPPORT
     /* Ensure the vmid is valid. */
-    if (unlikely(!asid_map_asid_map_vspace_get_stored_vmid_valid(asid_map))) {
+    if (unlikely(!isStoredVMIDValid(asid_map))) {
         vm_fault_slowpath(type);
     }
 
@@ -867,6 +876,7 @@ void NORETURN fastpath_vm_fault(vm_fault_type_t type)
     sc->scTcb = dest;
     dest->tcbSchedContext = sc;
     NODE_STATE(ksCurThread)->tcbSchedContext = NULL;
+    edfDonate(NODE_STATE(ksCurThread), dest);
 
     reply_t *old_caller = sc->scReply;
     reply->replyPrev = call_stack_new(REPLY_REF(sc->scReply), false);
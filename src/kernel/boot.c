@@ -366,15 +366,22 @@ BOOT_CODE create_frames_of_region_ret_t create_frames_of_region(
 )
 {
     pptr_t     f;
+    vptr_t     vptr;
+    word_t     size_bits;
     cap_t      frame_cap;
     seL4_SlotPos slot_pos_before;
     seL4_SlotPos slot_pos_after;
 
     slot_pos_before = ndks_boot.slot_pos_cur;
 
-    for (f = reg.start; f < reg.end; f += BIT(PAGE_BITS)) {
+    for (f = reg.start; f < reg.end; f += BIT(size_bits)) {
+        size_bits = PAGE_BITS;
         if (do_map) {
-            frame_cap = create_mapped_it_frame_cap(pd_cap, f, pptr_to_paddr((void *)(f - pv_offset)), IT_ASID, false, true);
+            vptr = pptr_to_paddr((void *)(f - pv_offset));
+            if (it_is_large_vptr(vptr)) {
+                size_bits = seL4_LargePageBits;
+            }
+            frame_cap = create_mapped_it_frame_cap(pd_cap, f, vptr, IT_ASID, size_bits != PAGE_BITS, true);
         } else {
             frame_cap = create_unmapped_it_frame_cap(f, false);
         }
@@ -397,6 +404,24 @@ BOOT_CODE create_frames_of_region_ret_t create_frames_of_region(
     };
 }
 
+#ifdef CONFIG_ROOTSERVER_LARGE_PAGES
+/* Record the large page aligned part of the user image. It can only be mapped
+ * with large pages if its physical address has the same alignment. */
+BOOT_CODE void init_it_large_v_reg(v_region_t ui_v_reg, sword_t pv_offset)
+{
+    vptr_t start = ROUND_UP(ui_v_reg.start, seL4_LargePageBits);
+    vptr_t end = ROUND_DOWN(ui_v_reg.end, seL4_LargePageBits);
+
+    if (!IS_ALIGNED((word_t)pv_offset, seL4_LargePageBits) || start >= end) {
+        start = end = 0;
+    }
+    ndks_boot.it_large_v_reg = (v_region_t) {
+        .start = start,
+        .end = end
+    };
+}
+#endif
+
 BOOT_CODE cap_t create_it_asid_pool(cap_t root_cnode_cap)
 {
     cap_t ap_cap = cap_asid_pool_cap_new(IT_ASID >> asidLowBits, rootserver.asid_pool);
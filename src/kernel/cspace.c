@@ -12,6 +12,11 @@
 #include <model/statedata.h>
 #include <arch/machine.h>
 
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+/* Starts at 1 so that the zeroed cache of a freshly created TCB is invalid. */
+uint64_t ksCSpaceGeneration = 1;
+#endif
+
 lookupCap_ret_t lookupCap(tcb_t *thread, cptr_t cPtr)
 {
     lookupSlot_raw_ret_t lu_ret;
@@ -54,9 +59,32 @@ lookupSlot_raw_ret_t lookupSlot(tcb_t *thread, cptr_t capptr)
     resolveAddressBits_ret_t res_ret;
     lookupSlot_raw_ret_t ret;
 
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+    lookup_cache_entry_t *entry = lookupCacheEntry(thread, capptr);
+    if (likely(lookupCacheEntryValid(entry, capptr))) {
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+        NODE_STATE(benchmark_lookup_cache_hits)++;
+#endif
+        ret.status = EXCEPTION_NONE;
+        ret.slot = entry->lcSlot;
+        return ret;
+    }
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+    NODE_STATE(benchmark_lookup_cache_misses)++;
+#endif
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+
     threadRoot = TCB_PTR_CTE_PTR(thread, tcbCTable)->cap;
     res_ret = resolveAddressBits(threadRoot, capptr, wordBits);
 
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+    if (likely(res_ret.status == EXCEPTION_NONE)) {
+        entry->lcGeneration = ksCSpaceGeneration;
+        entry->lcCPtr = capptr;
+        entry->lcSlot = res_ret.slot;
+    }
+#endif
+
     ret.status = res_ret.status;
     ret.slot = res_ret.slot;
     return ret;
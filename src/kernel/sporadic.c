@@ -7,6 +7,7 @@
 #include <types.h>
 #include <api/failures.h>
 #include <object/structures.h>
+#include <mode/util.h>
 
 /* functions to manage the circular buffer of
  * sporadic budget replenishments (refills for short).
@@ -86,7 +87,8 @@ static UNUSED bool_t refill_ordered(sched_context_t *sc)
 #define REFILL_SANITY_START(sc) ticks_t _sum = refill_sum(sc); assert(isRoundRobin(sc) || refill_ordered(sc));
 #define REFILL_SANITY_CHECK(sc, budget) \
     do { \
-        assert(refill_sum(sc) == budget); assert(isRoundRobin(sc) || refill_ordered(sc)); \
+        assert(refill_sum(sc) == budget); assert(refill_sum(sc) == sc->scBudget); \
+        assert(isRoundRobin(sc) || refill_ordered(sc)); \
     } while (0)
 
 #define REFILL_SANITY_END(sc) \
@@ -156,6 +158,7 @@ static inline void maybe_add_empty_tail(sched_context_t *sc)
 void refill_new(sched_context_t *sc, word_t max_refills, ticks_t budget, ticks_t period)
 {
     sc->scPeriod = period;
+    sc->scBudget = budget;
     sc->scRefillHead = 0;
     sc->scRefillTail = 0;
     sc->scRefillMax = max_refills;
@@ -186,8 +189,9 @@ void refill_update(sched_context_t *sc, ticks_t new_period, ticks_t new_budget,
     sc->scRefillTail = sc->scRefillHead;
     /* update max refills */
     sc->scRefillMax = new_max_refills;
-    /* update period */
+    /* update period and budget */
     sc->scPeriod = new_period;
+    sc->scBudget = new_budget;
 
     if (refill_ready(sc)) {
         refill_head(sc)->rTime = NODE_STATE(ksCurTime);
@@ -245,16 +249,55 @@ static bool_t refill_head_overlapping(sched_context_t *sc)
     }
 }
 
-void refill_budget_check(ticks_t usage)
+/*
+ * Charge every whole budget contained in usage at once and return the
+ * remaining usage, which is less than the budget.
+ *
+ * Charging the entire budget charges every refill once, which moves each
+ * of them a period into the future. Rather than doing this once for each
+ * budget consumed, every refill is moved by the number of whole budgets
+ * consumed, so that the time taken depends on the number of refills and
+ * not on the length of the usage.
+ */
+static ticks_t refill_charge_budgets(sched_context_t *sc, ticks_t usage, ticks_t budget)
+{
+    ticks_t head_time = refill_head(sc)->rTime;
+    ticks_t periods, delay;
+    word_t current;
+
+    if (head_time >= MAX_RELEASE_TIME) {
+        return usage;
+    }
+
+    /* Don't move the head past MAX_RELEASE_TIME, leaving the rest of the
+     * usage for the refill loop in refill_budget_check to stop at. */
+    periods = MIN(udiv64(usage, budget), udiv64(MAX_RELEASE_TIME - head_time, sc->scPeriod));
+    delay = periods * sc->scPeriod;
+
+    current = sc->scRefillHead;
+    refill_index(sc, current)->rTime += delay;
+    while (current != sc->scRefillTail) {
+        current = refill_next(sc, current);
+        refill_index(sc, current)->rTime += delay;
+    }
+
+    return usage - periods * budget;
+}
+
+static void refill_charge(sched_context_t *sc, ticks_t usage)
 {
-    sched_context_t *sc = NODE_STATE(ksCurSC);
     assert(!isRoundRobin(sc));
     REFILL_SANITY_START(sc);
 
+    if (unlikely(usage >= sc->scBudget)) {
+        usage = refill_charge_budgets(sc, usage, sc->scBudget);
+    }
+
     /*
      * We charge entire refills in a loop until we end up with a partial
      * refill or at a point where we can't place refills into the future
-     * without integer overflow.
+     * without integer overflow. As the usage left is less than the budget,
+     * this charges each refill at most once.
      *
      * Verification actually requires that the current time is at least
      * 3 * MAX_PERIOD from the INT64_MAX value, so to ease relation to
@@ -311,6 +354,47 @@ void refill_budget_check(ticks_t usage)
     REFILL_SANITY_END(sc);
 }
 
+void refill_budget_check(ticks_t usage)
+{
+    refill_charge(NODE_STATE(ksCurSC), usage);
+}
+
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+void refill_group_charge(sched_context_t *sc, ticks_t usage)
+{
+    sched_context_t *group = sc->scGroup;
+
+    /* a round robin group has the whole period, so there is nothing to cap */
+    if (group != NULL && usage > 0 && !isRoundRobin(group)) {
+        refill_charge(group, usage);
+    }
+}
+
+void refill_group_delay(sched_context_t *sc)
+{
+    ticks_t release = refill_head(sc->scGroup)->rTime;
+
+    if (refill_head(sc)->rTime >= release) {
+        return;
+    }
+
+    if (isRoundRobin(sc)) {
+        refill_head(sc)->rTime = release;
+        return;
+    }
+
+    REFILL_SANITY_START(sc);
+    refill_head(sc)->rTime = release;
+
+    /* merge the refills that the delayed head now overlaps */
+    while (refill_head_overlapping(sc)) {
+        refill_t old_head = refill_pop_head(sc);
+        refill_head(sc)->rTime = old_head.rTime;
+        refill_head(sc)->rAmount += old_head.rAmount;
+    }
+    REFILL_SANITY_END(sc);
+}
+#endif
 
 void refill_unblock_check(sched_context_t *sc)
 {
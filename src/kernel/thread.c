@@ -151,6 +151,11 @@ void doReplyTransfer(tcb_t *sender, tcb_t *receiver, cte_t *slot, bool_t grant)
            ThreadState_BlockedOnReply);
 #endif
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+    /* The frame granted with the call is only mapped until the reply */
+    releaseGrantFrame(sender);
+#endif
+
     word_t fault_type = seL4_Fault_get_seL4_FaultType(receiver->tcbFault);
     if (likely(fault_type == seL4_Fault_NullFault)) {
         doIPCTransfer(sender, NULL, 0, grant, receiver);
@@ -237,6 +242,63 @@ void doFaultTransfer(word_t badge, tcb_t *sender, tcb_t *receiver,
     setRegister(receiver, badgeRegister, badge);
 }
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+/* Remove the frame mapped at the grant window of a thread, if any. */
+void releaseGrantFrame(tcb_t *thread)
+{
+    cte_t *grantSlot = TCB_PTR_CTE_PTR(thread, tcbGrantFrame);
+
+    if (cap_get_capType(grantSlot->cap) != cap_null_cap) {
+        cteDeleteOne(grantSlot);
+    }
+}
+
+/* Map a frame sent over an endpoint at the grant window of the receiver,
+ * replacing any frame that is still mapped there. The previous frame is only
+ * released once the new one is known to fit. */
+static bool_t grantFrame(cte_t *slot, tcb_t *receiver)
+{
+    word_t window = *TCB_PTR_GRANT_WINDOW_PTR(receiver);
+    cap_t grantCap = TCB_PTR_CTE_PTR(receiver, tcbGrantFrame)->cap;
+    syscall_error_t syscallError;
+    lookup_fault_t lookupFault;
+    deriveCap_ret_t dc_ret;
+    bool_t replacing;
+    bool_t valid;
+
+    if (window == 0 || cap_get_capType(slot->cap) != cap_frame_cap ||
+        cap_frame_cap_get_capFVMRights(slot->cap) == VMKernelOnly) {
+        return false;
+    }
+
+    dc_ret = deriveCap(slot, slot->cap);
+    if (dc_ret.status != EXCEPTION_NONE || cap_get_capType(dc_ret.cap) != cap_frame_cap) {
+        return false;
+    }
+
+    /* a previous grant of the same size occupies the slot the new frame goes
+     * into, but frees it when it is released, unless the receiver has changed
+     * its address space since, which the architecture checks */
+    replacing = cap_get_capType(grantCap) == cap_frame_cap &&
+                cap_frame_cap_get_capFSize(grantCap) == cap_frame_cap_get_capFSize(dc_ret.cap) &&
+                cap_frame_cap_get_capFMappedAddress(grantCap) == window;
+
+    /* a failed check is not an error of the IPC, so do not leave one behind */
+    syscallError = current_syscall_error;
+    lookupFault = current_lookup_fault;
+    valid = Arch_checkGrantFrame(dc_ret.cap, receiver, window, replacing);
+    current_syscall_error = syscallError;
+    current_lookup_fault = lookupFault;
+    if (!valid) {
+        return false;
+    }
+
+    releaseGrantFrame(receiver);
+    Arch_mapGrantFrame(dc_ret.cap, slot, receiver, window);
+    return true;
+}
+#endif /* CONFIG_IPC_FRAME_GRANT */
+
 /* Like getReceiveSlots, this is specialised for single-cap transfer. */
 static seL4_MessageInfo_t transferCaps(seL4_MessageInfo_t info,
                                        endpoint_t *endpoint, tcb_t *receiver,
@@ -244,6 +306,9 @@ static seL4_MessageInfo_t transferCaps(seL4_MessageInfo_t info,
 {
     word_t i;
     cte_t *destSlot;
+#ifdef CONFIG_IPC_FRAME_GRANT
+    bool_t granted = false;
+#endif
 
     info = seL4_MessageInfo_set_extraCaps(info, 0);
     info = seL4_MessageInfo_set_capsUnwrapped(info, 0);
@@ -271,6 +336,19 @@ static seL4_MessageInfo_t transferCaps(seL4_MessageInfo_t info,
         } else {
             deriveCap_ret_t dc_ret;
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+            /* A frame mapped at the grant window is reported like an
+             * unwrapped badge, with the window address as the badge. The
+             * window holds one frame, so only the first one is granted. */
+            if (endpoint && !granted && grantFrame(slot, receiver)) {
+                granted = true;
+                setExtraBadge(receiveBuffer, *TCB_PTR_GRANT_WINDOW_PTR(receiver), i);
+                info = seL4_MessageInfo_set_capsUnwrapped(info,
+                                                          seL4_MessageInfo_get_capsUnwrapped(info) | (1 << i));
+                continue;
+            }
+#endif
+
             if (!destSlot) {
                 break;
             }
@@ -325,9 +403,17 @@ static void switchSchedContext(void)
         if (sc_constant_bandwidth(NODE_STATE(ksCurThread)->tcbSchedContext)) {
             refill_unblock_check(NODE_STATE(ksCurThread)->tcbSchedContext);
         }
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+        /* the group bounds the bandwidth of all of its members, so its budget
+         * is only usable from now on, as for a constant bandwidth SC */
+        if (NODE_STATE(ksCurThread)->tcbSchedContext->scGroup != NULL) {
+            refill_unblock_check(NODE_STATE(ksCurThread)->tcbSchedContext->scGroup);
+        }
+#endif
 
         assert(refill_ready(NODE_STATE(ksCurThread)->tcbSchedContext));
         assert(refill_sufficient(NODE_STATE(ksCurThread)->tcbSchedContext, 0));
+        assert(sc_group_ready(NODE_STATE(ksCurThread)->tcbSchedContext));
     }
 
     if (NODE_STATE(ksReprogram)) {
@@ -350,6 +436,9 @@ static void scheduleChooseNewThread(void)
 
 void schedule(void)
 {
+#if defined(CONFIG_SCHED_EDF) && defined(CONFIG_BENCHMARK_TRACK_UTILISATION)
+    timestamp_t start = timestamp();
+#endif
 #ifdef CONFIG_KERNEL_MCS
     awaken();
     checkDomainTime();
@@ -364,6 +453,15 @@ void schedule(void)
             was_runnable = false;
         }
 
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+        if (NODE_STATE(ksSchedulerAction) != SchedulerAction_ChooseNewThread &&
+            unlikely(!sc_group_ready(NODE_STATE(ksSchedulerAction)->tcbSchedContext))) {
+            /* the group of the candidate ran out of budget after it was woken */
+            postpone(NODE_STATE(ksSchedulerAction)->tcbSchedContext);
+            NODE_STATE(ksSchedulerAction) = SchedulerAction_ChooseNewThread;
+        }
+#endif
+
         if (NODE_STATE(ksSchedulerAction) == SchedulerAction_ChooseNewThread) {
             scheduleChooseNewThread();
         } else {
@@ -375,7 +473,12 @@ void schedule(void)
              * information flow in non-fastpath cases. */
             bool_t fastfail =
                 NODE_STATE(ksCurThread) == NODE_STATE(ksIdleThread)
-                || (candidate->tcbPriority < NODE_STATE(ksCurThread)->tcbPriority);
+                || (candidate->tcbPriority < NODE_STATE(ksCurThread)->tcbPriority)
+#ifdef CONFIG_SCHED_EDF
+                /* threads at the EDF priority are ordered by deadline in chooseThread */
+                || (candidate->tcbPriority == CONFIG_EDF_PRIORITY)
+#endif
+                ;
             if (fastfail &&
                 !isHighestPrio(ksCurDomain, candidate->tcbPriority)) {
                 SCHED_ENQUEUE(candidate);
@@ -409,6 +512,9 @@ void schedule(void)
         NODE_STATE(ksReprogram) = false;
     }
 #endif
+#if defined(CONFIG_SCHED_EDF) && defined(CONFIG_BENCHMARK_TRACK_UTILISATION)
+    NODE_STATE(benchmark_schedule_cycles) += timestamp() - start;
+#endif
 }
 
 void chooseThread(void)
@@ -423,9 +529,22 @@ void chooseThread(void)
         dom = 0;
     }
 
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+    /* Threads stay in the ready queues when their group runs out of budget
+     * while they are not running, so move them to the release queue when
+     * they are reached. */
+    while (NODE_STATE(ksReadyQueuesL1Bitmap[dom])) {
+        thread = readyQueueHead(dom, getHighestPrio(dom));
+        if (likely(sc_group_ready(thread->tcbSchedContext))) {
+            break;
+        }
+        postpone(thread->tcbSchedContext);
+    }
+#endif
+
     if (likely(NODE_STATE(ksReadyQueuesL1Bitmap[dom]))) {
         prio = getHighestPrio(dom);
-        thread = NODE_STATE(ksReadyQueues)[ready_queues_index(dom, prio)].head;
+        thread = readyQueueHead(dom, prio);
         assert(thread);
         assert(isSchedulable(thread));
 #ifdef CONFIG_KERNEL_MCS
@@ -445,10 +564,19 @@ void switchToThread(tcb_t *thread)
     assert(!thread_state_get_tcbInReleaseQueue(thread->tcbState));
     assert(refill_sufficient(thread->tcbSchedContext, 0));
     assert(refill_ready(thread->tcbSchedContext));
+    assert(sc_group_ready(thread->tcbSchedContext));
 #endif
 
 #ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
     benchmark_utilisation_switch(NODE_STATE(ksCurThread), thread);
+#ifdef CONFIG_SCHED_EDF
+    if (thread->tcbPriority == CONFIG_EDF_PRIORITY) {
+        NODE_STATE(benchmark_edf_dispatches)++;
+        if (NODE_STATE(ksCurTime) > thread->tcbDeadline) {
+            NODE_STATE(benchmark_edf_deadline_misses)++;
+        }
+    }
+#endif
 #endif
     Arch_switchToThread(thread);
     tcbSchedDequeue(thread);
@@ -483,6 +611,16 @@ void setMCPriority(tcb_t *tptr, prio_t mcp)
 #ifdef CONFIG_KERNEL_MCS
 void setPriority(tcb_t *tptr, prio_t prio)
 {
+#ifdef CONFIG_SCHED_EDF
+    if (tptr->tcbPriority == CONFIG_EDF_PRIORITY) {
+        ksEDFNumThreads--;
+    }
+    if (prio == CONFIG_EDF_PRIORITY) {
+        ksEDFNumThreads++;
+    }
+    assert(ksEDFNumThreads <= CONFIG_EDF_MAX_THREADS);
+#endif
+
     switch (thread_state_get_tsType(tptr->tcbState)) {
     case ThreadState_Running:
     case ThreadState_Restart:
@@ -532,6 +670,10 @@ void possibleSwitchTo(tcb_t *target)
 {
 #ifdef CONFIG_KERNEL_MCS
     if (target->tcbSchedContext != NULL && !thread_state_get_tcbInReleaseQueue(target->tcbState)) {
+        /* a thread woken on the current scheduling context continues its job */
+        if (target->tcbSchedContext != NODE_STATE(ksCurSC)) {
+            edfRelease(target);
+        }
 #endif
         if (ksCurDomain != target->tcbDomain
             SMP_COND_STATEMENT( || target->tcbAffinity != getCurrentCPUIndex())) {
@@ -567,6 +709,11 @@ void scheduleTCB(tcb_t *tptr)
 #ifdef CONFIG_KERNEL_MCS
 void postpone(sched_context_t *sc)
 {
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+    if (unlikely(!sc_group_ready(sc))) {
+        refill_group_delay(sc);
+    }
+#endif
     tcbSchedDequeue(sc->scTcb);
     tcbReleaseEnqueue(sc->scTcb);
     NODE_STATE_ON_CORE(ksReprogram, sc->scCore) = true;
@@ -575,7 +722,7 @@ void postpone(sched_context_t *sc)
 void setNextInterrupt(void)
 {
     time_t next_interrupt = NODE_STATE(ksCurTime) +
-                            refill_head(NODE_STATE(ksCurThread)->tcbSchedContext)->rAmount;
+                            sc_head_budget(NODE_STATE(ksCurThread)->tcbSchedContext);
 
     if (numDomains > 1) {
         next_interrupt = MIN(next_interrupt, NODE_STATE(ksCurTime) + ksDomainTime);
@@ -598,6 +745,11 @@ void chargeBudget(ticks_t consumed, bool_t canTimeoutFault)
         } else {
             refill_budget_check(consumed);
         }
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+        /* the group only pays for the time actually consumed, even when the
+         * SC gives up the rest of its budget */
+        refill_group_charge(NODE_STATE(ksCurSC), NODE_STATE(ksConsumed));
+#endif
 
         assert(refill_head(NODE_STATE(ksCurSC))->rAmount >= MIN_BUDGET);
         NODE_STATE(ksCurSC)->scConsumed += consumed;
@@ -616,10 +768,12 @@ void endTimeslice(bool_t can_timeout_fault)
     if (can_timeout_fault && !isRoundRobin(NODE_STATE(ksCurSC)) && validTimeoutHandler(NODE_STATE(ksCurThread))) {
         current_fault = seL4_Fault_Timeout_new(NODE_STATE(ksCurSC)->scBadge);
         handleTimeout(NODE_STATE(ksCurThread));
-    } else if (refill_ready(NODE_STATE(ksCurSC)) && refill_sufficient(NODE_STATE(ksCurSC), 0)) {
+    } else if (refill_ready(NODE_STATE(ksCurSC)) && refill_sufficient(NODE_STATE(ksCurSC), 0) &&
+               sc_group_ready(NODE_STATE(ksCurSC))) {
         /* apply round robin */
         assert(refill_sufficient(NODE_STATE(ksCurSC), 0));
         assert(!thread_state_get_tcbQueued(NODE_STATE(ksCurThread)->tcbState));
+        edfRelease(NODE_STATE(ksCurThread));
         SCHED_APPEND_CURRENT_TCB;
     } else {
         /* postpone until ready */
@@ -676,11 +830,23 @@ void rescheduleRequired(void)
 void awaken(void)
 {
     while (unlikely(NODE_STATE(ksReleaseHead) != NULL && refill_ready(NODE_STATE(ksReleaseHead)->tcbSchedContext))) {
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+        if (unlikely(!sc_group_ready(NODE_STATE(ksReleaseHead)->tcbSchedContext))) {
+            /* The group used more budget after the thread was queued, so
+             * hold it back until the group is released again. This leaves
+             * the thread in the future, so the loop cannot revisit it. */
+            tcb_t *delayed = tcbReleaseDequeue();
+            refill_group_delay(delayed->tcbSchedContext);
+            tcbReleaseEnqueue(delayed);
+            continue;
+        }
+#endif
         tcb_t *awakened = tcbReleaseDequeue();
         /* the currently running thread cannot have just woken up */
         assert(awakened != NODE_STATE(ksCurThread));
-        /* round robin threads should not be in the release queue */
-        assert(!isRoundRobin(awakened->tcbSchedContext));
+        /* round robin threads are only in the release queue while they wait
+         * for their group */
+        assert(!isRoundRobin(awakened->tcbSchedContext) || config_set(CONFIG_SCHED_CONTEXT_GROUPS));
         /* threads should wake up on the correct core */
         SMP_COND_STATEMENT(assert(awakened->tcbAffinity == getCurrentCPUIndex()));
         /* threads HEAD refill should always be >= MIN_BUDGET */
@@ -9,11 +9,17 @@
 #include <api/failures.h>
 #include <model/statedata.h>
 #include <arch/object/structures.h>
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+#include <arch/benchmark.h>
+#endif
 
 #ifdef CONFIG_HAVE_FPU
 /* Switch the owner of the FPU to the given thread on local core. */
 void switchLocalFpuOwner(user_fpu_state_t *new_owner)
 {
+#if defined(CONFIG_FPU_SWITCH_POLICY) && defined(CONFIG_BENCHMARK_TRACK_UTILISATION)
+    timestamp_t start = timestamp();
+#endif
     enableFpu();
     if (NODE_STATE(ksActiveFPUState)) {
         saveFpuState(NODE_STATE(ksActiveFPUState));
@@ -25,6 +31,10 @@ void switchLocalFpuOwner(user_fpu_state_t *new_owner)
         disableFpu();
     }
     NODE_STATE(ksActiveFPUState) = new_owner;
+#if defined(CONFIG_FPU_SWITCH_POLICY) && defined(CONFIG_BENCHMARK_TRACK_UTILISATION)
+    NODE_STATE(benchmark_fpu_switches)++;
+    NODE_STATE(benchmark_fpu_switch_cycles) += timestamp() - start;
+#endif
 }
 
 void switchFpuOwner(user_fpu_state_t *new_owner, word_t cpu)
@@ -51,12 +61,45 @@ exception_t handleFPUFault(void)
      * we presumably are happy to assume will not be running seL4. */
     assert(!nativeThreadUsingFPU(NODE_STATE(ksCurThread)));
 
+#ifdef CONFIG_FPU_SWITCH_POLICY
+    /* Count the fault towards the adaptive policy. The count is left to wrap
+     * once eager loading has taken over, see eagerFPURestore. */
+    if (NODE_STATE(ksCurThread)->tcbFPUUseCount < CONFIG_FPU_ADAPTIVE_THRESHOLD) {
+        NODE_STATE(ksCurThread)->tcbFPUUseCount++;
+    }
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+    NODE_STATE(benchmark_fpu_faults)++;
+#endif
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+
     /* Otherwise, lazily switch over the FPU. */
     switchLocalFpuOwner(&NODE_STATE(ksCurThread)->tcbArch.tcbContext.fpuState);
 
     return EXCEPTION_NONE;
 }
 
+#ifdef CONFIG_FPU_SWITCH_POLICY
+void eagerFPURestore(tcb_t *thread)
+{
+    if (likely(nativeThreadUsingFPU(thread))) {
+        enableFpu();
+    } else {
+        switchLocalFpuOwner(&thread->tcbArch.tcbContext.fpuState);
+#ifdef CONFIG_BENCHMARK_TRACK_UTILISATION
+        NODE_STATE(benchmark_fpu_eager_restores)++;
+#endif
+        /* An adaptive thread keeps counting while loaded eagerly. When the
+         * 8-bit count wraps the thread returns to lazy switching, and has to
+         * fault on the FPU again to be considered for eager loading. */
+        if (thread->tcbFPUPolicy == seL4_FPUPolicy_Adaptive) {
+            thread->tcbFPUUseCount++;
+        }
+    }
+    /* The FPU is in use, so don't let the lazy heuristic switch it out. */
+    NODE_STATE(ksFPURestoresSinceSwitch) = 0;
+}
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+
 /* Prepare for the deletion of the given thread. */
 void fpuThreadDelete(tcb_t *thread)
 {
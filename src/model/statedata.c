@@ -29,6 +29,10 @@ compile_assert(ksReadyQueuesL1BitmapBigEnough, (L2_BITMAP_SIZE - 1) <= wordBits)
 /* Head of the queue of threads waiting for their budget to be replenished */
 UP_STATE_DEFINE(tcb_t *, ksReleaseHead);
 #endif
+#ifdef CONFIG_SCHED_EDF
+/* Threads queued at the EDF priority, ordered by deadline */
+UP_STATE_DEFINE(edf_queue_t, ksEDFQueues[CONFIG_NUM_DOMAINS]);
+#endif
 
 /* Current thread TCB pointer */
 UP_STATE_DEFINE(tcb_t *, ksCurThread);
@@ -69,6 +73,26 @@ UP_STATE_DEFINE(timestamp_t, benchmark_end_time);
 UP_STATE_DEFINE(timestamp_t, benchmark_kernel_time);
 UP_STATE_DEFINE(timestamp_t, benchmark_kernel_number_entries);
 UP_STATE_DEFINE(timestamp_t, benchmark_kernel_number_schedules);
+#ifdef CONFIG_CSPACE_LOOKUP_CACHE
+UP_STATE_DEFINE(timestamp_t, benchmark_lookup_cache_hits);
+UP_STATE_DEFINE(timestamp_t, benchmark_lookup_cache_misses);
+UP_STATE_DEFINE(timestamp_t, benchmark_lookup_cache_invalidations);
+#endif /* CONFIG_CSPACE_LOOKUP_CACHE */
+#ifdef CONFIG_FPU_SWITCH_POLICY
+UP_STATE_DEFINE(timestamp_t, benchmark_fpu_faults);
+UP_STATE_DEFINE(timestamp_t, benchmark_fpu_eager_restores);
+UP_STATE_DEFINE(timestamp_t, benchmark_fpu_switches);
+UP_STATE_DEFINE(timestamp_t, benchmark_fpu_switch_cycles);
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+#ifdef CONFIG_IRQ_BATCHING
+UP_STATE_DEFINE(timestamp_t, benchmark_irq_entries);
+UP_STATE_DEFINE(timestamp_t, benchmark_irqs_handled);
+#endif /* CONFIG_IRQ_BATCHING */
+#ifdef CONFIG_SCHED_EDF
+UP_STATE_DEFINE(timestamp_t, benchmark_schedule_cycles);
+UP_STATE_DEFINE(timestamp_t, benchmark_edf_dispatches);
+UP_STATE_DEFINE(timestamp_t, benchmark_edf_deadline_misses);
+#endif /* CONFIG_SCHED_EDF */
 #endif /* CONFIG_BENCHMARK_TRACK_UTILISATION */
 
 /* Units of work we have completed since the last time we checked for
@@ -91,6 +115,11 @@ ticks_t ksDomainTime;
 word_t ksDomainTime;
 #endif
 
+#ifdef CONFIG_SCHED_EDF
+/* Number of threads at the EDF priority on all cores */
+word_t ksEDFNumThreads;
+#endif
+
 /* An index into ksDomSchedule for active domain and length. */
 word_t ksDomScheduleIdx;
 
@@ -432,6 +432,7 @@ void cteInsert(cap_t newCap, cte_t *srcSlot, cte_t *destSlot)
      * untyped from it. */
     setUntypedCapAsFull(srcCap, newCap, srcSlot);
 
+    lookupCacheCapChanged(destSlot->cap, newCap);
     destSlot->cap = newCap;
     destSlot->cteMDBNode = newMDB;
     mdb_node_ptr_set_mdbNext(&srcSlot->cteMDBNode, CTE_REF(destSlot));
@@ -453,6 +454,8 @@ void cteMove(cap_t newCap, cte_t *srcSlot, cte_t *destSlot)
     assert((cte_t *)mdb_node_get_mdbNext(destSlot->cteMDBNode) == NULL &&
            (cte_t *)mdb_node_get_mdbPrev(destSlot->cteMDBNode) == NULL);
 
+    lookupCacheCapChanged(srcSlot->cap, newCap);
+
     mdb = srcSlot->cteMDBNode;
     destSlot->cap = newCap;
     srcSlot->cap = cap_null_cap_new();
@@ -491,6 +494,9 @@ void cteSwap(cap_t cap1, cte_t *slot1, cap_t cap2, cte_t *slot2)
     mdb_node_t mdb1, mdb2;
     word_t next_ptr, prev_ptr;
 
+    lookupCacheCapChanged(slot1->cap, cap2);
+    lookupCacheCapChanged(slot2->cap, cap1);
+
     slot1->cap = cap2;
     slot2->cap = cap1;
 
@@ -584,6 +590,7 @@ static void emptySlot(cte_t *slot, cap_t cleanupInfo)
             mdb_node_ptr_set_mdbFirstBadged(&next->cteMDBNode,
                                             mdb_node_get_mdbFirstBadged(next->cteMDBNode) ||
                                             mdb_node_get_mdbFirstBadged(mdbNode));
+        lookupCacheCapChanged(slot->cap, cap_null_cap_new());
         slot->cap = cap_null_cap_new();
         slot->cteMDBNode = nullMDBNode;
 
@@ -630,6 +637,7 @@ static finaliseSlot_ret_t finaliseSlot(cte_t *slot, bool_t immediate)
             return ret;
         }
 
+        lookupCacheCapChanged(slot->cap, fc_ret.remainder);
         slot->cap = fc_ret.remainder;
 
         if (!immediate && capCyclicZombie(fc_ret.remainder, slot)) {
@@ -747,6 +755,7 @@ void insertNewCap(cte_t *parent, cte_t *slot, cap_t cap)
     cte_t *next;
 
     next = CTE_PTR(mdb_node_get_mdbNext(parent->cteMDBNode));
+    lookupCacheCapChanged(slot->cap, cap);
     slot->cap = cap;
     slot->cteMDBNode = mdb_node_new(CTE_REF(next), true, true, CTE_REF(parent));
     if (next) {
@@ -83,7 +83,7 @@ exception_t invokeIRQControl(irq_t irq, cte_t *handlerSlot, cte_t *controlSlot)
     return EXCEPTION_NONE;
 }
 
-exception_t decodeIRQHandlerInvocation(word_t invLabel, irq_t irq)
+exception_t decodeIRQHandlerInvocation(word_t invLabel, word_t length, irq_t irq, word_t *buffer)
 {
     switch (invLabel) {
     case IRQAckIRQ:
@@ -91,6 +91,74 @@ exception_t decodeIRQHandlerInvocation(word_t invLabel, irq_t irq)
         invokeIRQHandler_AckIRQ(irq);
         return EXCEPTION_NONE;
 
+#ifdef CONFIG_IRQ_ACK_MANY
+    case IRQAckMany: {
+        word_t nodeIndex, nodeDepth, nodeOffset, nodeWindow, nodeSize;
+        cap_t nodeCap;
+        cte_t *node;
+
+        if (length < 4 || current_extra_caps.excaprefs[0] == NULL) {
+            current_syscall_error.type = seL4_TruncatedMessage;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+        nodeIndex = getSyscallArg(0, buffer);
+        nodeDepth = getSyscallArg(1, buffer);
+        nodeOffset = getSyscallArg(2, buffer);
+        nodeWindow = getSyscallArg(3, buffer);
+
+        /* Look up the CNode that holds the other handlers */
+        if (nodeDepth == 0) {
+            nodeCap = current_extra_caps.excaprefs[0]->cap;
+        } else {
+            lookupSlot_ret_t lu_ret = lookupTargetSlot(current_extra_caps.excaprefs[0]->cap, nodeIndex, nodeDepth);
+            if (lu_ret.status != EXCEPTION_NONE) {
+                userError("IRQAckMany: Invalid CNode address.");
+                return lu_ret.status;
+            }
+            nodeCap = lu_ret.slot->cap;
+        }
+
+        if (cap_get_capType(nodeCap) != cap_cnode_cap) {
+            userError("IRQAckMany: CNode cap invalid.");
+            current_syscall_error.type = seL4_FailedLookup;
+            current_syscall_error.failedLookupWasSource = 1;
+            current_lookup_fault = lookup_fault_missing_capability_new(nodeDepth);
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        nodeSize = 1ul << cap_cnode_cap_get_capCNodeRadix(nodeCap);
+        if (nodeOffset > nodeSize - 1) {
+            userError("IRQAckMany: Node offset #%d too large.", (int)nodeOffset);
+            current_syscall_error.type = seL4_RangeError;
+            current_syscall_error.rangeErrorMin = 0;
+            current_syscall_error.rangeErrorMax = nodeSize - 1;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+        if (nodeWindow > wordBits || nodeWindow > nodeSize - nodeOffset) {
+            userError("IRQAckMany: Number of handlers (%d) too large.", (int)nodeWindow);
+            current_syscall_error.type = seL4_RangeError;
+            current_syscall_error.rangeErrorMin = 0;
+            current_syscall_error.rangeErrorMax = MIN(wordBits, nodeSize - nodeOffset);
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+
+        /* Holding the handler cap of every IRQ is what authorises acking it */
+        node = CTE_PTR(cap_cnode_cap_get_capCNodePtr(nodeCap)) + nodeOffset;
+        for (word_t i = 0; i < nodeWindow; i++) {
+            if (cap_get_capType(node[i].cap) != cap_irq_handler_cap) {
+                userError("IRQAckMany: Slot #%d does not hold an IRQ handler cap.", (int)(nodeOffset + i));
+                current_syscall_error.type = seL4_InvalidArgument;
+                current_syscall_error.invalidArgumentNumber = 3;
+                return EXCEPTION_SYSCALL_ERROR;
+            }
+        }
+
+        setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+        invokeIRQHandler_AckMany(irq, node, nodeWindow);
+        return EXCEPTION_NONE;
+    }
+#endif /* CONFIG_IRQ_ACK_MANY */
+
     case IRQSetIRQHandler: {
         cap_t ntfnCap;
         cte_t *slot;
@@ -153,6 +221,16 @@ void invokeIRQHandler_AckIRQ(irq_t irq)
 #endif
 }
 
+#ifdef CONFIG_IRQ_ACK_MANY
+void invokeIRQHandler_AckMany(irq_t irq, cte_t *handlers, word_t count)
+{
+    invokeIRQHandler_AckIRQ(irq);
+    for (word_t i = 0; i < count; i++) {
+        invokeIRQHandler_AckIRQ(IDX_TO_IRQT(cap_irq_handler_cap_get_capIRQ(handlers[i].cap)));
+    }
+}
+#endif /* CONFIG_IRQ_ACK_MANY */
+
 void invokeIRQHandler_SetIRQHandler(irq_t irq, cap_t cap, cte_t *slot)
 {
     cte_t *irqSlot;
@@ -183,19 +261,21 @@ void deletingIRQHandler(irq_t irq)
 
 void deletedIRQHandler(irq_t irq)
 {
+    Arch_deletedIRQHandler(irq);
     setIRQState(IRQInactive, irq);
 }
 
 void handleInterrupt(irq_t irq)
 {
-    if (unlikely(IRQT_TO_IRQ(irq) > maxIRQ)) {
+    if (unlikely(IRQT_TO_IRQ(irq) > INT_STATE_MAX_IRQ)) {
         /* The interrupt number is out of range. Pretend it did not happen by
          * handling it like an inactive interrupt (mask and ack). We assume this
          * is acceptable, because the platform specific interrupt controller
          * driver reported this interrupt. Maybe the value maxIRQ is just wrong
          * or set to a lower value because the interrupts are unused.
          */
-        printf("Received IRQ %d, which is above the platforms maxIRQ of %d\n", (int)IRQT_TO_IRQ(irq), (int)maxIRQ);
+        printf("Received IRQ %d, which is above the platforms maxIRQ of %d\n", (int)IRQT_TO_IRQ(irq),
+               (int)INT_STATE_MAX_IRQ);
         maskInterrupt(true, irq);
         ackInterrupt(irq);
         return;
@@ -198,6 +198,10 @@ finaliseCap_ret_t finaliseCap(cap_t cap, bool_t final, bool_t exposed)
             }
 #endif
             suspend(tcb);
+#ifdef CONFIG_SCHED_EDF
+            /* release the EDF heap slot of the thread */
+            setPriority(tcb, seL4_MinPrio);
+#endif
 #ifdef CONFIG_DEBUG_BUILD
             tcbDebugRemove(tcb);
 #endif
@@ -218,6 +222,10 @@ finaliseCap_ret_t finaliseCap(cap_t cap, bool_t final, bool_t exposed)
     case cap_sched_context_cap:
         if (final) {
             sched_context_t *sc = SC_PTR(cap_sched_context_cap_get_capSCPtr(cap));
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+            schedContext_leaveGroup(sc);
+            schedContext_removeGroupMembers(sc);
+#endif
             schedContext_unbindAllTCBs(sc);
             schedContext_unbindNtfn(sc);
             if (sc->scReply) {
@@ -756,8 +764,8 @@ exception_t decodeInvocation(word_t invLabel, word_t length,
         return decodeIRQControlInvocation(invLabel, length, slot, buffer);
 
     case cap_irq_handler_cap:
-        return decodeIRQHandlerInvocation(invLabel,
-                                          IDX_TO_IRQT(cap_irq_handler_cap_get_capIRQ(cap)));
+        return decodeIRQHandlerInvocation(invLabel, length,
+                                          IDX_TO_IRQT(cap_irq_handler_cap_get_capIRQ(cap)), buffer);
 
 #ifdef CONFIG_KERNEL_MCS
     case cap_sched_control_cap:
@@ -94,6 +94,14 @@ static exception_t decodeSchedContext_Bind(sched_context_t *sc)
 
     cap_t cap = current_extra_caps.excaprefs[0]->cap;
 
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+    if (sc->scGroupMembers != NULL) {
+        userError("SchedContext_Bind: sched context is a group.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+#endif
+
     switch (cap_get_capType(cap)) {
     case cap_thread_cap:
         if (sc->scTcb != NULL) {
@@ -248,6 +256,53 @@ static exception_t decodeSchedContext_YieldTo(sched_context_t *sc, word_t *buffe
     return invokeSchedContext_YieldTo(sc, buffer);
 }
 
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+static exception_t invokeSchedContext_SetGroup(sched_context_t *sc, sched_context_t *group)
+{
+    schedContext_joinGroup(sc, group);
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeSchedContext_SetGroup(sched_context_t *sc)
+{
+    if (current_extra_caps.excaprefs[0] == NULL) {
+        userError("SchedContext_SetGroup: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    cap_t groupCap = current_extra_caps.excaprefs[0]->cap;
+    if (cap_get_capType(groupCap) != cap_sched_context_cap) {
+        userError("SchedContext_SetGroup: invalid cap.");
+        current_syscall_error.type = seL4_InvalidCapability;
+        current_syscall_error.invalidCapNumber = 1;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    sched_context_t *group = SC_PTR(cap_sched_context_cap_get_capSCPtr(groupCap));
+    if (group == sc || sc->scGroup != NULL || sc->scGroupMembers != NULL) {
+        userError("SchedContext_SetGroup: sched context is already in a group or is a group.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (group->scGroup != NULL || group->scTcb != NULL || group->scNotification != NULL) {
+        userError("SchedContext_SetGroup: group is in a group or is bound.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    if (!sc_active(group) SMP_COND_STATEMENT( || group->scCore != sc->scCore)) {
+        userError("SchedContext_SetGroup: group is not configured for the core of the sched context.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return invokeSchedContext_SetGroup(sc, group);
+}
+#endif /* CONFIG_SCHED_CONTEXT_GROUPS */
+
 exception_t decodeSchedContextInvocation(word_t label, cap_t cap, word_t *buffer)
 {
     sched_context_t *sc = SC_PTR(cap_sched_context_cap_get_capSCPtr(cap));
@@ -274,6 +329,15 @@ exception_t decodeSchedContextInvocation(word_t label, cap_t cap, word_t *buffer
         return invokeSchedContext_Unbind(sc);
     case SchedContextYieldTo:
         return decodeSchedContext_YieldTo(sc, buffer);
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+    case SchedContextSetGroup:
+        return decodeSchedContext_SetGroup(sc);
+    case SchedContextClearGroup:
+        /* no decode */
+        setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+        schedContext_leaveGroup(sc);
+        return EXCEPTION_NONE;
+#endif
     default:
         userError("SchedContext invocation: Illegal operation attempted.");
         current_syscall_error.type = seL4_IllegalOperation;
@@ -307,6 +371,7 @@ void schedContext_bindTCB(sched_context_t *sc, tcb_t *tcb)
     }
     schedContext_resume(sc);
     if (isSchedulable(tcb)) {
+        edfRelease(tcb);
         SCHED_ENQUEUE(tcb);
         rescheduleRequired();
         // TODO -- at some stage we should take this call out of any TCB invocations that
@@ -356,6 +421,7 @@ void schedContext_donate(sched_context_t *sc, tcb_t *to)
         if (from == NODE_STATE(ksCurThread) || from == NODE_STATE(ksSchedulerAction)) {
             rescheduleRequired();
         }
+        edfDonate(from, to);
     }
     sc->scTcb = to;
     to->tcbSchedContext = sc;
@@ -404,3 +470,57 @@ void schedContext_completeYieldTo(tcb_t *yielder)
         schedContext_cancelYieldTo(yielder);
     }
 }
+
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+void schedContext_joinGroup(sched_context_t *sc, sched_context_t *group)
+{
+    assert(sc->scGroup == NULL && sc->scGroupMembers == NULL);
+    assert(group->scGroup == NULL && group->scTcb == NULL);
+
+    /* the thread of the SC may be running on another core */
+    SMP_COND_STATEMENT(maybeStallSC(sc));
+
+    sc->scGroup = group;
+    sc->scGroupPrev = NULL;
+    sc->scGroupNext = group->scGroupMembers;
+    if (group->scGroupMembers != NULL) {
+        group->scGroupMembers->scGroupPrev = sc;
+    }
+    group->scGroupMembers = sc;
+
+    /* a queued thread is checked against the group when it is reached, but
+     * the timer of a running one has to account for the group's budget */
+    NODE_STATE_ON_CORE(ksReprogram, sc->scCore) = true;
+}
+
+void schedContext_leaveGroup(sched_context_t *sc)
+{
+    sched_context_t *group = sc->scGroup;
+    if (group == NULL) {
+        return;
+    }
+
+    SMP_COND_STATEMENT(maybeStallSC(sc));
+
+    if (sc->scGroupPrev != NULL) {
+        sc->scGroupPrev->scGroupNext = sc->scGroupNext;
+    } else {
+        group->scGroupMembers = sc->scGroupNext;
+    }
+    if (sc->scGroupNext != NULL) {
+        sc->scGroupNext->scGroupPrev = sc->scGroupPrev;
+    }
+    sc->scGroup = NULL;
+    sc->scGroupNext = NULL;
+    sc->scGroupPrev = NULL;
+
+    NODE_STATE_ON_CORE(ksReprogram, sc->scCore) = true;
+}
+
+void schedContext_removeGroupMembers(sched_context_t *group)
+{
+    while (group->scGroupMembers != NULL) {
+        schedContext_leaveGroup(group->scGroupMembers);
+    }
+}
+#endif /* CONFIG_SCHED_CONTEXT_GROUPS */
@@ -61,6 +61,9 @@ static exception_t invokeSchedControl_ConfigureFlags(sched_context_t *target, wo
     assert(target->scRefillMax > 0);
     if (target->scTcb) {
         schedContext_resume(target);
+        if (isSchedulable(target->scTcb)) {
+            edfRelease(target->scTcb);
+        }
         if (SMP_TERNARY(core == CURRENT_CPU_INDEX(), true)) {
             if (isRunnable(target->scTcb) && target->scTcb != NODE_STATE(ksCurThread)) {
                 possibleSwitchTo(target->scTcb);
@@ -140,6 +143,16 @@ static exception_t decodeSchedControl_ConfigureFlags(word_t length, cap_t cap, w
         return EXCEPTION_SYSCALL_ERROR;
     }
 
+#if defined(ENABLE_SMP_SUPPORT) && defined(CONFIG_SCHED_CONTEXT_GROUPS)
+    sched_context_t *target = SC_PTR(cap_sched_context_cap_get_capSCPtr(targetCap));
+    if ((target->scGroup != NULL || target->scGroupMembers != NULL) &&
+        cap_sched_control_cap_get_core(cap) != target->scCore) {
+        userError("SchedControl_ConfigureFlags: cannot move a sched context in a group to another core.");
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+#endif
+
     setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
     return invokeSchedControl_ConfigureFlags(SC_PTR(cap_sched_context_cap_get_capSCPtr(targetCap)),
                                              cap_sched_control_cap_get_core(cap),
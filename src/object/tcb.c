@@ -49,6 +49,24 @@ static exception_t checkPrio(prio_t prio, tcb_t *auth)
     return EXCEPTION_NONE;
 }
 
+#ifdef CONFIG_SCHED_EDF
+compile_assert(edf_priority_valid, CONFIG_EDF_PRIORITY > seL4_MinPrio && CONFIG_EDF_PRIORITY < seL4_MaxPrio)
+
+/* The EDF heaps are sized for CONFIG_EDF_MAX_THREADS threads, so refuse to
+ * move more threads to the EDF priority */
+static exception_t checkEDFPrio(tcb_t *tcb, prio_t prio)
+{
+    if (prio == CONFIG_EDF_PRIORITY && tcb->tcbPriority != CONFIG_EDF_PRIORITY &&
+        ksEDFNumThreads >= CONFIG_EDF_MAX_THREADS) {
+        userError("Too many threads at the EDF priority (max %lu).", (unsigned long) CONFIG_EDF_MAX_THREADS);
+        current_syscall_error.type = seL4_IllegalOperation;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    return EXCEPTION_NONE;
+}
+#endif
+
 static inline void addToBitmap(word_t cpu, word_t dom, word_t prio)
 {
     word_t l1index;
@@ -78,6 +96,83 @@ static inline void removeFromBitmap(word_t cpu, word_t dom, word_t prio)
     }
 }
 
+#ifdef CONFIG_SCHED_EDF
+/* Place tcb at index of the heap, or further up if its deadline is earlier
+ * than that of its parents */
+static void edfSiftUp(edf_queue_t *queue, word_t index, tcb_t *tcb)
+{
+    while (index > 0) {
+        word_t parent = (index - 1) / 2;
+        if (queue->heap[parent]->tcbDeadline <= tcb->tcbDeadline) {
+            break;
+        }
+        queue->heap[index] = queue->heap[parent];
+        queue->heap[index]->tcbEDFIndex = index;
+        index = parent;
+    }
+    queue->heap[index] = tcb;
+    tcb->tcbEDFIndex = index;
+}
+
+/* Place tcb at index of the heap, or further down if its deadline is later
+ * than that of its children */
+static void edfSiftDown(edf_queue_t *queue, word_t index, tcb_t *tcb)
+{
+    while (2 * index + 1 < queue->size) {
+        word_t child = 2 * index + 1;
+        if (child + 1 < queue->size &&
+            queue->heap[child + 1]->tcbDeadline < queue->heap[child]->tcbDeadline) {
+            child++;
+        }
+        if (tcb->tcbDeadline <= queue->heap[child]->tcbDeadline) {
+            break;
+        }
+        queue->heap[index] = queue->heap[child];
+        queue->heap[index]->tcbEDFIndex = index;
+        index = child;
+    }
+    queue->heap[index] = tcb;
+    tcb->tcbEDFIndex = index;
+}
+
+static void edfEnqueue(tcb_t *tcb)
+{
+    dom_t dom = tcb->tcbDomain;
+    edf_queue_t *queue = &NODE_STATE_ON_CORE(ksEDFQueues[dom], tcb->tcbAffinity);
+
+    assert(queue->size < CONFIG_EDF_MAX_THREADS);
+    if (queue->size == 0) {
+        addToBitmap(SMP_TERNARY(tcb->tcbAffinity, 0), dom, CONFIG_EDF_PRIORITY);
+    }
+    queue->size++;
+    edfSiftUp(queue, queue->size - 1, tcb);
+}
+
+static void edfDequeue(tcb_t *tcb)
+{
+    dom_t dom = tcb->tcbDomain;
+    edf_queue_t *queue = &NODE_STATE_ON_CORE(ksEDFQueues[dom], tcb->tcbAffinity);
+    word_t index = tcb->tcbEDFIndex;
+    tcb_t *last;
+
+    assert(index < queue->size && queue->heap[index] == tcb);
+    queue->size--;
+    last = queue->heap[queue->size];
+    if (last != tcb) {
+        /* move the last thread into the hole, in whichever direction keeps
+         * the heap ordered */
+        if (index > 0 && last->tcbDeadline < queue->heap[(index - 1) / 2]->tcbDeadline) {
+            edfSiftUp(queue, index, last);
+        } else {
+            edfSiftDown(queue, index, last);
+        }
+    }
+    if (queue->size == 0) {
+        removeFromBitmap(SMP_TERNARY(tcb->tcbAffinity, 0), dom, CONFIG_EDF_PRIORITY);
+    }
+}
+#endif /* CONFIG_SCHED_EDF */
+
 /* Add TCB to the head of a scheduler queue */
 void tcbSchedEnqueue(tcb_t *tcb)
 {
@@ -92,6 +187,14 @@ void tcbSchedEnqueue(tcb_t *tcb)
         prio_t prio;
         word_t idx;
 
+#ifdef CONFIG_SCHED_EDF
+        if (tcb->tcbPriority == CONFIG_EDF_PRIORITY) {
+            edfEnqueue(tcb);
+            thread_state_ptr_set_tcbQueued(&tcb->tcbState, true);
+            return;
+        }
+#endif
+
         dom = tcb->tcbDomain;
         prio = tcb->tcbPriority;
         idx = ready_queues_index(dom, prio);
@@ -127,6 +230,14 @@ void tcbSchedAppend(tcb_t *tcb)
         prio_t prio;
         word_t idx;
 
+#ifdef CONFIG_SCHED_EDF
+        if (tcb->tcbPriority == CONFIG_EDF_PRIORITY) {
+            edfEnqueue(tcb);
+            thread_state_ptr_set_tcbQueued(&tcb->tcbState, true);
+            return;
+        }
+#endif
+
         dom = tcb->tcbDomain;
         prio = tcb->tcbPriority;
         idx = ready_queues_index(dom, prio);
@@ -157,6 +268,14 @@ void tcbSchedDequeue(tcb_t *tcb)
         prio_t prio;
         word_t idx;
 
+#ifdef CONFIG_SCHED_EDF
+        if (tcb->tcbPriority == CONFIG_EDF_PRIORITY) {
+            edfDequeue(tcb);
+            thread_state_ptr_set_tcbQueued(&tcb->tcbState, false);
+            return;
+        }
+#endif
+
         dom = tcb->tcbDomain;
         prio = tcb->tcbPriority;
         idx = ready_queues_index(dom, prio);
@@ -429,9 +548,16 @@ word_t copyMRs(tcb_t *sender, word_t *sendBuf, tcb_t *receiver,
     }
 
     /* Copy out-of-line words */
+#ifdef CONFIG_FAST_MR_COPY
+    if (i < n) {
+        arch_copy_words(&recvBuf[i + 1], &sendBuf[i + 1], n - i);
+        i = n;
+    }
+#else
     for (; i < n; i++) {
         recvBuf[i + 1] = sendBuf[i + 1];
     }
+#endif
 
     return i;
 }
@@ -789,6 +915,75 @@ static exception_t decodeSetTLSBase(cap_t cap, word_t length, word_t *buffer)
     return invokeSetTLSBase(TCB_PTR(cap_thread_cap_get_capTCBPtr(cap)), tls_base);
 }
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+static exception_t invokeSetGrantWindow(tcb_t *thread, word_t vaddr)
+{
+    releaseGrantFrame(thread);
+    *TCB_PTR_GRANT_WINDOW_PTR(thread) = vaddr;
+
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeSetGrantWindow(cap_t cap, word_t length, word_t *buffer)
+{
+    word_t vaddr;
+
+    if (length < 1) {
+        userError("TCB SetGrantWindow: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    vaddr = getSyscallArg(0, buffer);
+    if (vaddr >= USER_TOP) {
+        userError("TCB SetGrantWindow: Window is not a user address.");
+        current_syscall_error.type = seL4_InvalidArgument;
+        current_syscall_error.invalidArgumentNumber = 0;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+    if (!IS_ALIGNED(vaddr, seL4_PageBits)) {
+        userError("TCB SetGrantWindow: Window is not page aligned.");
+        current_syscall_error.type = seL4_AlignmentError;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return invokeSetGrantWindow(TCB_PTR(cap_thread_cap_get_capTCBPtr(cap)), vaddr);
+}
+#endif /* CONFIG_IPC_FRAME_GRANT */
+
+#ifdef CONFIG_FPU_SWITCH_POLICY
+static exception_t invokeSetFPUPolicy(tcb_t *thread, word_t policy)
+{
+    thread->tcbFPUPolicy = policy;
+    thread->tcbFPUUseCount = 0;
+
+    return EXCEPTION_NONE;
+}
+
+static exception_t decodeSetFPUPolicy(cap_t cap, word_t length, word_t *buffer)
+{
+    word_t policy;
+
+    if (length < 1) {
+        userError("TCB SetFPUPolicy: Truncated message.");
+        current_syscall_error.type = seL4_TruncatedMessage;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    policy = getSyscallArg(0, buffer);
+    if (policy > seL4_FPUPolicy_Adaptive) {
+        userError("TCB SetFPUPolicy: Invalid policy %lu.", (long)policy);
+        current_syscall_error.type = seL4_InvalidArgument;
+        current_syscall_error.invalidArgumentNumber = 0;
+        return EXCEPTION_SYSCALL_ERROR;
+    }
+
+    setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
+    return invokeSetFPUPolicy(TCB_PTR(cap_thread_cap_get_capTCBPtr(cap)), policy);
+}
+#endif /* CONFIG_FPU_SWITCH_POLICY */
+
 /* The following functions sit in the syscall error monad, but include the
  * exception cases for the preemptible bottom end, as they call the invoke
  * functions directly.  This is a significant deviation from the Haskell
@@ -865,6 +1060,11 @@ exception_t decodeTCBInvocation(word_t invLabel, word_t length, cap_t cap,
         return decodeSetEPTRoot(cap);
 #endif
 
+#ifdef CONFIG_XSAVE_THREAD_FEATURES
+    case TCBSetXSaveFeatures:
+        return decodeSetXSaveFeatures(cap, length, buffer);
+#endif
+
 #ifdef CONFIG_HARDWARE_DEBUG_API
     case TCBConfigureSingleStepping:
         return decodeConfigureSingleStepping(cap, call, buffer);
@@ -882,6 +1082,16 @@ exception_t decodeTCBInvocation(word_t invLabel, word_t length, cap_t cap,
     case TCBSetTLSBase:
         return decodeSetTLSBase(cap, length, buffer);
 
+#ifdef CONFIG_IPC_FRAME_GRANT
+    case TCBSetGrantWindow:
+        return decodeSetGrantWindow(cap, length, buffer);
+#endif
+
+#ifdef CONFIG_FPU_SWITCH_POLICY
+    case TCBSetFPUPolicy:
+        return decodeSetFPUPolicy(cap, length, buffer);
+#endif
+
     default:
         /* Haskell: "throw IllegalOperation" */
         userError("TCB: Illegal operation.");
@@ -1188,6 +1398,13 @@ exception_t decodeSetPriority(cap_t cap, word_t length, word_t *buffer)
         return status;
     }
 
+#ifdef CONFIG_SCHED_EDF
+    status = checkEDFPrio(TCB_PTR(cap_thread_cap_get_capTCBPtr(cap)), newPrio);
+    if (status != EXCEPTION_NONE) {
+        return status;
+    }
+#endif
+
     setThreadState(NODE_STATE(ksCurThread), ThreadState_Restart);
 #ifdef CONFIG_KERNEL_MCS
     return invokeTCB_ThreadControlSched(
@@ -1327,6 +1544,13 @@ exception_t decodeSetSchedParams(cap_t cap, word_t length, word_t *buffer)
         return status;
     }
 
+#ifdef CONFIG_SCHED_EDF
+    status = checkEDFPrio(TCB_PTR(cap_thread_cap_get_capTCBPtr(cap)), newPrio);
+    if (status != EXCEPTION_NONE) {
+        return status;
+    }
+#endif
+
 #ifdef CONFIG_KERNEL_MCS
     tcb_t *tcb = TCB_PTR(cap_thread_cap_get_capTCBPtr(cap));
     sched_context_t *sc = NULL;
@@ -1343,6 +1567,13 @@ exception_t decodeSetSchedParams(cap_t cap, word_t length, word_t *buffer)
             current_syscall_error.type = seL4_IllegalOperation;
             return EXCEPTION_SYSCALL_ERROR;
         }
+#ifdef CONFIG_SCHED_CONTEXT_GROUPS
+        if (sc->scGroupMembers != NULL) {
+            userError("TCB Configure: sched context is a group.");
+            current_syscall_error.type = seL4_IllegalOperation;
+            return EXCEPTION_SYSCALL_ERROR;
+        }
+#endif
         if (isBlocked(tcb) && !sc_released(sc)) {
             userError("TCB Configure: tcb blocked and scheduling context not schedulable.");
             current_syscall_error.type = seL4_IllegalOperation;
@@ -30,12 +30,20 @@
 #define FEADDR_REG  0x40
 #define FEUADDR_REG 0x44
 #define CAP_REG     0x08
+#define IQH_REG     0x80
+#define IQT_REG     0x88
+#define IQA_REG     0x90
+#define IRTA_REG    0xB8
 
 /* Bit Positions within Registers */
 #define SRTP        30  /* Set Root Table Pointer */
 #define RTPS        30  /* Root Table Pointer Status */
 #define TE          31  /* Translation Enable */
 #define TES         31  /* Translation Enable Status */
+#define QIE         26  /* Queued Invalidation Enable */
+#define IRE         25  /* Interrupt Remapping Enable */
+#define SIRTP       24  /* Set Interrupt Remap Table Pointer */
+#define CFI         23  /* Compatibility Format Interrupt */
 
 /* ICC is 63rd bit in CCMD_REG, but since we will be
  * accessing this register as 4 byte word, ICC becomes
@@ -88,6 +96,30 @@
 
 #define N_VTD_CONTEXTS 256
 
+/* Extended Capability Register bits */
+#define ECAP_QI     1   /* Queued Invalidation support */
+#define ECAP_IR     3   /* Interrupt Remapping support */
+#define ECAP_EIM    4   /* Extended Interrupt Mode (x2APIC) support */
+
+#define IRTA_EIME   11  /* Extended Interrupt Mode Enable */
+
+/* Invalidation descriptors, see section 6.5.2 of the VT-d specification */
+#define N_VTD_INV_DESCRIPTORS     (BIT(VTD_IQ_SIZE_BITS) / (2 * sizeof(uint64_t)))
+#define QI_CC_TYPE                0x1
+#define QI_IOTLB_TYPE             0x2
+#define QI_IEC_TYPE               0x4
+#define QI_WAIT_TYPE              0x5
+#define QI_GLOBAL_GRANULARITY     BIT(4)
+#define QI_IOTLB_DRAIN_WRITES     BIT(6)
+#define QI_IOTLB_DRAIN_READS      BIT(7)
+#define QI_IEC_INDEX_GRANULARITY  BIT(4)
+#define QI_IEC_INDEX              32
+#define QI_WAIT_STATUS_WRITE      BIT(5)
+#define QI_WAIT_STATUS_DATA       32
+
+/* SID qualifier: verify all 16 bits of the requester id */
+#define IRTE_SVT_VERIFY_SID 1
+
 typedef uint32_t drhu_id_t;
 
 static inline uint32_t vtd_read32(drhu_id_t drhu_id, uint32_t offset)
@@ -111,6 +143,71 @@ static inline void vtd_write64(drhu_id_t drhu_id, uint32_t offset, uint64_t valu
     *(volatile uint64_t *)(PPTR_DRHU_START + (drhu_id << PAGE_BITS) + offset) = value;
 }
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+/* Written to by the IOMMU once all preceding invalidation descriptors have completed */
+static volatile uint32_t vtd_inv_wait_status;
+
+/* Physical APIC ID of the core that remapped MSIs are delivered to */
+static cpu_id_t vtd_irq_target_cpu = 0;
+
+static void vtd_queue_inv_descriptor(drhu_id_t drhu_id, uint64_t lo, uint64_t hi)
+{
+    uint32_t tail = x86KSvtdInvQueueTail[drhu_id];
+    uint64_t *desc = x86KSvtdInvQueue[drhu_id] + 2 * tail;
+
+    desc[0] = lo;
+    desc[1] = hi;
+    flushCacheRange(desc, 4);
+    x86KSvtdInvQueueTail[drhu_id] = (tail + 1) % N_VTD_INV_DESCRIPTORS;
+}
+
+/* Submits a single invalidation descriptor and waits for it to complete. As
+ * every submission is waited for the queue never holds more than two entries */
+static void vtd_invalidate(drhu_id_t drhu_id, uint64_t lo, uint64_t hi)
+{
+    vtd_inv_wait_status = 0;
+    vtd_queue_inv_descriptor(drhu_id, lo, hi);
+    vtd_queue_inv_descriptor(drhu_id,
+                             QI_WAIT_TYPE | QI_WAIT_STATUS_WRITE | ((uint64_t)1 << QI_WAIT_STATUS_DATA),
+                             kpptr_to_paddr((void *)&vtd_inv_wait_status));
+    vtd_write64(drhu_id, IQT_REG, (uint64_t)x86KSvtdInvQueueTail[drhu_id] << 4);
+    while (vtd_inv_wait_status == 0);
+}
+
+static void invalidate_interrupt_entry(word_t index)
+{
+    for (drhu_id_t i = 0; i < x86KSnumDrhu; i++) {
+        vtd_invalidate(i, QI_IEC_TYPE | QI_IEC_INDEX_GRANULARITY | ((uint64_t)index << QI_IEC_INDEX), 0);
+    }
+}
+
+/* Replaces an interrupt remapping entry. The word holding the present bit is
+ * written last so that the IOMMU never fetches a partially updated entry */
+static void vtd_update_irte(word_t index, vtd_irte_t entry)
+{
+    vtd_irte_t *irte = x86KSvtdIRT + index;
+
+    assert(index < N_VTD_IRTES);
+    irte->words[0] = 0;
+    for (word_t i = ARRAY_SIZE(irte->words) - 1; i > 0; i--) {
+        irte->words[i] = entry.words[i];
+    }
+    x86_mfence();
+    irte->words[0] = entry.words[0];
+    flushCacheRange(irte, VTD_IRTE_SIZE_BITS);
+    invalidate_interrupt_entry(index);
+}
+
+/* Issues a command whose completion is reported by the matching status bit becoming set */
+static void vtd_set_command(drhu_id_t drhu_id, uint32_t bit)
+{
+    /* The one-shot commands read back as status and must not be issued again */
+    uint32_t status = vtd_read32(drhu_id, GSTS_REG) & ~(BIT(SRTP) | BIT(WBF) | BIT(SIRTP));
+    vtd_write32(drhu_id, GCMD_REG, status | BIT(bit));
+    while (!((vtd_read32(drhu_id, GSTS_REG) >> bit) & 1));
+}
+#endif /* CONFIG_IOMMU_INTERRUPT_REMAPPING */
+
 static inline uint32_t get_ivo(drhu_id_t drhu_id)
 {
     return ((vtd_read32(drhu_id, ECAP_REG) >> 8) & IVO_MASK) * 16;
@@ -142,6 +239,12 @@ void invalidate_context_cache(void)
 
     drhu_id_t i;
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+    /* Once queued invalidation is enabled the register interface must not be used */
+    for (i = 0; i < x86KSnumDrhu; i++) {
+        vtd_invalidate(i, QI_CC_TYPE | QI_GLOBAL_GRANULARITY, 0);
+    }
+#else
     for (i = 0; i < x86KSnumDrhu; i++) {
         /* Wait till ICC bit is clear */
         uint64_t ccmd = 0;
@@ -158,6 +261,7 @@ void invalidate_context_cache(void)
         /* Wait for the invalidation to complete */
         while ((vtd_read64(i, CCMD_REG) >> ICC) & 1);
     }
+#endif
 }
 
 void invalidate_iotlb(void)
@@ -171,10 +275,16 @@ void invalidate_iotlb(void)
      *    device.
      */
 
+    drhu_id_t i;
+
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+    for (i = 0; i < x86KSnumDrhu; i++) {
+        vtd_invalidate(i, QI_IOTLB_TYPE | QI_GLOBAL_GRANULARITY | QI_IOTLB_DRAIN_READS | QI_IOTLB_DRAIN_WRITES, 0);
+    }
+#else
     uint8_t   invalidate_command = IOTLB_GLOBAL_INVALIDATE;
     uint32_t  iotlb_reg_upper;
     uint32_t  ivo_offset;
-    drhu_id_t i;
 
     for (i = 0; i < x86KSnumDrhu; i++) {
         ivo_offset = get_ivo(i);
@@ -197,6 +307,7 @@ void invalidate_iotlb(void)
         /* Wait for the invalidation to complete */
         while ((vtd_read32(i, ivo_offset + IOTLB_REG + 4) >> IVT) & 1);
     }
+#endif
 }
 
 static void vtd_clear_fault(drhu_id_t i, word_t fr_reg)
@@ -265,6 +376,79 @@ void vtd_handle_fault(void)
     }
 }
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+void vtd_map_msi(word_t index, uint32_t source_id, word_t vector)
+{
+    word_t dst = vtd_irq_target_cpu;
+
+    /* In xAPIC mode the destination APIC ID sits in bits 15:8 of the field */
+    if (!config_set(CONFIG_X2APIC)) {
+        dst <<= 8;
+    }
+
+    vtd_irte_t entry = vtd_irte_new(
+                IRTE_SVT_VERIFY_SID, /* Source Validation Type  */
+                0,                   /* Source-id Qualifier     */
+                source_id,           /* Source Identifier       */
+                dst,                 /* Destination ID          */
+                vector,              /* Vector                  */
+                0,                   /* Remapped format         */
+                0,                   /* Fixed delivery mode     */
+                0,                   /* Edge triggered          */
+                0,                   /* Redirection hint        */
+                0,                   /* Physical destination    */
+                0,                   /* Report faults           */
+                true);               /* Present                 */
+
+    vtd_update_irte(index, entry);
+}
+
+void vtd_unmap_msi(word_t index)
+{
+    vtd_irte_t empty = { .words = { 0 } };
+
+    vtd_update_irte(index, empty);
+}
+
+#ifdef CONFIG_VTX_POSTED_INTERRUPTS
+compile_assert(vtd_posted_irte_size_sane, sizeof(vtd_posted_irte_t) == sizeof(vtd_irte_t))
+
+void vtd_map_posted_msi(word_t index, uint32_t source_id, word_t vector, paddr_t pi_desc)
+{
+    /* The descriptor is 64 byte aligned, so only bits 63:6 of its address are stored */
+    vtd_posted_irte_t entry = vtd_posted_irte_new(
+                                  pi_desc >> 32,             /* Descriptor address high  */
+                                  IRTE_SVT_VERIFY_SID,       /* Source Validation Type   */
+                                  0,                         /* Source-id Qualifier      */
+                                  source_id,                 /* Source Identifier        */
+                                  (pi_desc >> 6) & MASK(26), /* Descriptor address low   */
+                                  vector,                    /* Guest vector             */
+                                  1,                         /* Posted format            */
+                                  0,                         /* Not urgent               */
+                                  0,                         /* Report faults            */
+                                  true);                     /* Present                  */
+
+    vtd_irte_t irte;
+
+    /* both formats share the same table */
+    memcpy(&irte, &entry, sizeof(irte));
+    vtd_update_irte(index, irte);
+}
+
+void vtd_unmap_posted_msis(paddr_t pi_desc)
+{
+    for (word_t i = 0; i < N_VTD_IRTES; i++) {
+        vtd_posted_irte_t *irte = (vtd_posted_irte_t *)(x86KSvtdIRT + i);
+        if (vtd_posted_irte_ptr_get_present(irte) && vtd_posted_irte_ptr_get_im(irte) &&
+            vtd_posted_irte_ptr_get_pda_high(irte) == pi_desc >> 32 &&
+            vtd_posted_irte_ptr_get_pda_low(irte) == ((pi_desc >> 6) & MASK(26))) {
+            vtd_unmap_msi(i);
+        }
+    }
+}
+#endif /* CONFIG_VTX_POSTED_INTERRUPTS */
+#endif /* CONFIG_IOMMU_INTERRUPT_REMAPPING */
+
 BOOT_CODE word_t vtd_get_n_paging(acpi_rmrr_list_t *rmrr_list)
 {
     if (x86KSnumDrhu == 0) {
@@ -275,6 +459,10 @@ BOOT_CODE word_t vtd_get_n_paging(acpi_rmrr_list_t *rmrr_list)
     word_t size = 1; /* one for the root table */
     size += N_VTD_CONTEXTS; /* one for each context */
     size += rmrr_list->num; /* one for each device */
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+    size += 1; /* one for the interrupt remapping table */
+    size += x86KSnumDrhu; /* one invalidation queue for each IOMMU */
+#endif
 
     if (rmrr_list->num == 0) {
         return size;
@@ -411,6 +599,15 @@ BOOT_CODE static bool_t vtd_enable(cpu_id_t cpu_id)
          * RTPS bit from GSTS_REG
          */
         while (!((vtd_read32(i, GSTS_REG) >> RTPS) & 1));
+
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+        /* The interrupt entry cache can only be invalidated through the
+         * invalidation queue, so switch to it before anything is flushed */
+        x86KSvtdInvQueueTail[i] = 0;
+        vtd_write64(i, IQT_REG, 0);
+        vtd_write64(i, IQA_REG, pptr_to_paddr(x86KSvtdInvQueue[i]));
+        vtd_set_command(i, QIE);
+#endif
     }
 
     /* Globally invalidate context cache of all IOMMUs */
@@ -419,6 +616,24 @@ BOOT_CODE static bool_t vtd_enable(cpu_id_t cpu_id)
     /* Globally invalidate IOTLB of all IOMMUs */
     invalidate_iotlb();
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+    for (i = 0; i < x86KSnumDrhu; i++) {
+        uint64_t irta = pptr_to_paddr(x86KSvtdIRT) | (VTD_IRT_BITS - 1);
+        if (config_set(CONFIG_X2APIC)) {
+            irta |= BIT(IRTA_EIME);
+        }
+        vtd_write64(i, IRTA_REG, irta);
+        vtd_set_command(i, SIRTP);
+        vtd_invalidate(i, QI_IEC_TYPE, 0);
+
+        /* IOAPIC pins are still routed in the compatibility format */
+        vtd_set_command(i, CFI);
+        vtd_set_command(i, IRE);
+        printf("IOMMU 0x%x: interrupt remapping enabled\n", i);
+    }
+    vtd_irq_target_cpu = cpu_id;
+#endif
+
     for (i = 0; i < x86KSnumDrhu; i++) {
         uint32_t data, addr;
 
@@ -470,6 +685,14 @@ BOOT_CODE bool_t vtd_init_num_iopts(uint32_t num_drhu)
     /* Start the number of domains at 16 bits */
     uint32_t  num_domain_id_bits = 16;
     for (drhu_id_t i = 0; i < x86KSnumDrhu; i++) {
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+        uint32_t ecap = vtd_read32(i, ECAP_REG);
+        if (!(ecap & BIT(ECAP_QI)) || !(ecap & BIT(ECAP_IR)) ||
+            (config_set(CONFIG_X2APIC) && !(ecap & BIT(ECAP_EIM)))) {
+            printf("IOMMU 0x%x: interrupt remapping not supported\n", i);
+            return false;
+        }
+#endif
         uint32_t bits_supported = 4 + 2 * (vtd_read32(i, CAP_REG) & 7);
         aw_bitmask &= vtd_read32(i, CAP_REG) >> SAGAW;
         printf("IOMMU 0x%x: %d-bit domain IDs supported\n", i, bits_supported);
@@ -528,6 +751,14 @@ BOOT_CODE bool_t vtd_init(cpu_id_t  cpu_id, acpi_rmrr_list_t *rmrr_list)
 
     flushCacheRange(x86KSvtdRootTable, VTD_RT_SIZE_BITS);
 
+#ifdef CONFIG_IOMMU_INTERRUPT_REMAPPING
+    x86KSvtdIRT = (vtd_irte_t *) it_alloc_paging();
+    flushCacheRange(x86KSvtdIRT, VTD_IRT_SIZE_BITS);
+    for (drhu_id_t i = 0; i < x86KSnumDrhu; i++) {
+        x86KSvtdInvQueue[i] = (uint64_t *) it_alloc_paging();
+    }
+#endif
+
     if (!vtd_enable(cpu_id)) {
         return false;
     }